@@ -0,0 +1,108 @@
+/**
+Software License Agreement (BSD)
+
+\file      crc_benchmark.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * CRC-16 (0x1021) micro-benchmark: slicing-by-8 crc16() against the original
+ * byte-at-a-time loop, over frame-sized buffers from the minimum Horizon frame
+ * up to the maximum. Before timing anything, each size is checked bit-for-bit
+ * against the reference over a spread of random inputs and seeds; a mismatch
+ * fails the benchmark.
+ *
+ *   ./husky_base_benchmarks --benchmark_filter=Crc
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "husky_base/horizon_legacy/crc.h"
+#include "husky_base/horizon_legacy/Message.h"
+
+namespace
+{
+
+  const int CRC_INIT = 0xFFFF;
+
+  std::vector<uint8_t> randomBytes(size_t len, unsigned seed)
+  {
+    std::vector<uint8_t> bytes(len);
+    srand(seed);
+    for (size_t i = 0; i < len; ++i)
+    {
+      bytes[i] = static_cast<uint8_t>(rand());
+    }
+    return bytes;
+  }
+
+  bool matchesReference(size_t len)
+  {
+    for (unsigned seed = 1; seed <= 64; ++seed)
+    {
+      std::vector<uint8_t> bytes = randomBytes(len, seed);
+      int init = (seed & 1) ? CRC_INIT : static_cast<int>(seed * 2654435761u & 0xFFFF);
+      if (crc16(len, init, bytes.data()) != crc16_bytewise(len, init, bytes.data()))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void frameSizes(benchmark::internal::Benchmark *bench)
+  {
+    // Minimum frame, typical data frames (encoders, system status) and the maximum
+    bench->Arg(clearpath::Message::MIN_MSG_LENGTH - 2)->Arg(25)->Arg(46)->Arg(clearpath::Message::MAX_MSG_LENGTH - 2);
+  }
+
+}  // namespace
+
+static void BM_CrcBytewise(benchmark::State &state)
+{
+  std::vector<uint8_t> bytes = randomBytes(state.range(0), 7);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(crc16_bytewise(bytes.size(), CRC_INIT, bytes.data()));
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_CrcBytewise)->Apply(frameSizes);
+
+static void BM_CrcSliceBy8(benchmark::State &state)
+{
+  if (!matchesReference(state.range(0)))
+  {
+    state.SkipWithError("crc16() does not match the byte-wise reference");
+    return;
+  }
+
+  std::vector<uint8_t> bytes = randomBytes(state.range(0), 7);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(crc16(bytes.size(), CRC_INIT, bytes.data()));
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_CrcSliceBy8)->Apply(frameSizes);
@@ -0,0 +1,225 @@
+/**
+Software License Agreement (BSD)
+
+\file      emulator_benchmark.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * End-to-end benchmarks against the MCU emulator.
+ *
+ * Everything above the serial port is the production code: the wrapper, the
+ * Transport and the frame codecs talk to a McuEmulator on a pseudo-terminal,
+ * optionally with latency, drops or corruption injected. Times are wall clock,
+ * p50_us / p99_us / max_us come from a LatencyHistogram over all iterations.
+ *
+ *   cmake -DHUSKY_BASE_BUILD_BENCHMARKS=ON ... && ./husky_base_benchmarks --benchmark_filter=Emulator
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "McuEmulator.h"
+#include "husky_base/horizon_legacy_wrapper.h"
+#include "husky_base/horizon_legacy/clearpath.h"
+
+namespace
+{
+
+  const double REQUEST_TIMEOUT = 1.0;
+
+  /** One emulator and one connection for the whole run, the wrapper's link is process wide */
+  struct EmulatedLink
+  {
+    clearpath::McuEmulator emulator;
+    bool up;
+
+    EmulatedLink() :
+        up(false)
+    {
+      if (emulator.start())
+      {
+        up = horizon_legacy::connect(emulator.portName());
+      }
+    }
+
+    static EmulatedLink &instance()
+    {
+      static EmulatedLink link;
+      return link;
+    }
+
+    /** Injected faults last for the lifetime of one benchmark */
+    static bool begin(benchmark::State &state, const clearpath::McuEmulator::Faults &faults)
+    {
+      EmulatedLink &link = instance();
+      if (!link.up)
+      {
+        state.SkipWithError("MCU emulator not reachable");
+        return false;
+      }
+      link.emulator.setFaults(faults);
+      return true;
+    }
+
+    static void end()
+    {
+      instance().emulator.setFaults(clearpath::McuEmulator::Faults());
+    }
+  };
+
+  void reportLatency(benchmark::State &state, clearpath::LatencyHistogram &histogram)
+  {
+    clearpath::LatencyHistogram::Snapshot snapshot;
+    histogram.collect(snapshot);
+    state.counters["p50_us"] = snapshot.percentile(0.5);
+    state.counters["p99_us"] = snapshot.percentile(0.99);
+    state.counters["max_us"] = static_cast<double>(snapshot.max_us);
+  }
+
+}  // namespace
+
+/** One request/ack/data round trip, argument is the injected one-way latency in us */
+static void BM_EmulatorRequest(benchmark::State &state)
+{
+  clearpath::McuEmulator::Faults faults;
+  faults.latency = state.range(0) * 1e-6;
+  if (!EmulatedLink::begin(state, faults))
+  {
+    return;
+  }
+  clearpath::LatencyHistogram histogram;
+  int64_t missed = 0;
+
+  for (auto _ : state)
+  {
+    clearpath::LatencyHistogram::Scope timed(histogram);
+    if (!horizon_legacy::Channel<clearpath::DataEncoders>::requestData(REQUEST_TIMEOUT))
+    {
+      ++missed;
+    }
+  }
+  EmulatedLink::end();
+  reportLatency(state, histogram);
+  state.counters["missed"] = static_cast<double>(missed);
+}
+BENCHMARK(BM_EmulatorRequest)->Arg(0)->Arg(500)->Arg(2000)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/** The three status requests HuskyHardware makes, pipelined through requestMany() */
+static void BM_EmulatorRequestMany(benchmark::State &state)
+{
+  clearpath::McuEmulator::Faults faults;
+  faults.latency = state.range(0) * 1e-6;
+  if (!EmulatedLink::begin(state, faults))
+  {
+    return;
+  }
+  clearpath::LatencyHistogram histogram;
+
+  for (auto _ : state)
+  {
+    clearpath::LatencyHistogram::Scope timed(histogram);
+    benchmark::DoNotOptimize(horizon_legacy::requestMany<clearpath::DataSafetySystemStatus,
+                             clearpath::DataPowerSystem, clearpath::DataSystemStatus>(REQUEST_TIMEOUT));
+  }
+  EmulatedLink::end();
+  reportLatency(state, histogram);
+}
+BENCHMARK(BM_EmulatorRequestMany)->Arg(0)->Arg(2000)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/**
+ * Requests over a lossy link, argument is the drop and corruption rate in percent.
+ * Every loss costs a retry timeout, so this shows the tail the control loop sees.
+ */
+static void BM_EmulatorLossyRequest(benchmark::State &state)
+{
+  clearpath::McuEmulator::Faults faults;
+  faults.drop_rate = state.range(0) / 100.0;
+  faults.corrupt_rate = state.range(0) / 100.0;
+  if (!EmulatedLink::begin(state, faults))
+  {
+    return;
+  }
+  clearpath::Transport &transport = clearpath::Transport::instance();
+  unsigned long retransmits = transport.getCounter(clearpath::Transport::RETRANSMITS);
+  clearpath::LatencyHistogram histogram;
+  int64_t missed = 0;
+
+  for (auto _ : state)
+  {
+    clearpath::LatencyHistogram::Scope timed(histogram);
+    if (!horizon_legacy::Channel<clearpath::DataEncoders>::requestData(REQUEST_TIMEOUT))
+    {
+      ++missed;
+    }
+  }
+  EmulatedLink::end();
+  reportLatency(state, histogram);
+  state.counters["missed"] = static_cast<double>(missed);
+  state.counters["retransmits"] =
+    static_cast<double>(transport.getCounter(clearpath::Transport::RETRANSMITS) - retransmits);
+}
+BENCHMARK(BM_EmulatorLossyRequest)->Arg(1)->Arg(5)->Iterations(200)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/**
+ * Encoder subscription at the argument's frequency. items_per_second is the
+ * delivered rate, the latency counters are the gaps between samples.
+ */
+static void BM_EmulatorSubscription(benchmark::State &state)
+{
+  if (!EmulatedLink::begin(state, clearpath::McuEmulator::Faults()))
+  {
+    return;
+  }
+  clearpath::Transport &transport = clearpath::Transport::instance();
+  horizon_legacy::Channel<clearpath::DataEncoders>::subscribe(static_cast<double>(state.range(0)));
+  transport.flush(clearpath::DataEncoders::getTypeID());
+
+  clearpath::LatencyHistogram gaps;
+  int64_t delivered = 0;
+  std::chrono::steady_clock::time_point last = std::chrono::steady_clock::time_point();
+
+  for (auto _ : state)
+  {
+    clearpath::Message *msg = 0;
+    if (transport.tryWaitNext(clearpath::DataEncoders::getTypeID(), REQUEST_TIMEOUT, &msg) !=
+        clearpath::TRANSFER_OK || !msg)
+    {
+      state.SkipWithError("Subscription stalled");
+      break;
+    }
+    delete msg;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (last.time_since_epoch().count() != 0)
+    {
+      gaps.record(now - last);
+    }
+    last = now;
+    ++delivered;
+  }
+
+  horizon_legacy::Channel<clearpath::DataEncoders>::unsubscribe();
+  EmulatedLink::end();
+  reportLatency(state, gaps);
+  state.SetItemsProcessed(delivered);
+}
+BENCHMARK(BM_EmulatorSubscription)->Arg(10)->Arg(50)->Arg(200)->Arg(1000)->MinTime(1.0)->UseRealTime();
@@ -0,0 +1,207 @@
+/**
+Software License Agreement (BSD)
+
+\file      hardware_benchmark.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Control loop benchmark: runs HuskyHardware read()/write() at a fixed rate
+ * against the MCU emulator, the way the controller manager would, and reports
+ * how long each call takes and how far each tick lands from its schedule.
+ *
+ *   cmake -DHUSKY_BASE_BUILD_BENCHMARKS=ON ... && ./husky_hardware_benchmark --rate 50 --seconds 20
+ *
+ * Options: --rate HZ, --seconds S, --streaming HZ (0 polls), --rx-thread 0|1,
+ * --velocity differential_speed|encoder_speed|encoder_travel, --filter difference|alpha_beta,
+ * --keepalive S (0 sends every command), --sweep 0|1 (0 holds a constant speed),
+ * --latency S, --jitter S, --drop P, --corrupt P for the emulated MCU.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "McuEmulator.h"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "husky_base/husky_hardware.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+
+  hardware_interface::ComponentInfo wheel(const std::string &name)
+  {
+    hardware_interface::ComponentInfo joint;
+    joint.name = name;
+    joint.type = "joint";
+    hardware_interface::InterfaceInfo interface;
+    interface.name = hardware_interface::HW_IF_VELOCITY;
+    joint.command_interfaces.push_back(interface);
+    interface.name = hardware_interface::HW_IF_POSITION;
+    joint.state_interfaces.push_back(interface);
+    interface.name = hardware_interface::HW_IF_VELOCITY;
+    joint.state_interfaces.push_back(interface);
+    return joint;
+  }
+
+  void report(const char *what, clearpath::LatencyHistogram &histogram)
+  {
+    clearpath::LatencyHistogram::Snapshot snapshot;
+    histogram.collect(snapshot);
+    printf("%-14s n %8lu  mean %9.1f us  p50 %9.0f us  p99 %9.0f us  p99.9 %9.0f us  max %9lu us\n",
+           what, static_cast<unsigned long>(snapshot.count()), snapshot.mean(), snapshot.percentile(0.5),
+           snapshot.percentile(0.99), snapshot.percentile(0.999), static_cast<unsigned long>(snapshot.max_us));
+  }
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  double rate = 50.0;
+  double seconds = 10.0;
+  const char *streaming = "0";
+  const char *rx_thread = "false";
+  const char *velocity = "differential_speed";
+  const char *filter = "difference";
+  const char *keepalive = "0";
+  bool sweep = true;
+  clearpath::McuEmulator::Faults faults;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const char *value = argv[i + 1];
+    if (!strcmp(argv[i], "--rate")) { rate = atof(value); }
+    else if (!strcmp(argv[i], "--seconds")) { seconds = atof(value); }
+    else if (!strcmp(argv[i], "--streaming")) { streaming = value; }
+    else if (!strcmp(argv[i], "--rx-thread")) { rx_thread = atoi(value) ? "true" : "false"; }
+    else if (!strcmp(argv[i], "--velocity")) { velocity = value; }
+    else if (!strcmp(argv[i], "--filter")) { filter = value; }
+    else if (!strcmp(argv[i], "--keepalive")) { keepalive = value; }
+    else if (!strcmp(argv[i], "--sweep")) { sweep = atoi(value) != 0; }
+    else if (!strcmp(argv[i], "--latency")) { faults.latency = atof(value); }
+    else if (!strcmp(argv[i], "--jitter")) { faults.jitter = atof(value); }
+    else if (!strcmp(argv[i], "--drop")) { faults.drop_rate = atof(value); }
+    else if (!strcmp(argv[i], "--corrupt")) { faults.corrupt_rate = atof(value); }
+    else
+    {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  clearpath::McuEmulator emulator;
+  emulator.setFaults(faults);
+  if (!emulator.start())
+  {
+    perror("openpty");
+    return 1;
+  }
+
+  rclcpp::init(argc, argv);
+
+  // What the husky_description xacro hands the plugin
+  hardware_interface::HardwareInfo info;
+  info.name = "husky_base";
+  info.hardware_class_type = "husky_base/HuskyHardware";
+  info.hardware_parameters["serial_port"] = emulator.portName();
+  info.hardware_parameters["wheel_diameter"] = "0.3302";
+  info.hardware_parameters["max_accel"] = "5.0";
+  info.hardware_parameters["max_speed"] = "1.0";
+  info.hardware_parameters["polling_timeout"] = "0.1";
+  info.hardware_parameters["control_frequency"] = std::to_string(rate);
+  info.hardware_parameters["streaming_frequency"] = streaming;
+  info.hardware_parameters["rx_thread"] = rx_thread;
+  info.hardware_parameters["velocity_source"] = velocity;
+  info.hardware_parameters["velocity_filter"] = filter;
+  info.hardware_parameters["command_tolerance"] = "0.001";
+  info.hardware_parameters["command_keepalive"] = keepalive;
+  info.joints.push_back(wheel("front_left_wheel_joint"));
+  info.joints.push_back(wheel("front_right_wheel_joint"));
+  info.joints.push_back(wheel("rear_left_wheel_joint"));
+  info.joints.push_back(wheel("rear_right_wheel_joint"));
+
+  husky_base::HuskyHardware hardware;
+  if (hardware.configure(info) != hardware_interface::return_type::OK ||
+      hardware.start() != hardware_interface::return_type::OK)
+  {
+    fprintf(stderr, "HuskyHardware failed to start on %s\n", emulator.portName());
+    rclcpp::shutdown();
+    return 1;
+  }
+  std::vector<hardware_interface::CommandInterface> commands = hardware.export_command_interfaces();
+  std::vector<hardware_interface::StateInterface> states = hardware.export_state_interfaces();
+  // Left front wheel velocity, compared against the command the emulator is running
+  const hardware_interface::StateInterface &wheel_velocity = states[1];
+  double commanded = 0.0, velocity_error = 0.0;
+
+  clearpath::LatencyHistogram read_time, write_time, lateness;
+  unsigned long errors = 0;
+  const std::chrono::steady_clock::duration period =
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+  const long ticks = static_cast<long>(seconds * rate);
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + period;
+
+  for (long tick = 0; tick < ticks; ++tick)
+  {
+    std::this_thread::sleep_until(next);
+    std::chrono::steady_clock::time_point woke = std::chrono::steady_clock::now();
+    lateness.record(woke - next);
+    next += period;
+
+    // Slow sine sweep, so the speed command actually changes every tick; or a steady cruise
+    double speed = sweep ? 5.0 * std::sin(tick / rate) : 2.0;
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+      commands[i].set_value(speed);
+    }
+
+    {
+      clearpath::LatencyHistogram::Scope timed(read_time);
+      errors += hardware.read() != hardware_interface::return_type::OK;
+    }
+    velocity_error += std::abs(wheel_velocity.get_value() - commanded);
+    commanded = speed;
+    {
+      clearpath::LatencyHistogram::Scope timed(write_time);
+      errors += hardware.write() != hardware_interface::return_type::OK;
+    }
+  }
+
+  hardware.stop();
+
+  printf("%ld ticks at %.1f Hz, %lu errors\n", ticks, rate, errors);
+  report("read()", read_time);
+  report("write()", write_time);
+  report("tick lateness", lateness);
+  printf("Velocity (%s): mean error %.3f rad/s against the previous tick's command\n",
+         velocity, velocity_error / ticks);
+  clearpath::McuEmulator::Stats stats = emulator.stats();
+  printf("Emulator: frames received %lu, acks sent %lu, data sent %lu, dropped %lu, corrupted %lu\n",
+         stats.frames_received, stats.acks_sent, stats.data_sent, stats.dropped, stats.corrupted);
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,112 @@
+/**
+Software License Agreement (BSD)
+
+\file      logger_benchmark.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Cost of one log call on the calling thread: a formatted entry written
+ * through the Logger's stream, against CPR_ALOG handing a binary record to
+ * the drain thread, and CPR_ALOG filtered out by level. The async case stops
+ * the clock every half ring to let the drain thread catch up, so it measures
+ * the push and not the drop path; any drops are reported as a counter.
+ *
+ *   ./husky_base_benchmarks --benchmark_filter=Log
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <thread>
+
+#include "husky_base/horizon_legacy/Logger.h"
+
+namespace
+{
+
+  void discard(clearpath::Logger::logLevels, const char *, int, const char *)
+  {
+  }
+
+}  // namespace
+
+static void BM_LogStream(benchmark::State &state)
+{
+  clearpath::Logger &logger = clearpath::Logger::instance();
+  std::ofstream null_stream("/dev/null");
+  logger.setAsync(false);
+  logger.setStream(&null_stream);
+  logger.setLevel(clearpath::Logger::DETAIL);
+
+  int i = 0;
+  for (auto _ : state)
+  {
+    CPR_DTL() << "Received linear speed information (L: " << 0.25 * i << ", R: " << 0.5 * i << ")" << std::endl;
+    ++i;
+  }
+
+  logger.setStream(&std::cerr);
+  logger.setLevel(clearpath::Logger::WARNING);
+}
+BENCHMARK(BM_LogStream);
+
+static void BM_LogAsync(benchmark::State &state)
+{
+  clearpath::Logger &logger = clearpath::Logger::instance();
+  logger.setSink(discard);
+  logger.setLevel(clearpath::Logger::DETAIL);
+  logger.setAsync(true);
+  unsigned long dropped = logger.droppedRecords();
+
+  int i = 0;
+  for (auto _ : state)
+  {
+    CPR_ALOG(clearpath::Logger::DETAIL, "Received linear speed information (L: %f, R: %f)", 0.25 * i, 0.5 * i);
+    if (++i % 512 == 0)
+    {
+      state.PauseTiming();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      state.ResumeTiming();
+    }
+  }
+
+  state.counters["dropped"] = logger.droppedRecords() - dropped;
+  logger.setAsync(false);
+  logger.setSink(NULL);
+  logger.setLevel(clearpath::Logger::WARNING);
+}
+BENCHMARK(BM_LogAsync)->Iterations(1 << 17);
+
+static void BM_LogFiltered(benchmark::State &state)
+{
+  clearpath::Logger &logger = clearpath::Logger::instance();
+  logger.setLevel(clearpath::Logger::WARNING);
+
+  int i = 0;
+  for (auto _ : state)
+  {
+    CPR_ALOG(clearpath::Logger::DETAIL, "Received linear speed information (L: %f, R: %f)", 0.25 * i, 0.5 * i);
+    benchmark::ClobberMemory();
+    ++i;
+  }
+}
+BENCHMARK(BM_LogFiltered);
@@ -0,0 +1,505 @@
+/**
+Software License Agreement (BSD)
+
+\file      message_benchmark.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Message codec micro-benchmark, over one valid frame of every registered data
+ * message (see message_corpus.h):
+ *
+ *   Factory   Message::factory(nothrow), the receive path's constructor, against
+ *             a copy of the switch it replaced
+ *   IsValid   Message::isValid() on a fresh frame, against the original
+ *             byte-wise CRC check
+ *   Getters   every accessor of every Data* class, one benchmark per class
+ *   Decode    the one-pass decode() of the classes read every control cycle,
+ *             against fetching the same fields through their getters
+ *
+ *   ./husky_base_benchmarks --benchmark_filter='Factory|IsValid|Getters|Decode'
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <new>
+#include <string>
+#include <vector>
+
+#include "husky_base/horizon_legacy/crc.h"
+#include "husky_base/horizon_legacy/Message.h"
+#include "husky_base/horizon_legacy/Message_data.h"
+#include "message_corpus.h"
+
+using namespace clearpath;
+using husky_base_benchmark::corpus;
+using husky_base_benchmark::Frame;
+
+namespace
+{
+
+  // Horizon frame layout; Message keeps its own offsets protected
+  const size_t LENGTH_OFST = 1;
+  const size_t LENGTH_COMP_OFST = 2;
+  const size_t TYPE_OFST = 9;
+  const size_t STX_OFST = 11;
+  const size_t CRC_LENGTH = 2;
+  const int CRC_INIT = 0xFFFF;
+
+  template<typename T>
+  Message *makeChecked(void *input, size_t msg_len)
+  {
+    T *msg = new T(input, msg_len, std::nothrow);
+    if (!msg->hasExpectedLength())
+    {
+      delete msg;
+      return NULL;
+    }
+    return msg;
+  }
+
+#define LEGACY_CASE(DataMsgID, MessageClass) \
+      case DataMsgID: \
+        return makeChecked<MessageClass>(input, msg_len);
+
+  /** Reference copy of Message::factory(nothrow) as a switch over the type field */
+  Message *legacyFactory(void *input, size_t msg_len)
+  {
+    uint16_t type = btou((char *) input + TYPE_OFST, 2);
+
+    switch (type)
+    {
+      LEGACY_CASE(DATA_ACCEL, DataPlatformAcceleration)
+      LEGACY_CASE(DATA_ACCEL_RAW, DataRawAcceleration)
+      LEGACY_CASE(DATA_ACKERMANN_SETPTS, DataAckermannOutput)
+      LEGACY_CASE(DATA_CURRENT_RAW, DataRawCurrent)
+      LEGACY_CASE(DATA_PLATFORM_NAME, DataPlatformName)
+      LEGACY_CASE(DATA_DIFF_CTRL_CONSTS, DataDifferentialControl)
+      LEGACY_CASE(DATA_DIFF_WHEEL_SPEEDS, DataDifferentialSpeed)
+      LEGACY_CASE(DATA_DIFF_WHEEL_SETPTS, DataDifferentialOutput)
+      LEGACY_CASE(DATA_DISTANCE_DATA, DataRangefinders)
+      LEGACY_CASE(DATA_DISTANCE_TIMING, DataRangefinderTimings)
+      LEGACY_CASE(DATA_ECHO, DataEcho)
+      LEGACY_CASE(DATA_ENCODER, DataEncoders)
+      LEGACY_CASE(DATA_ENCODER_RAW, DataEncodersRaw)
+      LEGACY_CASE(DATA_FIRMWARE_INFO, DataFirmwareInfo)
+      LEGACY_CASE(DATA_GEAR_SETPT, DataGear)
+      LEGACY_CASE(DATA_GYRO_RAW, DataRawGyro)
+      LEGACY_CASE(DATA_MAGNETOMETER, DataPlatformMagnetometer)
+      LEGACY_CASE(DATA_MAGNETOMETER_RAW, DataRawMagnetometer)
+      LEGACY_CASE(DATA_MAX_ACCEL, DataMaxAcceleration)
+      LEGACY_CASE(DATA_MAX_SPEED, DataMaxSpeed)
+      LEGACY_CASE(DATA_ORIENT, DataPlatformOrientation)
+      LEGACY_CASE(DATA_ORIENT_RAW, DataRawOrientation)
+      LEGACY_CASE(DATA_PLATFORM_INFO, DataPlatformInfo)
+      LEGACY_CASE(DATA_POWER_SYSTEM, DataPowerSystem)
+      LEGACY_CASE(DATA_PROC_STATUS, DataProcessorStatus)
+      LEGACY_CASE(DATA_ROT_RATE, DataPlatformRotation)
+      LEGACY_CASE(DATA_SAFETY_SYSTEM, DataSafetySystemStatus)
+      LEGACY_CASE(DATA_SYSTEM_STATUS, DataSystemStatus)
+      LEGACY_CASE(DATA_TEMPERATURE_RAW, DataRawTemperature)
+      LEGACY_CASE(DATA_VELOCITY_SETPT, DataVelocity)
+      LEGACY_CASE(DATA_VOLTAGE_RAW, DataRawVoltage)
+
+      default:
+        return new Message(input, msg_len);
+    }
+  }
+
+#undef LEGACY_CASE
+
+  /** Reference copy of the original Message::isValid(), on the raw frame */
+  bool legacyIsValid(const uint8_t *data, size_t total_len)
+  {
+    if (data[0] != Message::SOH) { return false; }
+    if (data[STX_OFST] != Message::STX) { return false; }
+    uint8_t length = data[LENGTH_OFST];
+    if (length != ((~data[LENGTH_COMP_OFST]) & 0xff)) { return false; }
+    if (length != (total_len - 3)) { return false; }
+    size_t crc_ofst = total_len - CRC_LENGTH;
+    uint16_t checksum = data[crc_ofst] | (data[crc_ofst + 1] << 8);
+    return crc16_bytewise(crc_ofst, CRC_INIT, data) == checksum;
+  }
+
+  template<typename Factory>
+  void runFactory(benchmark::State &state, Factory factory)
+  {
+    if (!husky_base_benchmark::corpusComplete())
+    {
+      state.SkipWithError("Could not build a frame for every registered message type");
+      return;
+    }
+    std::vector<Frame> frames = corpus();
+    for (auto _ : state)
+    {
+      for (Frame &frame : frames)
+      {
+        Message *msg = factory(frame.bytes.data(), frame.bytes.size());
+        benchmark::DoNotOptimize(msg);
+        delete msg;
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * frames.size());
+  }
+
+  template<typename Check>
+  void runIsValid(benchmark::State &state, Check check)
+  {
+    std::vector<Frame> frames = corpus();
+    for (auto _ : state)
+    {
+      for (Frame &frame : frames)
+      {
+        // A fresh message each time, as on receive, so no CRC verdict is cached
+        Message msg(frame.bytes.data(), frame.bytes.size());
+        benchmark::DoNotOptimize(check(msg, frame));
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * frames.size());
+  }
+
+  /* Every accessor of each class, summed so none can be optimised away */
+
+  double readAll(DataAckermannOutput &m)
+  {
+    return m.getSteering() + m.getThrottle() + m.getBrake();
+  }
+
+  double readAll(DataDifferentialControl &m)
+  {
+    return m.getLeftP() + m.getLeftI() + m.getLeftD() + m.getLeftFeedForward() + m.getLeftStiction() +
+           m.getLeftIntegralLimit() + m.getRightP() + m.getRightI() + m.getRightD() + m.getRightFeedForward() +
+           m.getRightStiction() + m.getRightIntegralLimit();
+  }
+
+  double readAll(DataDifferentialOutput &m)
+  {
+    return m.getLeft() + m.getRight();
+  }
+
+  double readAll(DataDifferentialSpeed &m)
+  {
+    return m.getLeftSpeed() + m.getLeftAccel() + m.getRightSpeed() + m.getRightAccel();
+  }
+
+  double readAll(DataEcho &)
+  {
+    return 0;
+  }
+
+  double readAll(DataEncoders &m)
+  {
+    double sum = 0;
+    for (uint8_t i = 0; i < m.getCount(); ++i)
+    {
+      sum += m.getTravel(i) + m.getSpeed(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataEncodersRaw &m)
+  {
+    double sum = 0;
+    for (uint8_t i = 0; i < m.getCount(); ++i)
+    {
+      sum += m.getTicks(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataFirmwareInfo &m)
+  {
+    DataFirmwareInfo::WriteTime written = m.getWriteTime();
+    return m.getMajorFirmwareVersion() + m.getMinorFirmwareVersion() + m.getMajorProtocolVersion() +
+           m.getMinorProtocolVersion() + written.rawTime;
+  }
+
+  double readAll(DataGear &m)
+  {
+    return m.getGear();
+  }
+
+  double readAll(DataMaxAcceleration &m)
+  {
+    return m.getForwardMax() + m.getReverseMax();
+  }
+
+  double readAll(DataMaxSpeed &m)
+  {
+    return m.getForwardMax() + m.getReverseMax();
+  }
+
+  double readAll(DataPlatformAcceleration &m)
+  {
+    return m.getX() + m.getY() + m.getZ();
+  }
+
+  double readAll(DataPlatformInfo &m)
+  {
+    return m.getModel().size() + m.getRevision() + m.getSerial();
+  }
+
+  double readAll(DataPlatformName &m)
+  {
+    return m.getName().size();
+  }
+
+  double readAll(DataPlatformMagnetometer &m)
+  {
+    return m.getX() + m.getY() + m.getZ();
+  }
+
+  double readAll(DataPlatformOrientation &m)
+  {
+    return m.getRoll() + m.getYaw() + m.getPitch();
+  }
+
+  double readAll(DataPlatformRotation &m)
+  {
+    return m.getRollRate() + m.getPitchRate() + m.getYawRate();
+  }
+
+  double readAll(DataPowerSystem &m)
+  {
+    double sum = 0;
+    for (uint8_t i = 0; i < m.getBatteryCount(); ++i)
+    {
+      sum += m.getChargeEstimate(i) + m.getCapacityEstimate(i) + m.getDescription(i).getType();
+    }
+    return sum;
+  }
+
+  double readAll(DataProcessorStatus &m)
+  {
+    double sum = 0;
+    for (int i = 0; i < m.getProcessCount(); ++i)
+    {
+      sum += m.getErrorCount(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataRangefinders &m)
+  {
+    double sum = 0;
+    for (int i = 0; i < m.getRangefinderCount(); ++i)
+    {
+      sum += m.getDistance(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataRangefinderTimings &m)
+  {
+    double sum = 0;
+    for (int i = 0; i < m.getRangefinderCount(); ++i)
+    {
+      sum += m.getDistance(i) + m.getAcquisitionTime(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataRawAcceleration &m)
+  {
+    return m.getX() + m.getY() + m.getZ();
+  }
+
+  double readAll(DataRawCurrent &m)
+  {
+    double sum = 0;
+    for (int i = 0; i < m.getCurrentCount(); ++i)
+    {
+      sum += m.getCurrent(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataRawGyro &m)
+  {
+    return m.getRoll() + m.getPitch() + m.getYaw();
+  }
+
+  double readAll(DataRawMagnetometer &m)
+  {
+    return m.getX() + m.getY() + m.getZ();
+  }
+
+  double readAll(DataRawOrientation &m)
+  {
+    return m.getRoll() + m.getPitch() + m.getYaw();
+  }
+
+  double readAll(DataRawTemperature &m)
+  {
+    double sum = 0;
+    for (int i = 0; i < m.getTemperatureCount(); ++i)
+    {
+      sum += m.getTemperature(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataRawVoltage &m)
+  {
+    double sum = 0;
+    for (int i = 0; i < m.getVoltageCount(); ++i)
+    {
+      sum += m.getVoltage(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataSafetySystemStatus &m)
+  {
+    return m.getFlags();
+  }
+
+  double readAll(DataSystemStatus &m)
+  {
+    double sum = m.getUptime();
+    for (uint8_t i = 0; i < m.getVoltagesCount(); ++i)
+    {
+      sum += m.getVoltage(i);
+    }
+    for (uint8_t i = 0; i < m.getCurrentsCount(); ++i)
+    {
+      sum += m.getCurrent(i);
+    }
+    for (uint8_t i = 0; i < m.getTemperaturesCount(); ++i)
+    {
+      sum += m.getTemperature(i);
+    }
+    return sum;
+  }
+
+  double readAll(DataVelocity &m)
+  {
+    return m.getTranslational() + m.getRotational() + m.getTransAccel();
+  }
+
+  template<typename T>
+  T *corpusMessage()
+  {
+    for (const Frame &frame : corpus())
+    {
+      if (frame.type == MessageTraits<T>::type)
+      {
+        std::vector<uint8_t> bytes = frame.bytes;
+        return new T(bytes.data(), bytes.size());
+      }
+    }
+    return NULL;
+  }
+
+}  // namespace
+
+static void BM_MessageFactory(benchmark::State &state)
+{
+  runFactory(state, [](void *input, size_t len) { return Message::factory(input, len, std::nothrow); });
+}
+BENCHMARK(BM_MessageFactory);
+
+static void BM_MessageFactoryBaseline(benchmark::State &state)
+{
+  runFactory(state, legacyFactory);
+}
+BENCHMARK(BM_MessageFactoryBaseline);
+
+static void BM_MessageIsValid(benchmark::State &state)
+{
+  runIsValid(state, [](Message &msg, const Frame &) { return msg.isValid(); });
+}
+BENCHMARK(BM_MessageIsValid);
+
+static void BM_MessageIsValidBaseline(benchmark::State &state)
+{
+  runIsValid(state, [](Message &, const Frame &frame) { return legacyIsValid(frame.bytes.data(), frame.bytes.size()); });
+}
+BENCHMARK(BM_MessageIsValidBaseline);
+
+template<typename T>
+static void BM_Getters(benchmark::State &state)
+{
+  T *msg = corpusMessage<T>();
+  if (!msg)
+  {
+    state.SkipWithError("No corpus frame for this message type");
+    return;
+  }
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(readAll(*msg));
+  }
+  delete msg;
+}
+BENCHMARK_TEMPLATE(BM_Getters, DataAckermannOutput);
+BENCHMARK_TEMPLATE(BM_Getters, DataDifferentialControl);
+BENCHMARK_TEMPLATE(BM_Getters, DataDifferentialOutput);
+BENCHMARK_TEMPLATE(BM_Getters, DataDifferentialSpeed);
+BENCHMARK_TEMPLATE(BM_Getters, DataEcho);
+BENCHMARK_TEMPLATE(BM_Getters, DataEncoders);
+BENCHMARK_TEMPLATE(BM_Getters, DataEncodersRaw);
+BENCHMARK_TEMPLATE(BM_Getters, DataFirmwareInfo);
+BENCHMARK_TEMPLATE(BM_Getters, DataGear);
+BENCHMARK_TEMPLATE(BM_Getters, DataMaxAcceleration);
+BENCHMARK_TEMPLATE(BM_Getters, DataMaxSpeed);
+BENCHMARK_TEMPLATE(BM_Getters, DataPlatformAcceleration);
+BENCHMARK_TEMPLATE(BM_Getters, DataPlatformInfo);
+BENCHMARK_TEMPLATE(BM_Getters, DataPlatformName);
+BENCHMARK_TEMPLATE(BM_Getters, DataPlatformMagnetometer);
+BENCHMARK_TEMPLATE(BM_Getters, DataPlatformOrientation);
+BENCHMARK_TEMPLATE(BM_Getters, DataPlatformRotation);
+BENCHMARK_TEMPLATE(BM_Getters, DataPowerSystem);
+BENCHMARK_TEMPLATE(BM_Getters, DataProcessorStatus);
+BENCHMARK_TEMPLATE(BM_Getters, DataRangefinders);
+BENCHMARK_TEMPLATE(BM_Getters, DataRangefinderTimings);
+BENCHMARK_TEMPLATE(BM_Getters, DataRawAcceleration);
+BENCHMARK_TEMPLATE(BM_Getters, DataRawCurrent);
+BENCHMARK_TEMPLATE(BM_Getters, DataRawGyro);
+BENCHMARK_TEMPLATE(BM_Getters, DataRawMagnetometer);
+BENCHMARK_TEMPLATE(BM_Getters, DataRawOrientation);
+BENCHMARK_TEMPLATE(BM_Getters, DataRawTemperature);
+BENCHMARK_TEMPLATE(BM_Getters, DataRawVoltage);
+BENCHMARK_TEMPLATE(BM_Getters, DataSafetySystemStatus);
+BENCHMARK_TEMPLATE(BM_Getters, DataSystemStatus);
+BENCHMARK_TEMPLATE(BM_Getters, DataVelocity);
+
+template<typename T, typename Sample>
+static void BM_Decode(benchmark::State &state)
+{
+  T *msg = corpusMessage<T>();
+  if (!msg)
+  {
+    state.SkipWithError("No corpus frame for this message type");
+    return;
+  }
+  Sample sample;
+  for (auto _ : state)
+  {
+    msg->decode(sample);
+    benchmark::DoNotOptimize(sample);
+  }
+  delete msg;
+}
+BENCHMARK_TEMPLATE(BM_Decode, DataDifferentialSpeed, DifferentialSpeedSample);
+BENCHMARK_TEMPLATE(BM_Decode, DataEncoders, EncoderSample);
+BENCHMARK_TEMPLATE(BM_Decode, DataPowerSystem, PowerSystemSample);
+BENCHMARK_TEMPLATE(BM_Decode, DataSystemStatus, SystemStatusSample);
@@ -0,0 +1,199 @@
+/**
+Software License Agreement (BSD)
+
+\file      message_corpus.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Shared, seeded input data for the codec benchmarks, so a benchmark and its
+ * Baseline twin always run over exactly the same bytes, build after build.
+ *
+ * Benchmarks with a reference implementation come in pairs: BM_Foo is the
+ * current code and BM_FooBaseline a copy of what it replaced, on the same data.
+ * To judge a change, compare a pair in one run, or two runs of the same pair:
+ *
+ *   ./husky_base_benchmarks --benchmark_filter='Btou|Factory|RxFraming'
+ *   compare.py filters ./husky_base_benchmarks BM_MessageFactory BM_MessageFactoryBaseline
+ *   compare.py benchmarks before.json after.json   # from --benchmark_out=... --benchmark_out_format=json
+ *
+ * (compare.py ships with Google Benchmark, under tools/.)
+ */
+
+#ifndef HUSKY_BASE_BENCHMARK_MESSAGE_CORPUS_H
+#define HUSKY_BASE_BENCHMARK_MESSAGE_CORPUS_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include "husky_base/horizon_legacy/Message.h"
+#include "husky_base/horizon_legacy/MessageRegistry.h"
+
+namespace husky_base_benchmark
+{
+
+  const unsigned CORPUS_SEED = 20230417;
+
+  struct Frame
+  {
+    uint16_t type;
+    std::vector<uint8_t> bytes;
+  };
+
+  template<typename... Entries>
+  std::vector<uint16_t> typeIds(clearpath::MessageTypeList<Entries...>)
+  {
+    return {static_cast<uint16_t>(Entries::type)...};
+  }
+
+  inline std::vector<uint8_t> encode(uint16_t type, std::vector<uint8_t> payload)
+  {
+    clearpath::Message msg(type, payload.data(), payload.size());
+    std::vector<uint8_t> bytes(clearpath::Message::MAX_MSG_LENGTH);
+    bytes.resize(msg.toBytes(bytes.data(), bytes.size()));
+    return bytes;
+  }
+
+  /** Whether the registered class for type takes this payload */
+  inline bool accepts(uint16_t type, const std::vector<uint8_t> &payload)
+  {
+    std::vector<uint8_t> frame = encode(type, payload);
+    bool registered;
+    clearpath::Message *msg = clearpath::DataMessages::makeChecked(type, frame.data(), frame.size(), registered);
+    delete msg;
+    return msg != NULL;
+  }
+
+  /**
+  * One valid frame of every registered data message, in DataMessageTypes order.
+  * Payload lengths are found by trial: with every byte at 2, each count field says
+  * "two entries". Bytes are then randomised one by one, keeping those the class
+  * still accepts, so counts and string lengths stay put and the rest is noise.
+  */
+  inline std::vector<Frame> buildCorpus(unsigned seed)
+  {
+    const size_t MAX_PAYLOAD = clearpath::Message::MAX_MSG_LENGTH - clearpath::Message::MIN_MSG_LENGTH;
+    std::mt19937 rng(seed);
+    std::vector<Frame> frames;
+
+    for (uint16_t type : typeIds(clearpath::DataMessageTypes()))
+    {
+      std::vector<uint8_t> payload;
+      while (payload.size() <= MAX_PAYLOAD && !accepts(type, payload))
+      {
+        payload.push_back(2);
+      }
+      if (payload.size() > MAX_PAYLOAD)
+      {
+        continue;
+      }
+      for (size_t i = 0; i < payload.size(); ++i)
+      {
+        uint8_t was = payload[i];
+        payload[i] = static_cast<uint8_t>(rng());
+        if (!accepts(type, payload))
+        {
+          payload[i] = was;
+        }
+      }
+      Frame frame = {type, encode(type, payload)};
+      frames.push_back(frame);
+    }
+    return frames;
+  }
+
+  inline const std::vector<Frame> &corpus()
+  {
+    static const std::vector<Frame> frames = buildCorpus(CORPUS_SEED);
+    return frames;
+  }
+
+  inline bool corpusComplete()
+  {
+    return corpus().size() == clearpath::DataMessages::SIZE;
+  }
+
+  /**
+  * Serial input as a bad link delivers it: the corpus frames in a random order,
+  * with line noise, stray SOH bytes, truncated frames and broken CRCs between
+  * them. Roughly one frame in eight is damaged.
+  */
+  inline std::vector<uint8_t> noisyStream(size_t frame_count, unsigned seed)
+  {
+    const std::vector<Frame> &frames = corpus();
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> stream;
+
+    for (size_t n = 0; n < frame_count && !frames.empty(); ++n)
+    {
+      const std::vector<uint8_t> &bytes = frames[rng() % frames.size()].bytes;
+      switch (rng() % 16)
+      {
+        case 0:
+          // Line noise, sometimes with a false frame start inside
+          for (unsigned i = rng() % 24; i > 0; --i)
+          {
+            stream.push_back((rng() % 8) ? static_cast<uint8_t>(rng()) : clearpath::Message::SOH);
+          }
+          break;
+
+        case 1:
+          // Frame cut off part way, as after a dropped byte run
+          stream.insert(stream.end(), bytes.begin(), bytes.begin() + 1 + rng() % (bytes.size() - 1));
+          continue;
+
+        case 2:
+        {
+          // Corrupted in flight: framing intact, CRC wrong
+          size_t at = clearpath::Message::MIN_MSG_LENGTH - 2 + rng() % (bytes.size() - clearpath::Message::MIN_MSG_LENGTH + 2);
+          stream.insert(stream.end(), bytes.begin(), bytes.end());
+          stream[stream.size() - bytes.size() + at] ^= 0x10;
+          continue;
+        }
+
+        default:
+          break;
+      }
+      stream.insert(stream.end(), bytes.begin(), bytes.end());
+    }
+    return stream;
+  }
+
+  /** Sizes the stream arrives in, like consecutive read(2) results at 115200 baud */
+  inline std::vector<size_t> readSizes(size_t stream_len, unsigned seed)
+  {
+    std::mt19937 rng(seed);
+    std::vector<size_t> sizes;
+    for (size_t total = 0; total < stream_len;)
+    {
+      size_t n = std::min<size_t>(1 + rng() % 64, stream_len - total);
+      sizes.push_back(n);
+      total += n;
+    }
+    return sizes;
+  }
+
+}  // namespace husky_base_benchmark
+
+#endif  // HUSKY_BASE_BENCHMARK_MESSAGE_CORPUS_H
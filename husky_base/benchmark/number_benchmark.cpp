@@ -0,0 +1,301 @@
+/**
+Software License Agreement (BSD)
+
+\file      number_benchmark.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Number.cpp micro-benchmark: the little-endian field codecs (btou, btoi, btof,
+ * utob, itob) at every field width the protocol uses, against the original
+ * byte-at-a-time loops. Each width decodes or encodes a packed run of fields
+ * from the same seeded bytes; before timing, the current code is checked
+ * value-for-value against the reference and a mismatch fails the benchmark.
+ *
+ *   ./husky_base_benchmarks --benchmark_filter='Btou|Btoi|Btof|Utob|Itob'
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "husky_base/horizon_legacy/Number.h"
+#include "message_corpus.h"
+
+namespace
+{
+
+  const size_t FIELDS = 256;
+
+  /** Reference copies of the original Number.cpp routines */
+  namespace legacy
+  {
+    uint64_t btou(void *src, size_t src_len)
+    {
+      uint64_t retval = 0;
+
+      if (!src_len) { return 0; }
+      size_t i = src_len - 1;
+      do
+      {
+        retval = retval << 8;
+        retval |= ((uint8_t *) src)[i];
+      } while (i--);
+
+      return retval;
+    }
+
+    int64_t btoi(void *src, size_t src_len)
+    {
+      int64_t retval = 0;
+      size_t i = sizeof(int64_t);
+
+      if (!src_len) { return 0; }
+
+      for (; i >= src_len; --i)
+      {
+        retval = retval << 8;
+        if (((uint8_t *) src)[src_len - 1] & 0x80)
+        {
+          retval |= 0xff;
+        }
+      }
+      do
+      {
+        retval = retval << 8;
+        retval |= ((uint8_t *) src)[i];
+      } while (i--);
+
+      return retval;
+    }
+
+    double btof(void *src, size_t src_len, double scale)
+    {
+      double retval = btoi(src, src_len);
+      return retval /= scale;
+    }
+
+    void utob(void *dest, size_t dest_len, uint64_t src)
+    {
+      size_t i;
+      for (i = 0; (i < dest_len) && (i < sizeof(uint64_t)); ++i)
+      {
+        ((uint8_t *) dest)[i] = (src >> (i * 8)) & 0xff;
+      }
+      for (; i < dest_len; ++i)
+      {
+        ((uint8_t *) dest)[i] = 0;
+      }
+    }
+
+    void itob(void *dest, size_t dest_len, int64_t src)
+    {
+      size_t i;
+      for (i = 0; (i < dest_len) && (i < sizeof(int64_t)); ++i)
+      {
+        ((uint8_t *) dest)[i] = (src >> (i * 8)) & 0xff;
+      }
+      for (; i < dest_len; ++i)
+      {
+        ((uint8_t *) dest)[i] = (((uint8_t *) dest)[dest_len - 1] & 0x80) ? 0xff : 0;
+      }
+    }
+  }  // namespace legacy
+
+  std::vector<uint8_t> fieldBytes(size_t width)
+  {
+    std::mt19937 rng(husky_base_benchmark::CORPUS_SEED + width);
+    std::vector<uint8_t> bytes(FIELDS * width);
+    for (uint8_t &b : bytes)
+    {
+      b = static_cast<uint8_t>(rng());
+    }
+    return bytes;
+  }
+
+  std::vector<int64_t> fieldValues(size_t width)
+  {
+    std::vector<uint8_t> bytes = fieldBytes(width);
+    std::vector<int64_t> values(FIELDS);
+    for (size_t i = 0; i < FIELDS; ++i)
+    {
+      values[i] = legacy::btoi(&bytes[i * width], width);
+    }
+    return values;
+  }
+
+  bool decodersMatch(size_t width)
+  {
+    std::vector<uint8_t> bytes = fieldBytes(width);
+    for (size_t i = 0; i < FIELDS; ++i)
+    {
+      void *field = &bytes[i * width];
+      if (clearpath::btou(field, width) != legacy::btou(field, width) ||
+          clearpath::btoi(field, width) != legacy::btoi(field, width) ||
+          clearpath::btof(field, width, 100) != legacy::btof(field, width, 100))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool encodersMatch(size_t width)
+  {
+    std::vector<int64_t> values = fieldValues(width);
+    std::vector<uint8_t> current(width), reference(width);
+    for (int64_t value : values)
+    {
+      clearpath::itob(current.data(), width, value);
+      legacy::itob(reference.data(), width, value);
+      if (current != reference) { return false; }
+      clearpath::utob(current.data(), width, static_cast<uint64_t>(value));
+      legacy::utob(reference.data(), width, static_cast<uint64_t>(value));
+      if (current != reference) { return false; }
+    }
+    return true;
+  }
+
+  void fieldWidths(benchmark::internal::Benchmark *bench)
+  {
+    // Status bytes, most fixed-point fields, the odd 3-byte field, counters and timestamps, 64-bit
+    bench->Arg(1)->Arg(2)->Arg(3)->Arg(4)->Arg(8);
+  }
+
+  template<typename Decode>
+  void runDecode(benchmark::State &state, Decode decode)
+  {
+    size_t width = state.range(0);
+    std::vector<uint8_t> bytes = fieldBytes(width);
+    for (auto _ : state)
+    {
+      for (size_t i = 0; i < FIELDS; ++i)
+      {
+        benchmark::DoNotOptimize(decode(&bytes[i * width], width));
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * FIELDS);
+  }
+
+  template<typename Encode>
+  void runEncode(benchmark::State &state, Encode encode)
+  {
+    size_t width = state.range(0);
+    std::vector<int64_t> values = fieldValues(width);
+    std::vector<uint8_t> bytes(FIELDS * width);
+    for (auto _ : state)
+    {
+      for (size_t i = 0; i < FIELDS; ++i)
+      {
+        encode(&bytes[i * width], width, values[i]);
+      }
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FIELDS);
+  }
+
+}  // namespace
+
+static void BM_Btou(benchmark::State &state)
+{
+  if (!decodersMatch(state.range(0)))
+  {
+    state.SkipWithError("Number.cpp decoders do not match the byte-wise reference");
+    return;
+  }
+  runDecode(state, [](void *src, size_t len) { return clearpath::btou(src, len); });
+}
+BENCHMARK(BM_Btou)->Apply(fieldWidths);
+
+static void BM_BtouBaseline(benchmark::State &state)
+{
+  runDecode(state, [](void *src, size_t len) { return legacy::btou(src, len); });
+}
+BENCHMARK(BM_BtouBaseline)->Apply(fieldWidths);
+
+static void BM_Btoi(benchmark::State &state)
+{
+  if (!decodersMatch(state.range(0)))
+  {
+    state.SkipWithError("Number.cpp decoders do not match the byte-wise reference");
+    return;
+  }
+  runDecode(state, [](void *src, size_t len) { return clearpath::btoi(src, len); });
+}
+BENCHMARK(BM_Btoi)->Apply(fieldWidths);
+
+static void BM_BtoiBaseline(benchmark::State &state)
+{
+  runDecode(state, [](void *src, size_t len) { return legacy::btoi(src, len); });
+}
+BENCHMARK(BM_BtoiBaseline)->Apply(fieldWidths);
+
+static void BM_Btof(benchmark::State &state)
+{
+  if (!decodersMatch(state.range(0)))
+  {
+    state.SkipWithError("Number.cpp decoders do not match the byte-wise reference");
+    return;
+  }
+  runDecode(state, [](void *src, size_t len) { return clearpath::btof(src, len, 100); });
+}
+BENCHMARK(BM_Btof)->Apply(fieldWidths);
+
+static void BM_BtofBaseline(benchmark::State &state)
+{
+  runDecode(state, [](void *src, size_t len) { return legacy::btof(src, len, 100); });
+}
+BENCHMARK(BM_BtofBaseline)->Apply(fieldWidths);
+
+static void BM_Utob(benchmark::State &state)
+{
+  if (!encodersMatch(state.range(0)))
+  {
+    state.SkipWithError("Number.cpp encoders do not match the byte-wise reference");
+    return;
+  }
+  runEncode(state, [](void *dest, size_t len, int64_t v) { clearpath::utob(dest, len, static_cast<uint64_t>(v)); });
+}
+BENCHMARK(BM_Utob)->Apply(fieldWidths);
+
+static void BM_UtobBaseline(benchmark::State &state)
+{
+  runEncode(state, [](void *dest, size_t len, int64_t v) { legacy::utob(dest, len, static_cast<uint64_t>(v)); });
+}
+BENCHMARK(BM_UtobBaseline)->Apply(fieldWidths);
+
+static void BM_Itob(benchmark::State &state)
+{
+  if (!encodersMatch(state.range(0)))
+  {
+    state.SkipWithError("Number.cpp encoders do not match the byte-wise reference");
+    return;
+  }
+  runEncode(state, [](void *dest, size_t len, int64_t v) { clearpath::itob(dest, len, v); });
+}
+BENCHMARK(BM_Itob)->Apply(fieldWidths);
+
+static void BM_ItobBaseline(benchmark::State &state)
+{
+  runEncode(state, [](void *dest, size_t len, int64_t v) { legacy::itob(dest, len, v); });
+}
+BENCHMARK(BM_ItobBaseline)->Apply(fieldWidths);
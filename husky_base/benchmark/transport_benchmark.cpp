@@ -0,0 +1,333 @@
+/**
+Software License Agreement (BSD)
+
+\file      transport_benchmark.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Receive-path micro-benchmark.
+ *
+ * Encoder frames are pushed through a pseudo-terminal and read back either
+ * the way Transport::rxMessage() used to (one read(2) per byte, see
+ * legacyRxMessage() below) or through the current Transport::poll().
+ * items_per_second is frames received, so CPU time per frame is its inverse.
+ *
+ * RxFraming does the same without a port: the framing state machine alone,
+ * fed from memory with a seeded stream of every message type mixed with line
+ * noise, truncated frames and bad CRCs, in read(2)-sized chunks. Each frame is
+ * built and validated as the Transport would; rejected counts what was
+ * framed but failed the length or CRC check.
+ *
+ *   cmake -DHUSKY_BASE_BUILD_BENCHMARKS=ON ... && ./husky_base_benchmarks --benchmark_filter=Rx
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "husky_base/horizon_legacy/clearpath.h"
+#include "husky_base/horizon_legacy/FrameScanner.h"
+#include "message_corpus.h"
+
+namespace
+{
+
+  const int FRAMES_PER_BATCH = 64;
+
+  struct PtyLink
+  {
+    int master;
+    int slave;
+    char name[64];
+    std::vector<uint8_t> batch;
+
+    PtyLink()
+    {
+      if (openpty(&master, &slave, name, NULL, NULL) != 0)
+      {
+        master = slave = -1;
+        return;
+      }
+      struct termios tio;
+      tcgetattr(slave, &tio);
+      cfmakeraw(&tio);
+      tcsetattr(slave, TCSANOW, &tio);
+
+      // Two wheels worth of travel and speed, like the MCU streams at runtime
+      uint8_t payload[] = {2, 0x10, 0x27, 0, 0, 0x20, 0x4e, 0, 0, 0x96, 0, 0x6a, 0xff};
+      clearpath::Message msg(clearpath::DataEncoders::getTypeID(), payload, sizeof(payload));
+      uint8_t frame[clearpath::Message::MAX_MSG_LENGTH];
+      size_t len = msg.toBytes(frame, sizeof(frame));
+      for (int i = 0; i < FRAMES_PER_BATCH; ++i)
+      {
+        batch.insert(batch.end(), frame, frame + len);
+      }
+    }
+
+    ~PtyLink()
+    {
+      if (master >= 0) { close(master); }
+      if (slave >= 0) { close(slave); }
+    }
+
+    /** Write one batch and wait until all of it is readable on the slave side */
+    void feed()
+    {
+      ssize_t written = write(master, batch.data(), batch.size());
+      (void) written;
+      int avail = 0;
+      while (ioctl(slave, FIONREAD, &avail) == 0 && avail < static_cast<int>(batch.size()))
+      {
+        usleep(10);
+      }
+    }
+  };
+
+  clearpath::Message *parseThrowing(void *input, size_t msg_len)
+  {
+    return clearpath::Message::factory(input, msg_len);
+  }
+
+  clearpath::Message *parseChecked(void *input, size_t msg_len)
+  {
+    return clearpath::Message::factory(input, msg_len, std::nothrow);
+  }
+
+  /** Reference copy of the pre-buffering receive state machine */
+  struct LegacyRx
+  {
+    char rx_buf[clearpath::Message::MAX_MSG_LENGTH];
+    size_t rx_inx = 0;
+    size_t msg_len = 0;
+
+    clearpath::Message *rxMessage(int fd)
+    {
+      while (read(fd, rx_buf + rx_inx, 1) == 1)
+      {
+        if (clearpath::Message *msg = step(parseThrowing))
+        {
+          return msg;
+        }
+      }
+      return NULL;
+    }
+
+    /** Take one byte, already stored at rx_buf[rx_inx] */
+    template<typename Factory>
+    clearpath::Message *step(Factory factory)
+    {
+      switch (rx_inx)
+      {
+        case 0:
+          if ((uint8_t) (rx_buf[0]) == clearpath::Message::SOH) { rx_inx++; }
+          break;
+
+        case 1:
+          rx_inx++;
+          break;
+
+        case 2:
+          rx_inx++;
+          msg_len = static_cast<uint8_t>(rx_buf[1]) + 3;
+          if (static_cast<unsigned char>(rx_buf[1] ^ rx_buf[2]) != 0xFF ||
+              (msg_len < clearpath::Message::MIN_MSG_LENGTH))
+          {
+            rx_inx = 0;
+          }
+          break;
+
+        default:
+          rx_inx++;
+          if (rx_inx < msg_len) { break; }
+          rx_inx = 0;
+          return factory(rx_buf, msg_len);
+      }
+      return NULL;
+    }
+  };
+
+  /** The noisy stream and the read(2) sizes it is delivered in, shared by both framers */
+  struct NoisyInput
+  {
+    std::vector<uint8_t> stream;
+    std::vector<size_t> reads;
+
+    NoisyInput() :
+        stream(husky_base_benchmark::noisyStream(1024, husky_base_benchmark::CORPUS_SEED)),
+        reads(husky_base_benchmark::readSizes(stream.size(), husky_base_benchmark::CORPUS_SEED))
+    {
+    }
+  };
+
+  /** Account for one framed message as the Transport does: validate, count, free */
+  void takeFrame(clearpath::Message *msg, int64_t &frames, int64_t &rejected)
+  {
+    if (msg && msg->isValid())
+    {
+      ++frames;
+    }
+    else
+    {
+      ++rejected;
+    }
+    delete msg;
+  }
+
+}  // namespace
+
+static void BM_RxPerByteRead(benchmark::State &state)
+{
+  PtyLink link;
+  if (link.master < 0)
+  {
+    state.SkipWithError("openpty failed");
+    return;
+  }
+  int fd = open(link.name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  LegacyRx rx;
+  int64_t frames = 0;
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    link.feed();
+    state.ResumeTiming();
+
+    for (int got = 0; got < FRAMES_PER_BATCH;)
+    {
+      clearpath::Message *msg = rx.rxMessage(fd);
+      if (msg)
+      {
+        delete msg;
+        ++got;
+      }
+    }
+    frames += FRAMES_PER_BATCH;
+  }
+  close(fd);
+  state.SetItemsProcessed(frames);
+}
+BENCHMARK(BM_RxPerByteRead);
+
+static void BM_RxBulkRead(benchmark::State &state)
+{
+  PtyLink link;
+  if (link.master < 0)
+  {
+    state.SkipWithError("openpty failed");
+    return;
+  }
+  clearpath::Transport &transport = clearpath::Transport::instance();
+  // The batch is one type, and a default queue would only keep the latest of it
+  transport.setQueueDepth(clearpath::DataEncoders::getTypeID(), FRAMES_PER_BATCH);
+  transport.configure(link.name, 0);
+  int64_t frames = 0;
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    link.feed();
+    state.ResumeTiming();
+
+    for (int got = 0; got < FRAMES_PER_BATCH;)
+    {
+      transport.poll();
+      clearpath::Message *msg;
+      while ((msg = transport.popNext()) != NULL)
+      {
+        delete msg;
+        ++got;
+      }
+    }
+    frames += FRAMES_PER_BATCH;
+  }
+  transport.close();
+  transport.setQueueDepth(clearpath::DataEncoders::getTypeID(), 1);
+  state.SetItemsProcessed(frames);
+}
+BENCHMARK(BM_RxBulkRead);
+
+static void BM_RxFraming(benchmark::State &state)
+{
+  NoisyInput input;
+  clearpath::FrameScanner scanner;
+  int64_t frames = 0, rejected = 0;
+  unsigned long garbled = 0;
+
+  for (auto _ : state)
+  {
+    const uint8_t *next = input.stream.data();
+    for (size_t n : input.reads)
+    {
+      scanner.prepare();
+      scanner.append(next, n);
+      next += n;
+
+      const uint8_t *frame;
+      size_t len;
+      while (scanner.nextFrame(&frame, &len, &garbled))
+      {
+        takeFrame(parseChecked(const_cast<uint8_t *>(frame), len), frames, rejected);
+      }
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * input.stream.size());
+  state.SetItemsProcessed(frames);
+  state.counters["rejected"] = benchmark::Counter(rejected, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RxFraming);
+
+static void BM_RxFramingBaseline(benchmark::State &state)
+{
+  NoisyInput input;
+  LegacyRx rx;
+  int64_t frames = 0, rejected = 0;
+
+  for (auto _ : state)
+  {
+    const uint8_t *next = input.stream.data();
+    for (size_t n : input.reads)
+    {
+      // The legacy receiver only ever took a byte at a time, whatever read(2) had ready
+      for (const uint8_t *end = next + n; next < end; ++next)
+      {
+        rx.rx_buf[rx.rx_inx] = static_cast<char>(*next);
+        if (clearpath::Message *msg = rx.step(parseChecked))
+        {
+          takeFrame(msg, frames, rejected);
+        }
+      }
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * input.stream.size());
+  state.SetItemsProcessed(frames);
+  state.counters["rejected"] = benchmark::Counter(rejected, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RxFramingBaseline);
@@ -0,0 +1,431 @@
+/**
+Software License Agreement (BSD)
+
+\file      McuEmulator.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <poll.h>
+#include <pty.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "McuEmulator.h"
+#include "husky_base/horizon_legacy/clearpath.h"
+
+namespace clearpath
+{
+
+  namespace
+  {
+    // Fixed readings the status messages report
+    const double SYSTEM_VOLTAGES[] = {25.0, 12.0, 5.0};
+    const double SYSTEM_CURRENTS[] = {1.0, 1.0, 0.5};
+    const double SYSTEM_TEMPERATURES[] = {30.0, 30.0, 35.0, 35.0};
+    const double BATTERY_CHARGE = 90.0;
+    const int16_t BATTERY_CAPACITY = 400;
+    const uint8_t BATTERY_DESCRIPTION = 0xC1;  // present, in use, lead acid
+
+    const int IDLE_WAKEUP_MS = 10;
+
+    template<size_t N>
+    size_t putScaled(uint8_t *dest, const double (&values)[N], double scale)
+    {
+      dest[0] = static_cast<uint8_t>(N);
+      for (size_t i = 0; i < N; ++i)
+      {
+        ftob(dest + 1 + 2 * i, 2, values[i], scale);
+      }
+      return 1 + 2 * N;
+    }
+  } // namespace
+
+  McuEmulator::McuEmulator(unsigned int seed) :
+      master(-1),
+      slave(-1),
+      running(false),
+      rng(seed),
+      left_speed(0.0),
+      right_speed(0.0),
+      left_travel(0.0),
+      right_travel(0.0),
+      frames_received(0),
+      acks_sent(0),
+      data_sent(0),
+      dropped(0),
+      corrupted(0)
+  {
+    port_name[0] = '\0';
+  }
+
+  McuEmulator::~McuEmulator()
+  {
+    stop();
+  }
+
+  bool McuEmulator::start()
+  {
+    if (running)
+    {
+      return true;
+    }
+    if (openpty(&master, &slave, port_name, NULL, NULL) < 0)
+    {
+      return false;
+    }
+
+    // Keep our end of the slave open and raw so the line discipline never
+    // echoes or translates anything before the driver has configured it
+    struct termios options;
+    tcgetattr(slave, &options);
+    cfmakeraw(&options);
+    tcsetattr(slave, TCSANOW, &options);
+
+    scanner.reset();
+    outgoing.clear();
+    subscriptions.clear();
+    started = last_advance = Clock::now();
+    running = true;
+    thread = std::thread(&McuEmulator::threadMain, this);
+    return true;
+  }
+
+  void McuEmulator::stop()
+  {
+    if (!running)
+    {
+      return;
+    }
+    running = false;
+    thread.join();
+    ::close(master);
+    ::close(slave);
+    master = slave = -1;
+  }
+
+  void McuEmulator::setFaults(const Faults &f)
+  {
+    std::lock_guard<std::mutex> lock(faults_mutex);
+    faults = f;
+  }
+
+  McuEmulator::Stats McuEmulator::stats() const
+  {
+    Stats s;
+    s.frames_received = frames_received.load(std::memory_order_relaxed);
+    s.acks_sent = acks_sent.load(std::memory_order_relaxed);
+    s.data_sent = data_sent.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.corrupted = corrupted.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  bool McuEmulator::chance(double probability)
+  {
+    return probability > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < probability;
+  }
+
+/**
+* Milliseconds since start() on the emulated MCU's own, possibly drifting, clock.
+*/
+  uint32_t McuEmulator::mcuTime(Clock::time_point now)
+  {
+    return static_cast<uint32_t>(std::chrono::duration<double, std::milli>(now - started).count() *
+                                 (1.0 + active.clock_drift));
+  }
+
+  void McuEmulator::threadMain()
+  {
+    while (running)
+    {
+      {
+        std::lock_guard<std::mutex> lock(faults_mutex);
+        active = faults;
+      }
+
+      // Sleep until input arrives or the next frame is due out
+      Clock::time_point now = Clock::now();
+      Clock::time_point wake = now + std::chrono::milliseconds(IDLE_WAKEUP_MS);
+      if (!outgoing.empty() && outgoing.front().due < wake)
+      {
+        wake = outgoing.front().due;
+      }
+      for (std::map<uint16_t, Subscription>::const_iterator it = subscriptions.begin(); it != subscriptions.end(); ++it)
+      {
+        if (it->second.next < wake)
+        {
+          wake = it->second.next;
+        }
+      }
+      struct timespec timeout = {0, 0};
+      if (wake > now)
+      {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wake - now).count();
+        timeout.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+        timeout.tv_nsec = static_cast<long>(ns % 1000000000LL);
+      }
+
+      struct pollfd pfd;
+      pfd.fd = master;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      // ppoll() rather than poll(), injected latencies are often below a millisecond
+      if (::ppoll(&pfd, 1, &timeout, NULL) > 0 && (pfd.revents & POLLIN))
+      {
+        ssize_t n = ::read(master, scanner.writePointer(), scanner.prepare());
+        if (n > 0)
+        {
+          scanner.commit(static_cast<size_t>(n));
+        }
+      }
+
+      now = Clock::now();
+      advance(now);
+
+      const uint8_t *frame;
+      size_t len;
+      unsigned long garbled = 0;
+      while (scanner.nextFrame(&frame, &len, &garbled))
+      {
+        handleFrame(frame, len, now);
+      }
+
+      serviceSubscriptions(now);
+      flushDue(Clock::now());
+    }
+  }
+
+  void McuEmulator::advance(Clock::time_point now)
+  {
+    double dt = std::chrono::duration<double>(now - last_advance).count();
+    left_travel += left_speed * dt;
+    right_travel += right_speed * dt;
+    last_advance = now;
+  }
+
+  void McuEmulator::handleFrame(const uint8_t *frame, size_t len, Clock::time_point now)
+  {
+    frames_received.fetch_add(1, std::memory_order_relaxed);
+    if (chance(active.drop_rate))
+    {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    Message msg(const_cast<uint8_t *>(frame), len);
+    uint16_t type = msg.getType();
+    uint8_t payload[Message::MAX_MSG_LENGTH];
+    size_t payload_len = msg.getPayload(payload, sizeof(payload));
+    uint32_t timestamp = msg.getTimestamp();
+    if (!msg.isValid())
+    {
+      sendAck(type, timestamp, BadAckException::BAD_CHECKSUM, now);
+      return;
+    }
+
+    if (msg.isCommand())
+    {
+      if (type == SET_DIFF_WHEEL_SPEEDS && payload_len >= SetDifferentialSpeed::PAYLOAD_LEN)
+      {
+        left_speed = btoi(payload + SetDifferentialSpeed::LEFT_SPEED, 2) / 100.0;
+        right_speed = btoi(payload + SetDifferentialSpeed::RIGHT_SPEED, 2) / 100.0;
+      }
+      sendAck(type, timestamp, 0, now);
+      return;
+    }
+
+    if (!msg.isRequest())
+    {
+      sendAck(type, timestamp, BadAckException::BAD_TYPE, now);
+      return;
+    }
+
+    uint16_t data_type = static_cast<uint16_t>(type + 0x4000);
+    uint16_t freq = 0;
+    if (payload_len >= 2)
+    {
+      freq = static_cast<uint16_t>(btou(payload, 2));
+    }
+
+    // Reuses the buffer, the request payload has been read
+    if (!buildData(data_type, now, payload, &payload_len))
+    {
+      sendAck(type, timestamp, BadAckException::BAD_TYPE, now);
+      return;
+    }
+
+    sendAck(type, timestamp, 0, now);
+    if (freq == 0)
+    {
+      sendData(data_type, payload, payload_len, now);
+    }
+    else if (freq == 0xFFFF)
+    {
+      subscriptions.erase(data_type);
+    }
+    else
+    {
+      Subscription &sub = subscriptions[data_type];
+      sub.period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / freq));
+      sub.next = now + sub.period;
+    }
+  }
+
+  bool McuEmulator::buildData(uint16_t type, Clock::time_point now, uint8_t *payload, size_t *payload_len)
+  {
+    size_t len = 0;
+
+    switch (type)
+    {
+      case DATA_ECHO:
+        break;
+
+      case DATA_SYSTEM_STATUS:
+        utob(payload, 4, mcuTime(now));
+        len = 4;
+        len += putScaled(payload + len, SYSTEM_VOLTAGES, 100.0);
+        len += putScaled(payload + len, SYSTEM_CURRENTS, 100.0);
+        len += putScaled(payload + len, SYSTEM_TEMPERATURES, 100.0);
+        break;
+
+      case DATA_POWER_SYSTEM:
+        payload[0] = 1;
+        ftob(payload + 1, 2, BATTERY_CHARGE, 100.0);
+        itob(payload + 3, 2, BATTERY_CAPACITY);
+        payload[5] = BATTERY_DESCRIPTION;
+        len = 6;
+        break;
+
+      case DATA_SAFETY_SYSTEM:
+        utob(payload, 2, static_cast<uint16_t>(0));
+        len = 2;
+        break;
+
+      case DATA_DIFF_WHEEL_SPEEDS:
+        ftob(payload, 2, left_speed, 100.0);
+        ftob(payload + 2, 2, right_speed, 100.0);
+        ftob(payload + 4, 2, 0.0, 100.0);
+        ftob(payload + 6, 2, 0.0, 100.0);
+        len = 8;
+        break;
+
+      case DATA_ENCODER:
+        payload[0] = 2;
+        ftob(payload + 1, 4, left_travel, 1000.0);
+        ftob(payload + 5, 4, right_travel, 1000.0);
+        ftob(payload + 9, 2, left_speed, 1000.0);
+        ftob(payload + 11, 2, right_speed, 1000.0);
+        len = 13;
+        break;
+
+      default:
+        return false;
+    }
+    *payload_len = len;
+    return true;
+  }
+
+  void McuEmulator::sendData(uint16_t type, uint8_t *payload, size_t len, Clock::time_point now)
+  {
+    Message msg(type, payload, len, mcuTime(now));
+    queue(msg, now);
+    data_sent.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void McuEmulator::sendAck(uint16_t type, uint32_t timestamp, uint16_t result, Clock::time_point now)
+  {
+    uint8_t payload[2];
+    utob(payload, 2, result);
+    Message ack(type, payload, sizeof(payload), timestamp);
+    queue(ack, now);
+    acks_sent.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void McuEmulator::queue(Message &msg, Clock::time_point now)
+  {
+    Outgoing out;
+    out.len = msg.toBytes(out.data, sizeof(out.data));
+
+    double delay = active.latency;
+    if (active.jitter > 0.0)
+    {
+      delay += std::uniform_real_distribution<double>(0.0, active.jitter)(rng);
+    }
+    out.due = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay));
+    // A serial line never reorders, so jitter only ever holds frames back
+    if (!outgoing.empty() && out.due < outgoing.back().due)
+    {
+      out.due = outgoing.back().due;
+    }
+
+    if (out.len > 3 && chance(active.corrupt_rate))
+    {
+      // Leave SOH and the length intact so the host frames it and fails the CRC
+      size_t at = 3 + std::uniform_int_distribution<size_t>(0, out.len - 4)(rng);
+      out.data[at] ^= 0x10;
+      corrupted.fetch_add(1, std::memory_order_relaxed);
+    }
+    outgoing.push_back(out);
+  }
+
+  void McuEmulator::serviceSubscriptions(Clock::time_point now)
+  {
+    for (std::map<uint16_t, Subscription>::iterator it = subscriptions.begin(); it != subscriptions.end(); ++it)
+    {
+      Subscription &sub = it->second;
+      if (sub.next > now)
+      {
+        continue;
+      }
+      uint8_t payload[Message::MAX_MSG_LENGTH];
+      size_t len;
+      buildData(it->first, now, payload, &len);
+      sendData(it->first, payload, len, now);
+      sub.next += sub.period;
+      if (sub.next <= now)
+      {
+        // Fell behind, e.g. the host stopped reading; don't burst to catch up
+        sub.next = now + sub.period;
+      }
+    }
+  }
+
+  void McuEmulator::flushDue(Clock::time_point now)
+  {
+    while (!outgoing.empty() && outgoing.front().due <= now)
+    {
+      const Outgoing &out = outgoing.front();
+      size_t written = 0;
+      while (written < out.len)
+      {
+        ssize_t n = ::write(master, out.data + written, out.len - written);
+        if (n <= 0)
+        {
+          break;
+        }
+        written += static_cast<size_t>(n);
+      }
+      outgoing.pop_front();
+    }
+  }
+
+} // namespace clearpath
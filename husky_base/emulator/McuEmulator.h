@@ -0,0 +1,169 @@
+/**
+Software License Agreement (BSD)
+
+\file      McuEmulator.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_MCU_EMULATOR_H
+#define CLEARPATH_MCU_EMULATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "husky_base/horizon_legacy/FrameScanner.h"
+#include "husky_base/horizon_legacy/Message.h"
+
+namespace clearpath
+{
+
+/**
+* Stand-in for the Husky MCU on a pseudo-terminal, for exercising the
+* Transport, the wrapper and HuskyHardware without a robot. Point the driver
+* at portName() and it sees a Horizon device which:
+*  - acks every command and request, with BAD_CHECKSUM for corrupted frames
+*    and BAD_TYPE for requests it has no data for;
+*  - answers one-off requests and streams subscriptions at their frequency;
+*  - integrates SetDifferentialSpeed commands into encoder travel.
+* Latency, dropped frames and CRC corruption can be injected through Faults.
+*/
+  class McuEmulator
+  {
+  public:
+    struct Faults
+    {
+      double latency;       // seconds added before every frame sent to the host
+      double jitter;        // up to this many seconds more, uniformly distributed
+      double drop_rate;     // probability of ignoring a frame from the host, no ack either
+      double corrupt_rate;  // probability of flipping a bit in a frame sent to the host
+      double clock_drift;   // rate error of the MCU's timestamp clock, e.g. 50e-6 runs 50 ppm fast
+
+      Faults() : latency(0.0), jitter(0.0), drop_rate(0.0), corrupt_rate(0.0), clock_drift(0.0)
+      {
+      }
+    };
+
+    struct Stats
+    {
+      unsigned long frames_received;
+      unsigned long acks_sent;
+      unsigned long data_sent;
+      unsigned long dropped;
+      unsigned long corrupted;
+    };
+
+    explicit McuEmulator(unsigned int seed = 1);
+
+    ~McuEmulator();
+
+    /**
+    * Open the pseudo-terminal and start answering on it.
+    * @return false if no pseudo-terminal could be opened.
+    */
+    bool start();
+
+    void stop();
+
+    /**
+    * Device the driver should open, valid after start().
+    */
+    const char *portName() const
+    {
+      return port_name;
+    }
+
+    void setFaults(const Faults &faults);
+
+    Stats stats() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Outgoing
+    {
+      Clock::time_point due;
+      size_t len;
+      uint8_t data[Message::MAX_MSG_LENGTH];
+    };
+
+    struct Subscription
+    {
+      Clock::duration period;
+      Clock::time_point next;
+    };
+
+    void threadMain();
+
+    void handleFrame(const uint8_t *frame, size_t len, Clock::time_point now);
+
+    void sendAck(uint16_t type, uint32_t timestamp, uint16_t result, Clock::time_point now);
+
+    bool buildData(uint16_t type, Clock::time_point now, uint8_t *payload, size_t *payload_len);
+
+    void sendData(uint16_t type, uint8_t *payload, size_t len, Clock::time_point now);
+
+    void queue(Message &msg, Clock::time_point now);
+
+    void flushDue(Clock::time_point now);
+
+    void serviceSubscriptions(Clock::time_point now);
+
+    void advance(Clock::time_point now);
+
+    bool chance(double probability);
+
+    uint32_t mcuTime(Clock::time_point now);
+
+    int master;
+    int slave;
+    char port_name[64];
+
+    std::thread thread;
+    std::atomic<bool> running;
+
+    mutable std::mutex faults_mutex;
+    Faults faults;
+
+    // Only touched from the emulator thread
+    FrameScanner scanner;
+    std::deque<Outgoing> outgoing;
+    std::map<uint16_t, Subscription> subscriptions;
+    std::mt19937 rng;
+    Faults active;
+    double left_speed, right_speed;    // m/s, as last commanded
+    double left_travel, right_travel;  // m
+    Clock::time_point started, last_advance;
+
+    std::atomic<unsigned long> frames_received;
+    std::atomic<unsigned long> acks_sent;
+    std::atomic<unsigned long> data_sent;
+    std::atomic<unsigned long> dropped;
+    std::atomic<unsigned long> corrupted;
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_MCU_EMULATOR_H
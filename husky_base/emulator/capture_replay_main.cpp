@@ -0,0 +1,162 @@
+/**
+Software License Agreement (BSD)
+
+\file      capture_replay_main.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <map>
+#include <thread>
+
+#include "husky_base/horizon_legacy/CaptureReplay.h"
+#include "husky_base/horizon_legacy/clearpath.h"
+
+namespace
+{
+  // Input must have been quiet this long after the replay finished before stopping
+  const std::chrono::milliseconds SETTLE_TIME(200);
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "Usage: %s CAPTURE [--speed X] [--rx-thread]\n"
+            "Feeds the MCU side of a capture taken with Transport::startCapture() through\n"
+            "Transport and reports what it parsed.\n"
+            "  --speed X     replay at X times the recorded pace, 0 (default) as fast as possible\n"
+            "  --rx-thread   receive on Transport's background RX thread\n",
+            argv0);
+  }
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+  const char *path = argv[1];
+  double speed = 0.0;
+  bool rx_thread = false;
+  for (int i = 2; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "--speed") && i + 1 < argc)
+    {
+      speed = atof(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "--rx-thread"))
+    {
+      rx_thread = true;
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  clearpath::CaptureFile capture;
+  if (!capture.open(path))
+  {
+    fprintf(stderr, "%s is not a readable capture file\n", path);
+    return 1;
+  }
+  uint64_t first_ns = 0, last_ns = 0;
+  unsigned long rx_chunks = 0, tx_chunks = 0;
+  clearpath::CaptureFile::Record record;
+  while (capture.next(record))
+  {
+    if (!first_ns) { first_ns = record.stamp_ns; }
+    last_ns = record.stamp_ns;
+    ++(record.direction == clearpath::CAPTURE_RX ? rx_chunks : tx_chunks);
+  }
+  capture.close();
+
+  clearpath::CaptureReplay replay;
+  if (!replay.open(path))
+  {
+    fprintf(stderr, "Could not open a pseudo-terminal to replay on\n");
+    return 1;
+  }
+
+  clearpath::Transport &transport = clearpath::Transport::instance();
+  try
+  {
+    transport.enableRxThread(rx_thread);
+    transport.configure(replay.portName(), 0);
+  }
+  catch (clearpath::Exception *ex)
+  {
+    fprintf(stderr, "Transport failed on %s: %s\n", replay.portName(), ex->message);
+    delete ex;
+    return 1;
+  }
+
+  std::map<uint16_t, unsigned long> messages;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point last_input = start;
+  replay.play(speed);
+
+  unsigned long received = 0;
+  while (true)
+  {
+    // Returns on input or timeout alike, progress shows in the byte counter
+    transport.waitForInput(std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+    transport.poll();
+    while (clearpath::Message *msg = transport.popNext())
+    {
+      ++messages[msg->getType()];
+      delete msg;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (transport.getCounter(clearpath::Transport::RX_BYTES) != received)
+    {
+      received = transport.getCounter(clearpath::Transport::RX_BYTES);
+      last_input = now;
+    }
+    else if (replay.finished() && now - last_input > SETTLE_TIME)
+    {
+      break;
+    }
+  }
+  double elapsed = std::chrono::duration<double>(last_input - start).count();
+  double recorded = (last_ns - first_ns) * 1e-9;
+  replay.stop();
+
+  printf("%s: %.3f s recorded, %lu RX and %lu TX chunks\n", path, recorded, rx_chunks, tx_chunks);
+  printf("Replayed %lu bytes in %.3f s (%.1fx real time)\n", replay.bytesReplayed(), elapsed,
+         elapsed > 0 ? recorded / elapsed : 0.0);
+  // Queues keep the latest sample per type, so these count what a consumer polling as fast as it can would see
+  printf("Messages delivered:\n");
+  for (std::map<uint16_t, unsigned long>::const_iterator it = messages.begin(); it != messages.end(); ++it)
+  {
+    printf("  type 0x%04x: %lu\n", it->first, it->second);
+  }
+  transport.printCounters();
+  transport.close();
+  return 0;
+}
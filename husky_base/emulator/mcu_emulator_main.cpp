@@ -0,0 +1,147 @@
+/**
+Software License Agreement (BSD)
+
+\file      mcu_emulator_main.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "McuEmulator.h"
+
+namespace
+{
+  volatile sig_atomic_t g_stop = 0;
+
+  void onSignal(int)
+  {
+    g_stop = 1;
+  }
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "Usage: %s [--link PATH] [--latency S] [--jitter S] [--drop P] [--corrupt P] [--drift PPM] [--seed N]\n"
+            "Emulates a Husky MCU on a pseudo-terminal until interrupted.\n"
+            "  --link PATH   also make PATH a symlink to the pseudo-terminal\n"
+            "  --latency S   delay every frame to the host by S seconds\n"
+            "  --jitter S    delay frames by up to S seconds more\n"
+            "  --drop P      ignore frames from the host with probability P\n"
+            "  --corrupt P   corrupt frames to the host with probability P\n"
+            "  --drift PPM   run the MCU clock PPM parts per million fast\n",
+            argv0);
+  }
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  clearpath::McuEmulator::Faults faults;
+  const char *link = NULL;
+  unsigned int seed = 1;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if (!value)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+    if (!strcmp(argv[i], "--link"))
+    {
+      link = value;
+    }
+    else if (!strcmp(argv[i], "--latency"))
+    {
+      faults.latency = atof(value);
+    }
+    else if (!strcmp(argv[i], "--jitter"))
+    {
+      faults.jitter = atof(value);
+    }
+    else if (!strcmp(argv[i], "--drop"))
+    {
+      faults.drop_rate = atof(value);
+    }
+    else if (!strcmp(argv[i], "--corrupt"))
+    {
+      faults.corrupt_rate = atof(value);
+    }
+    else if (!strcmp(argv[i], "--drift"))
+    {
+      faults.clock_drift = atof(value) * 1e-6;
+    }
+    else if (!strcmp(argv[i], "--seed"))
+    {
+      seed = static_cast<unsigned int>(strtoul(value, NULL, 0));
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+    ++i;
+  }
+
+  clearpath::McuEmulator emulator(seed);
+  emulator.setFaults(faults);
+  if (!emulator.start())
+  {
+    perror("openpty");
+    return 1;
+  }
+  if (link)
+  {
+    unlink(link);
+    if (symlink(emulator.portName(), link) < 0)
+    {
+      perror("symlink");
+      return 1;
+    }
+  }
+  printf("Emulating Husky MCU on %s\n", link ? link : emulator.portName());
+  fflush(stdout);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  while (!g_stop)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  emulator.stop();
+  if (link)
+  {
+    unlink(link);
+  }
+
+  clearpath::McuEmulator::Stats stats = emulator.stats();
+  printf("Frames received %lu, acks sent %lu, data sent %lu, dropped %lu, corrupted %lu\n",
+         stats.frames_received, stats.acks_sent, stats.data_sent, stats.dropped, stats.corrupted);
+  return 0;
+}
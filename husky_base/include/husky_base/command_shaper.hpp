@@ -0,0 +1,95 @@
+/**
+Software License Agreement (BSD)
+
+\file      command_shaper.hpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef HUSKY_BASE__COMMAND_SHAPER_HPP_
+#define HUSKY_BASE__COMMAND_SHAPER_HPP_
+
+#include <atomic>
+#include <chrono>
+
+namespace husky_base
+{
+
+/**
+* Decides which wheel speed commands actually go to the MCU. A command which
+* is within tolerance of the last one sent is held back, until keepalive has
+* passed since that send; the MCU stops the wheels if it goes too long
+* without a command (SAFETY_TIMEOUT), so keepalive must stay well below its
+* timeout. Stopping (both speeds exactly zero) is never held back. With no
+* keepalive set, every command is sent. Used from the control thread; the
+* counters may be read from any thread.
+*/
+class CommandShaper
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  CommandShaper();
+
+  /**
+  * @param tolerance  Largest change in either speed, in m/s, which is not worth sending
+  * @param keepalive  Longest time between sends, in seconds; 0 sends every command
+  */
+  void configure(double tolerance, double keepalive);
+
+  /**
+  * Make the next command go out whatever it is, e.g. after a reconnect or a
+  * change in the MCU's safety state.
+  */
+  void reset();
+
+  /**
+  * Whether to send this command now. Counts it as skipped if not.
+  */
+  bool shouldSend(double left, double right, Clock::time_point now);
+
+  /**
+  * Note that a command was sent (and acknowledged, for blocking sends).
+  */
+  void sent(double left, double right, Clock::time_point now);
+
+  unsigned long sentCount() const
+  {
+    return sent_.load(std::memory_order_relaxed);
+  }
+
+  unsigned long skippedCount() const
+  {
+    return skipped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  double tolerance_;
+  Clock::duration keepalive_;
+
+  bool pending_reset_;
+  double last_left_, last_right_;
+  Clock::time_point last_sent_;
+
+  std::atomic<unsigned long> sent_, skipped_;
+};
+
+}  // namespace husky_base
+
+#endif  // HUSKY_BASE__COMMAND_SHAPER_HPP_
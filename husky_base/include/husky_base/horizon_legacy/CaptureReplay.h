@@ -0,0 +1,97 @@
+/**
+Software License Agreement (BSD)
+
+\file      CaptureReplay.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_CAPTURE_REPLAY_H
+#define CLEARPATH_CAPTURE_REPLAY_H
+
+#include <atomic>
+#include <thread>
+
+#include "husky_base/horizon_legacy/FrameCapture.h"
+
+namespace clearpath
+{
+
+/**
+* Plays the MCU side of a capture file back on a pseudo-terminal, so Transport
+* can be configured on portName() and receive exactly the bytes it received
+* when the capture was taken. Whatever Transport writes is read and discarded.
+* With a speed of 0 the capture plays as fast as the reader keeps up,
+* otherwise at that multiple of the recorded pace.
+*/
+  class CaptureReplay
+  {
+  public:
+    CaptureReplay();
+
+    ~CaptureReplay();
+
+    /**
+    * Open the capture and the pseudo-terminal. Playback only begins with play(),
+    * so the reader can open the port first without missing anything.
+    * @return false if either can't be opened.
+    */
+    bool open(const char *capture_path);
+
+    void play(double speed);
+
+    void stop();
+
+    bool finished() const
+    {
+      return done.load(std::memory_order_acquire);
+    }
+
+    const char *portName() const
+    {
+      return port_name;
+    }
+
+    unsigned long bytesReplayed() const
+    {
+      return replayed.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static const int WAKEUP_MS = 10;
+
+    void threadMain(double speed);
+
+    bool writeAll(const uint8_t *data, size_t len);
+
+    void discardInput();
+
+    CaptureFile capture;
+    int master;
+    char port_name[64];
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<bool> done;
+    std::atomic<unsigned long> replayed;
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_CAPTURE_REPLAY_H
@@ -0,0 +1,188 @@
+/**
+Software License Agreement (BSD)
+
+\file      ClockSync.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_CLOCK_SYNC_H
+#define CLEARPATH_CLOCK_SYNC_H
+
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <stdint.h>
+
+#include "husky_base/horizon_legacy/LatencyHistogram.h"
+
+namespace clearpath
+{
+
+/**
+* Online estimate of the MCU clock against the host's monotonic clock, from
+* the millisecond timestamp every data frame carries and the time the frame
+* was read off the port. Passive: nothing is sent to the MCU.
+*
+* Each frame gives host receive time minus MCU time, which is the clock
+* offset plus however long the frame took to get here. The smallest of those
+* per second of MCU time are the frames that were least delayed; a line
+* fitted under them gives offset and drift. What the line cannot see is the
+* constant part of the delay, which is taken as half the shortest ack round
+* trip (less wire time), as in NTP.
+*
+* addSample(), addRoundTrip() and toHost() belong to one thread, the one
+* consuming the Transport's messages; estimate() and linkLatency() may be
+* used from any thread.
+*/
+  class ClockSync
+  {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Estimate
+    {
+      bool synced;
+      double offset;      // host minus MCU clock at the latest sample, seconds
+      double drift;       // rate of the MCU clock relative to the host's, minus one
+      double path_delay;  // one-way delay from MCU timestamp to first byte on the wire, seconds
+      unsigned long samples;
+      unsigned long resets;  // MCU clock jumps (reboot, SetPlatformTime) that restarted the estimate
+    };
+
+    ClockSync();
+
+    /**
+    * Forget everything measured, e.g. when the port is reopened.
+    */
+    void reset();
+
+    /**
+    * Line rate of the port, for the time a frame spends on the wire. 8-N-1 is assumed.
+    */
+    void setBaud(int baud);
+
+    /**
+    * Account for one data frame.
+    * @param mcu_ms     The frame's timestamp field
+    * @param rx_time    When the read completing the frame returned
+    * @param frame_len  Total frame length in bytes
+    */
+    void addSample(uint32_t mcu_ms, Clock::time_point rx_time, size_t frame_len);
+
+    /**
+    * Account for one acked message, from writing it to reading its ack.
+    */
+    void addRoundTrip(Clock::duration rtt, size_t tx_len, size_t rx_len);
+
+    bool synced() const
+    {
+      return fit.synced;
+    }
+
+    /**
+    * Host time at which the MCU took a sample stamped mcu_ms. Until the
+    * estimate has settled, and for anything implausible, this is rx_time;
+    * it is never later than rx_time.
+    */
+    Clock::time_point toHost(uint32_t mcu_ms, Clock::time_point rx_time) const;
+
+    /**
+    * Latest fit, refreshed about once a second of MCU time.
+    */
+    Estimate estimate() const;
+
+    /**
+    * Time from MCU timestamp to host receipt of every data frame since synced.
+    */
+    LatencyHistogram &linkLatency()
+    {
+      return link_latency;
+    }
+
+  private:
+    static const size_t MAX_BUCKETS = 64;
+    static const size_t MIN_BUCKETS = 3;
+    static const unsigned long RTT_WINDOW = 128;
+
+    // Lowest delay seen in one stretch of MCU time; times relative to the first sample
+    struct Bucket
+    {
+      double x;  // MCU time, seconds
+      double d;  // host minus MCU time, seconds
+    };
+
+    // Line d = offset + drift * x under the buckets
+    struct Fit
+    {
+      bool synced;
+      double offset;
+      double drift;
+    };
+
+    void restart();
+
+    void refit();
+
+    double wireTime(size_t len) const
+    {
+      return len * wire_byte_time;
+    }
+
+    int64_t unwrap(uint32_t mcu_ms) const
+    {
+      return last_mcu_ms + static_cast<int32_t>(mcu_ms - last_raw_ms);
+    }
+
+    double wire_byte_time;
+
+    bool started;
+    uint32_t last_raw_ms;
+    int64_t last_mcu_ms;
+    int64_t origin_mcu_ms;
+    int64_t origin_host_ns;
+    double last_d;
+
+    Bucket buckets[MAX_BUCKETS];
+    size_t num_buckets;
+    size_t next_bucket;
+    Bucket current;
+    double current_start;
+    unsigned long current_count;
+
+    Fit fit;
+
+    // Windowed minimum of round trip minus wire time
+    double rtt_min, rtt_window_min;
+    unsigned long rtt_count;
+    double path_delay;
+
+    unsigned long samples;
+    unsigned long resets;
+
+    LatencyHistogram link_latency;
+
+    mutable std::mutex published_mutex;
+    Estimate published;
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_CLOCK_SYNC_H
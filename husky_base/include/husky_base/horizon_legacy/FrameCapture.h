@@ -0,0 +1,197 @@
+/**
+Software License Agreement (BSD)
+
+\file      FrameCapture.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_FRAME_CAPTURE_H
+#define CLEARPATH_FRAME_CAPTURE_H
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+#include "husky_base/horizon_legacy/Message.h"
+#include "husky_base/horizon_legacy/MpscRing.h"
+
+namespace clearpath
+{
+
+/**
+* Capture file layout. Everything is little endian and 8 byte aligned, so a
+* mapped file can be walked in place:
+*   CaptureFileHeader
+*   CaptureRecordHeader, len bytes of data, zero padding up to 8 bytes
+*   ...
+* Records hold the raw bytes of one read from or write to the port, split
+* into chunks of at most CAPTURE_MAX_CHUNK. A file cut short by a crash is
+* still readable up to its last complete record.
+*/
+  static const char CAPTURE_MAGIC[8] = {'H', 'Z', 'N', 'C', 'A', 'P', '\0', '\0'};
+  static const uint32_t CAPTURE_VERSION = 1;
+  static const size_t CAPTURE_MAX_CHUNK = Message::MAX_MSG_LENGTH;
+
+  enum captureDirection
+  {
+    CAPTURE_RX = 0,  // read from the MCU
+    CAPTURE_TX = 1   // written to the MCU
+  };
+
+  struct CaptureFileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_len;  // sizeof(CaptureFileHeader), records start here
+    uint64_t start_ns;    // steady clock when the capture was opened
+  };
+
+  struct CaptureRecordHeader
+  {
+    uint64_t stamp_ns;    // steady clock when the bytes were read or written
+    uint16_t len;
+    uint8_t direction;    // captureDirection
+    uint8_t reserved[5];
+  };
+
+  inline size_t captureRecordSize(size_t len)
+  {
+    return sizeof(CaptureRecordHeader) + ((len + 7) & ~static_cast<size_t>(7));
+  }
+
+/**
+* Optional recorder of everything Transport reads from and writes to the port.
+* record() copies into a lock-free ring and may be called from the RX thread
+* and the caller's thread at once; a writer thread drains the ring into the
+* file. If the writer can't keep up, records are dropped and counted rather
+* than ever stalling the link.
+*/
+  class FrameCapture
+  {
+  public:
+    FrameCapture();
+
+    ~FrameCapture();
+
+    // The ring is cache line aligned, which plain operator new doesn't honour before C++17
+    static void *operator new(size_t size);
+
+    static void operator delete(void *ptr);
+
+    /**
+    * Start appending to path, truncating it. Closes any previous capture.
+    * @return false if the file could not be created.
+    */
+    bool open(const char *path);
+
+    void close();
+
+    bool isOpen() const
+    {
+      return active.load(std::memory_order_relaxed);
+    }
+
+    void record(enum captureDirection direction, const uint8_t *data, size_t len);
+
+    unsigned long recorded() const
+    {
+      return recorded_count.load(std::memory_order_relaxed);
+    }
+
+    unsigned long dropped() const
+    {
+      return dropped_count.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Chunk
+    {
+      CaptureRecordHeader header;
+      uint8_t data[CAPTURE_MAX_CHUNK];
+    };
+
+    static const size_t RING_LEN = 1024;
+    static const int WRITER_WAKEUP_MS = 10;
+
+    void writerMain();
+
+    bool drain();
+
+    FILE *file;
+    std::thread writer;
+    std::atomic<bool> active;
+    std::atomic<bool> writer_running;
+    std::atomic<unsigned long> recorded_count;
+    std::atomic<unsigned long> dropped_count;
+    MpscRing<Chunk, RING_LEN> ring;
+  };
+
+/**
+* Read-only view of a capture file, mapped into memory.
+*/
+  class CaptureFile
+  {
+  public:
+    struct Record
+    {
+      uint64_t stamp_ns;
+      enum captureDirection direction;
+      const uint8_t *data;
+      size_t len;
+    };
+
+    CaptureFile();
+
+    ~CaptureFile();
+
+    /**
+    * Map path and check its header.
+    * @return false if it can't be read or isn't a capture file.
+    */
+    bool open(const char *path);
+
+    void close();
+
+    uint64_t startTime() const;
+
+    /**
+    * Step through the records in order.
+    * @return false at the end of the file, or at a truncated record.
+    */
+    bool next(Record &record);
+
+    void rewind()
+    {
+      offset = sizeof(CaptureFileHeader);
+    }
+
+  private:
+    const uint8_t *base;
+    size_t size;
+    size_t offset;
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_FRAME_CAPTURE_H
@@ -0,0 +1,97 @@
+/**
+Software License Agreement (BSD)
+
+\file      FrameScanner.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_FRAME_SCANNER_H
+#define CLEARPATH_FRAME_SCANNER_H
+
+#include <cstdlib>
+#include <stdint.h>
+
+namespace clearpath
+{
+
+/**
+* Staging buffer for raw serial input which locates Horizon frames in place.
+* Bytes are appended in bulk (straight from read(2), or from memory), and
+* complete SOH / length / ~length delimited frames are handed out as pointers
+* into the buffer, so nothing is copied until a Message is built from them.
+* CRC and format checks are left to Message::isValid().
+*/
+  class FrameScanner
+  {
+  public:
+    static const size_t BUFFER_LEN = 4096;
+
+    FrameScanner();
+
+    /**
+    * Make room for new input and return how many bytes may be written
+    * at writePointer(). Invalidates frames previously returned by nextFrame().
+    */
+    size_t prepare();
+
+    uint8_t *writePointer()
+    {
+      return buf + tail;
+    }
+
+    /**
+    * Account for n bytes written at writePointer().
+    */
+    void commit(size_t n);
+
+    /**
+    * Copy up to len bytes into the buffer. Returns the number of bytes taken.
+    */
+    size_t append(const void *data, size_t len);
+
+    /**
+    * Locate the next complete frame in the buffered input.
+    * @param frame     Set to the start of the frame, valid until the next prepare()/append()
+    * @param len       Set to the total frame length
+    * @param garbled   Incremented by the number of bytes discarded while resynchronizing
+    * @return true if a frame was found, false if more input is needed.
+    */
+    bool nextFrame(const uint8_t **frame, size_t *len, unsigned long *garbled);
+
+    size_t buffered() const
+    {
+      return tail - head;
+    }
+
+    void reset()
+    {
+      head = tail = 0;
+    }
+
+  private:
+    uint8_t buf[BUFFER_LEN];
+    size_t head;  // first byte not yet consumed
+    size_t tail;  // one past the last byte received
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_FRAME_SCANNER_H
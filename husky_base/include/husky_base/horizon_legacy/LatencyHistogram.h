@@ -0,0 +1,125 @@
+/**
+Software License Agreement (BSD)
+
+\file      LatencyHistogram.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_LATENCY_HISTOGRAM_H
+#define CLEARPATH_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdint.h>
+
+namespace clearpath
+{
+
+/**
+* Log-bucketed histogram of durations in microseconds, four buckets per
+* power of two (so a bucket is within 25% of its values), from 1us to
+* about a minute. record() is lock-free and allocation-free and may be
+* called from any thread; collect() hands everything recorded since the
+* previous collect() to a single reader, e.g. a diagnostics task.
+*/
+  class LatencyHistogram
+  {
+  public:
+    static const size_t SUB_BUCKETS = 4;
+    static const size_t NUM_BUCKETS = 104;
+
+    struct Snapshot
+    {
+      uint32_t counts[NUM_BUCKETS];
+      uint64_t sum_us;
+      uint64_t max_us;
+
+      Snapshot();
+
+      uint64_t count() const;
+
+      double mean() const;
+
+      /**
+      * Upper edge of the bucket holding the p'th fraction (0.0 - 1.0) of the
+      * samples, capped at the largest sample. 0 if there are no samples.
+      */
+      double percentile(double p) const;
+    };
+
+    /**
+    * Records the time from construction to destruction.
+    */
+    class Scope
+    {
+    public:
+      explicit Scope(LatencyHistogram &histogram) :
+          histogram(histogram), start(std::chrono::steady_clock::now())
+      {
+      }
+
+      ~Scope()
+      {
+        histogram.record(std::chrono::steady_clock::now() - start);
+      }
+
+    private:
+      LatencyHistogram &histogram;
+      std::chrono::steady_clock::time_point start;
+    };
+
+    LatencyHistogram();
+
+    void record(std::chrono::steady_clock::duration elapsed)
+    {
+      int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+      recordMicros(us > 0 ? static_cast<uint64_t>(us) : 0);
+    }
+
+    void recordMicros(uint64_t us)
+    {
+      counts[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+      sum_us.fetch_add(us, std::memory_order_relaxed);
+      uint64_t seen = max_us.load(std::memory_order_relaxed);
+      while (us > seen && !max_us.compare_exchange_weak(seen, us, std::memory_order_relaxed))
+      {
+      }
+    }
+
+    /**
+    * Move the samples recorded since the last call into snapshot.
+    */
+    void collect(Snapshot &snapshot);
+
+    static size_t bucketOf(uint64_t us);
+
+    static uint64_t bucketUpperEdge(size_t bucket);
+
+  private:
+    std::atomic<uint32_t> counts[NUM_BUCKETS];
+    std::atomic<uint64_t> sum_us;
+    std::atomic<uint64_t> max_us;
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_LATENCY_HISTOGRAM_H
@@ -47,21 +47,145 @@
 #ifndef CPR_LOGGER_H
 #define CPR_LOGGER_H
 
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <stdint.h>
+
+#include "husky_base/horizon_legacy/MpscRing.h"
 
 namespace clearpath
 {
 
-  class Logger
+/*
+ * Fixed-size binary log record. The format string and file name are kept by
+ * pointer, so they must be literals; arguments are stored by value, strings
+ * copied (truncated) into the record, and formatting is left to whichever
+ * thread drains the records.
+ */
+  struct LogRecord
   {
-  private:
-    bool enabled;
-    int level;
+    static const size_t MAX_ARGS = 8;
+    static const size_t TEXT_LEN = 96;
 
-    std::ostream *stream;
+    enum argKinds
+    {
+      ARG_INT,
+      ARG_UINT,
+      ARG_DOUBLE,
+      ARG_STRING,   // offset into text
+      ARG_POINTER
+    };
 
-    std::ofstream *nullStream; //i.e /dev/null
+    union Value
+    {
+      long long i;
+      unsigned long long u;
+      double d;
+      const void *p;
+      size_t text_offset;
+    };
+
+    const char *format;
+    const char *file;
+    int line;
+    uint8_t level;
+    uint8_t num_args;
+    uint8_t text_len;
+    uint32_t suppressed;  // similar messages held back by a CPR_ALOG_THROTTLE before this one
+    uint8_t kinds[MAX_ARGS];
+    Value values[MAX_ARGS];
+    char text[TEXT_LEN];
+
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type add(T value)
+    {
+      if (num_args == MAX_ARGS) { return; }
+      if (std::is_signed<T>::value)
+      {
+        kinds[num_args] = ARG_INT;
+        values[num_args++].i = static_cast<long long>(value);
+      }
+      else
+      {
+        kinds[num_args] = ARG_UINT;
+        values[num_args++].u = static_cast<unsigned long long>(value);
+      }
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type add(T value)
+    {
+      if (num_args == MAX_ARGS) { return; }
+      kinds[num_args] = ARG_DOUBLE;
+      values[num_args++].d = value;
+    }
+
+    template<typename T>
+    void add(T *value)
+    {
+      if (num_args == MAX_ARGS) { return; }
+      kinds[num_args] = ARG_POINTER;
+      values[num_args++].p = value;
+    }
+
+    void add(const char *value);
+
+    void add(char *value)
+    {
+      add(static_cast<const char *>(value));
+    }
+
+    void add(const std::string &value)
+    {
+      add(value.c_str());
+    }
+
+    /**
+    * Expand the record's printf-style format into buf, always NUL terminated.
+    */
+    size_t format_to(char *buf, size_t buf_len) const;
+  };
+
+/*
+ * Per call site state of CPR_ALOG_THROTTLE.
+ */
+  class LogThrottle
+  {
+  public:
+    LogThrottle() : next_ns(0), suppressed(0)
+    {
+    }
+
+    /**
+    * @return true if the message should go out now; held-back count in *held.
+    */
+    bool allow(double period, uint32_t *held)
+    {
+      int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+      int64_t next = next_ns.load(std::memory_order_relaxed);
+      if (now < next ||
+          !next_ns.compare_exchange_strong(next, now + static_cast<int64_t>(period * 1e9), std::memory_order_relaxed))
+      {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      *held = suppressed.exchange(0, std::memory_order_relaxed);
+      return true;
+    }
 
+  private:
+    std::atomic<int64_t> next_ns;
+    std::atomic<uint32_t> suppressed;
+  };
+
+  class Logger
+  {
   public:
     enum logLevels
     {
@@ -73,6 +197,25 @@ namespace clearpath
     };
     static const char *levelNames[]; // strings indexed by enumeration.
 
+    // Receives formatted text from log(); called on the drain thread in async mode
+    typedef void (*Sink)(enum logLevels level, const char *file, int line, const char *text);
+
+  private:
+    std::atomic<bool> enabled;
+    std::atomic<int> level;
+
+    std::ostream *stream;
+
+    std::ofstream *nullStream; //i.e /dev/null
+
+    static const size_t RING_LEN = 1024;
+    static const int DRAIN_PERIOD_MS = 5;
+    MpscRing<LogRecord, RING_LEN> ring;
+    std::atomic<unsigned long> dropped;
+    std::atomic<bool> async_running;
+    std::thread drain_thread;
+    Sink sink;
+
   private:
     Logger();
 
@@ -80,11 +223,64 @@ namespace clearpath
 
     void close();
 
+    void submit(const LogRecord &record);
+
+    void deliver(const LogRecord &record);
+
+    void drain();
+
+    void drainThreadMain();
+
   public:
     static Logger &instance();
 
     std::ostream &entry(enum logLevels level, const char *file = 0, int line = -1);
 
+    bool enabledFor(enum logLevels msg_level)
+    {
+      return enabled.load(std::memory_order_relaxed) && msg_level <= level.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * Log a printf-style message without formatting it on the calling thread.
+    * In async mode the record goes into a lock-free ring and is formatted and
+    * written by a background thread; a full ring drops the record (counted and
+    * reported later) rather than blocking. Without async mode the message is
+    * formatted and written straight away.
+    */
+    template<typename... Args>
+    void log(enum logLevels msg_level, const char *file, int line, uint32_t suppressed,
+             const char *format, const Args &... args)
+    {
+      LogRecord record;
+      record.format = format;
+      record.file = file;
+      record.line = line;
+      record.level = static_cast<uint8_t>(msg_level);
+      record.num_args = 0;
+      record.text_len = 0;
+      record.suppressed = suppressed;
+      (void) std::initializer_list<int>{0, (record.add(args), 0)...};
+      submit(record);
+    }
+
+    void setAsync(bool async);
+
+    bool isAsync()
+    {
+      return async_running;
+    }
+
+    /**
+    * Where log() output goes, the stream from setStream() if null. Set before enabling async mode.
+    */
+    void setSink(Sink new_sink);
+
+    unsigned long droppedRecords()
+    {
+      return dropped.load(std::memory_order_relaxed);
+    }
+
     void setEnabled(bool enabled);
 
     void setLevel(enum logLevels newLevel);
@@ -108,4 +304,22 @@ namespace clearpath
 #define CPR_INFO()     CPR_LOG(clearpath::Logger::INFO)
 #define CPR_DTL()      CPR_LOG(clearpath::Logger::DETAIL)
 
+// printf-style, formatted off the calling thread in async mode; the format must be a literal
+#define CPR_ALOG(level, ...) \
+    do { \
+        if (clearpath::Logger::instance().enabledFor(level)) { \
+            clearpath::Logger::instance().log((level), __FILE__, __LINE__, 0, __VA_ARGS__); \
+        } \
+    } while (0)
+
+// As CPR_ALOG, but at most once per period seconds from this call site
+#define CPR_ALOG_THROTTLE(level, period, ...) \
+    do { \
+        static clearpath::LogThrottle cpr_log_throttle; \
+        uint32_t cpr_log_held; \
+        if (clearpath::Logger::instance().enabledFor(level) && cpr_log_throttle.allow((period), &cpr_log_held)) { \
+            clearpath::Logger::instance().log((level), __FILE__, __LINE__, cpr_log_held, __VA_ARGS__); \
+        } \
+    } while (0)
+
 #endif //CPR_LOGGER_H
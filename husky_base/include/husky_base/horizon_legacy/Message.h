@@ -47,11 +47,14 @@
 #ifndef CLEARPATH_MESSAGE_H
 #define CLEARPATH_MESSAGE_H
 
+#include <chrono>
 #include <iostream>
 #include <cstdlib>
+#include <new>
 #include <stdint.h>
 
 #include "husky_base/horizon_legacy/Exception.h"
+#include "husky_base/horizon_legacy/MessagePool.h"
 
 
 namespace clearpath
@@ -72,6 +75,24 @@ namespace clearpath
     MessageException(const char *msg, enum errors ex_type = ERROR_BASE);
   };
 
+  /*
+   * Outcome of the non-throwing send and receive calls, Message::trySend() and
+   * Transport::try*(). The throwing versions raise the matching exception instead.
+   */
+  enum transferResult
+  {
+    TRANSFER_OK,
+    TRANSFER_NOT_CONFIGURED,  // Transport not configured (TransportException NOT_CONFIGURED)
+    TRANSFER_UNACKNOWLEDGED,  // retries exhausted without an ack (UNACKNOWLEDGED_SEND)
+    TRANSFER_BAD_ACK,         // acked with an error result code (BadAckException)
+    TRANSFER_TIMED_OUT,       // nothing received before the timeout (null return)
+    TRANSFER_TOO_LONG         // more messages than fit in one batch (ERROR_BASE)
+  };
+
+  const char *transferResultString(enum transferResult result);
+
+  class Transport;
+
   class Message
   {
   public:
@@ -106,6 +127,20 @@ namespace clearpath
     // (Updated by Transport::send())
     bool is_sent;
 
+    // When the read completing this frame returned, zero for messages built in memory
+    // (Set by Transport::rxMessage())
+    std::chrono::steady_clock::time_point rx_time;
+
+    // Result of the last CRC check, so a frame is only checksummed once.
+    // Reset by the setters; code writing through getPayloadPointer() must
+    // finish with makeValid(), as the command constructors do.
+    enum crcStates
+    {
+      CRC_UNCHECKED,
+      CRC_GOOD,
+      CRC_BAD
+    } crc_state;
+
     friend class Transport;  // Allow Transport to read data and total_len directly
 
   public:
@@ -149,8 +184,30 @@ namespace clearpath
 
     virtual ~Message();
 
+    /* Messages created with new (every received frame) live in the MessagePool */
+    static void *operator new(size_t size)
+    {
+      return messagePool().allocate(size);
+    }
+
+    static void operator delete(void *ptr)
+    {
+      messagePool().release(ptr);
+    }
+
     void send();
 
+    enum transferResult trySend(uint16_t *ack_code = 0);
+
+    unsigned long sendAsync(bool supersede = false);
+
+    /* As above, over a given Transport rather than Transport::instance() */
+    void send(Transport &transport);
+
+    enum transferResult trySend(Transport &transport, uint16_t *ack_code = 0);
+
+    unsigned long sendAsync(Transport &transport, bool supersede = false);
+
     uint8_t getLength();  // as reported by packet length field.
     uint8_t getLengthComp();
 
@@ -158,6 +215,11 @@ namespace clearpath
 
     uint32_t getTimestamp();
 
+    std::chrono::steady_clock::time_point getRxTime()
+    {
+      return rx_time;
+    }
+
     uint8_t getFlags();
 
     uint16_t getType();
@@ -202,10 +264,16 @@ namespace clearpath
 
     static Message *factory(void *input, size_t msg_len);
 
+    static Message *factory(void *input, size_t msg_len, const std::nothrow_t &);
+
     static Message *popNext();
 
     static Message *waitNext(double timeout = 0.0);
 
+    static Message *popNext(Transport &transport);
+
+    static Message *waitNext(Transport &transport, double timeout = 0.0);
+
   }; // class Message
 
   enum MessageTypes
@@ -0,0 +1,215 @@
+/**
+Software License Agreement (BSD)
+
+\file      MessagePool.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_MESSAGE_POOL_H
+#define CLEARPATH_MESSAGE_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <stdint.h>
+
+namespace clearpath
+{
+
+/**
+* Fixed-capacity pool of equally sized blocks.
+* allocate() and release() are lock-free and may be called from any thread
+* (the RX thread allocates frames which the caller frees). Blocks are kept on
+* a Treiber stack whose head carries a generation tag to rule out ABA.
+* When the pool is exhausted, or the request is larger than a block, the
+* global heap is used instead and counted, so heapAllocations() staying at
+* zero shows the hot path never reached malloc.
+*/
+  template<size_t BlockSize, size_t NumBlocks>
+  class BlockPool
+  {
+    static_assert(NumBlocks < 0xFFFFFFFFu, "BlockPool index must fit in 32 bits");
+
+  public:
+    static const size_t BLOCK_SIZE = BlockSize;
+    static const size_t NUM_BLOCKS = NumBlocks;
+
+    BlockPool() : pool_allocations(0), heap_allocations(0), in_use(0)
+    {
+      for (size_t i = 0; i < NumBlocks; ++i)
+      {
+        next_free[i].store(static_cast<uint32_t>(i + 1), std::memory_order_relaxed);
+      }
+      free_head.store(0, std::memory_order_release);
+    }
+
+    void *allocate(size_t size)
+    {
+      if (size <= BlockSize)
+      {
+        uint64_t head = free_head.load(std::memory_order_acquire);
+        while (index(head) != EMPTY)
+        {
+          uint32_t next = next_free[index(head)].load(std::memory_order_relaxed);
+          if (free_head.compare_exchange_weak(head, pack(tag(head) + 1, next),
+                                              std::memory_order_acq_rel, std::memory_order_acquire))
+          {
+            pool_allocations.fetch_add(1, std::memory_order_relaxed);
+            in_use.fetch_add(1, std::memory_order_relaxed);
+            return blocks[index(head)].bytes;
+          }
+        }
+      }
+      heap_allocations.fetch_add(1, std::memory_order_relaxed);
+      return ::operator new(size);
+    }
+
+    void release(void *ptr)
+    {
+      if (!ptr)
+      {
+        return;
+      }
+      if (!owns(ptr))
+      {
+        ::operator delete(ptr);
+        return;
+      }
+
+      uint32_t idx = static_cast<uint32_t>(
+          (static_cast<uint8_t *>(ptr) - blocks[0].bytes) / sizeof(Block));
+      uint64_t head = free_head.load(std::memory_order_relaxed);
+      do
+      {
+        next_free[idx].store(index(head), std::memory_order_relaxed);
+      }
+      while (!free_head.compare_exchange_weak(head, pack(tag(head) + 1, idx),
+                                              std::memory_order_release, std::memory_order_relaxed));
+      in_use.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    bool owns(const void *ptr) const
+    {
+      const uint8_t *p = static_cast<const uint8_t *>(ptr);
+      return p >= blocks[0].bytes && p < blocks[0].bytes + sizeof(blocks);
+    }
+
+    unsigned long poolAllocations() const
+    {
+      return pool_allocations.load(std::memory_order_relaxed);
+    }
+
+    unsigned long heapAllocations() const
+    {
+      return heap_allocations.load(std::memory_order_relaxed);
+    }
+
+    unsigned long inUse() const
+    {
+      return in_use.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static const uint32_t EMPTY = static_cast<uint32_t>(NumBlocks);
+
+    static uint32_t index(uint64_t head)
+    {
+      return static_cast<uint32_t>(head);
+    }
+
+    static uint32_t tag(uint64_t head)
+    {
+      return static_cast<uint32_t>(head >> 32);
+    }
+
+    static uint64_t pack(uint32_t tag, uint32_t index)
+    {
+      return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+
+    union Block
+    {
+      alignas(std::max_align_t) uint8_t bytes[BlockSize];
+    };
+
+    Block blocks[NumBlocks];
+    std::atomic<uint32_t> next_free[NumBlocks];
+    std::atomic<uint64_t> free_head;
+
+    std::atomic<unsigned long> pool_allocations;
+    std::atomic<unsigned long> heap_allocations;
+    std::atomic<unsigned long> in_use;
+  };
+
+  // Large enough for any Message subclass, deep enough for a full RX ring plus a backlog
+  typedef BlockPool<320, 2048> MessagePool;
+  // Control blocks of the shared_ptrs that own received Messages
+  typedef BlockPool<64, 4096> NodePool;
+
+  MessagePool &messagePool();
+
+  NodePool &nodePool();
+
+/**
+* Standard allocator drawing from the NodePool, for the control blocks of the
+* shared_ptrs that Channel hands received Messages out in.
+*/
+  template<typename T>
+  struct PoolAllocator
+  {
+    typedef T value_type;
+
+    PoolAllocator()
+    {
+    }
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U> &)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+      return static_cast<T *>(nodePool().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t)
+    {
+      nodePool().release(ptr);
+    }
+  };
+
+  template<typename T, typename U>
+  bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &)
+  {
+    return true;
+  }
+
+  template<typename T, typename U>
+  bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &)
+  {
+    return false;
+  }
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_MESSAGE_POOL_H
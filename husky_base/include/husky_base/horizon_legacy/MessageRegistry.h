@@ -0,0 +1,299 @@
+/**
+Software License Agreement (BSD)
+
+\file      MessageRegistry.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_MESSAGE_REGISTRY_H
+#define CLEARPATH_MESSAGE_REGISTRY_H
+
+#include <cstdlib>
+#include <new>
+#include <stdint.h>
+#include <type_traits>
+
+#include "husky_base/horizon_legacy/Message.h"
+#include "husky_base/horizon_legacy/Message_data.h"
+
+namespace clearpath
+{
+/**
+* One data message known to the library: its type ID and the class that parses it.
+* The matching request is always the data ID less 0x4000.
+*/
+  template<enum MessageTypes ID, typename T>
+  struct MessageEntry
+  {
+    typedef T Class;
+    static const enum MessageTypes type = ID;
+    static const uint16_t request = ID - 0x4000;
+  };
+
+  template<typename... Entries>
+  struct MessageTypeList
+  {
+  };
+
+/**
+* Every data message class, keyed by type ID. Adding a message means writing its class
+* in Message_data.h / Message_data.cpp and listing it here; the factory, the receive
+* queues and Channel<T> all pick it up from this list.
+*/
+  typedef MessageTypeList<
+      MessageEntry<DATA_ACCEL, DataPlatformAcceleration>,
+      MessageEntry<DATA_ACCEL_RAW, DataRawAcceleration>,
+      MessageEntry<DATA_ACKERMANN_SETPTS, DataAckermannOutput>,
+      MessageEntry<DATA_CURRENT_RAW, DataRawCurrent>,
+      MessageEntry<DATA_PLATFORM_NAME, DataPlatformName>,
+      MessageEntry<DATA_DIFF_CTRL_CONSTS, DataDifferentialControl>,
+      MessageEntry<DATA_DIFF_WHEEL_SPEEDS, DataDifferentialSpeed>,
+      MessageEntry<DATA_DIFF_WHEEL_SETPTS, DataDifferentialOutput>,
+      MessageEntry<DATA_DISTANCE_DATA, DataRangefinders>,
+      MessageEntry<DATA_DISTANCE_TIMING, DataRangefinderTimings>,
+      MessageEntry<DATA_ECHO, DataEcho>,
+      MessageEntry<DATA_ENCODER, DataEncoders>,
+      MessageEntry<DATA_ENCODER_RAW, DataEncodersRaw>,
+      MessageEntry<DATA_FIRMWARE_INFO, DataFirmwareInfo>,
+      MessageEntry<DATA_GEAR_SETPT, DataGear>,
+      MessageEntry<DATA_GYRO_RAW, DataRawGyro>,
+      MessageEntry<DATA_MAGNETOMETER, DataPlatformMagnetometer>,
+      MessageEntry<DATA_MAGNETOMETER_RAW, DataRawMagnetometer>,
+      MessageEntry<DATA_MAX_ACCEL, DataMaxAcceleration>,
+      MessageEntry<DATA_MAX_SPEED, DataMaxSpeed>,
+      MessageEntry<DATA_ORIENT, DataPlatformOrientation>,
+      MessageEntry<DATA_ORIENT_RAW, DataRawOrientation>,
+      MessageEntry<DATA_PLATFORM_INFO, DataPlatformInfo>,
+      MessageEntry<DATA_POWER_SYSTEM, DataPowerSystem>,
+      MessageEntry<DATA_PROC_STATUS, DataProcessorStatus>,
+      MessageEntry<DATA_ROT_RATE, DataPlatformRotation>,
+      MessageEntry<DATA_SAFETY_SYSTEM, DataSafetySystemStatus>,
+      MessageEntry<DATA_SYSTEM_STATUS, DataSystemStatus>,
+      MessageEntry<DATA_TEMPERATURE_RAW, DataRawTemperature>,
+      MessageEntry<DATA_VELOCITY_SETPT, DataVelocity>,
+      MessageEntry<DATA_VOLTAGE_RAW, DataRawVoltage>
+  > DataMessageTypes;
+
+  namespace registry
+  {
+    // Open-addressed type ID -> list index table, filled at compile time
+    static const size_t TABLE_SLOTS = 128;
+
+    struct Table
+    {
+      uint16_t type[TABLE_SLOTS];
+      int8_t index[TABLE_SLOTS];  // -1 marks an empty slot
+    };
+
+    constexpr size_t slotFor(uint16_t type)
+    {
+      // Same Fibonacci hash as the Transport's receive queues
+      return (((type * 40503u) & 0xFFFF) * TABLE_SLOTS) >> 16;
+    }
+
+    template<size_t N>
+    constexpr Table buildTable(const uint16_t (&types)[N])
+    {
+      Table table{};
+      for (size_t i = 0; i < TABLE_SLOTS; ++i)
+      {
+        table.index[i] = -1;
+      }
+      for (size_t k = 0; k < N; ++k)
+      {
+        size_t inx = slotFor(types[k]);
+        while (table.index[inx] >= 0)
+        {
+          inx = (inx + 1) & (TABLE_SLOTS - 1);
+        }
+        table.type[inx] = types[k];
+        table.index[inx] = static_cast<int8_t>(k);
+      }
+      return table;
+    }
+
+    template<typename T>
+    Message *make(void *input, size_t msg_len)
+    {
+      return new T(input, msg_len);
+    }
+
+    template<typename T>
+    Message *makeChecked(void *input, size_t msg_len)
+    {
+      T *msg = new T(input, msg_len, std::nothrow);
+      if (!msg->hasExpectedLength())
+      {
+        delete msg;
+        return NULL;
+      }
+      return msg;
+    }
+
+    template<typename T, typename List>
+    struct IndexOf;
+
+    template<typename T>
+    struct IndexOf<T, MessageTypeList<> >
+    {
+      static const int value = -1;
+    };
+
+    template<typename T, typename Entry, typename... Rest>
+    struct IndexOf<T, MessageTypeList<Entry, Rest...> >
+    {
+      static const int rest = IndexOf<T, MessageTypeList<Rest...> >::value;
+      static const int value = std::is_same<T, typename Entry::Class>::value ? 0 : (rest < 0 ? -1 : rest + 1);
+    };
+
+    template<int I, typename List>
+    struct EntryAt;
+
+    template<typename Entry, typename... Rest>
+    struct EntryAt<0, MessageTypeList<Entry, Rest...> >
+    {
+      typedef Entry type;
+    };
+
+    template<int I, typename Entry, typename... Rest>
+    struct EntryAt<I, MessageTypeList<Entry, Rest...> >
+    {
+      typedef typename EntryAt<I - 1, MessageTypeList<Rest...> >::type type;
+    };
+  }
+
+  template<typename List>
+  class MessageRegistry;
+
+/**
+* Type ID dispatch built from a MessageTypeList. Every lookup is one hash and a short
+* probe of a table laid out by the compiler; nothing is registered at run time.
+*/
+  template<typename... Entries>
+  class MessageRegistry<MessageTypeList<Entries...> >
+  {
+  public:
+    static const size_t SIZE = sizeof...(Entries);
+
+    /**
+    * @return  The type's position in the list, or -1 if it isn't a registered data message.
+    */
+    static int indexOf(uint16_t type)
+    {
+      size_t inx = registry::slotFor(type);
+      while (table.index[inx] >= 0)
+      {
+        if (table.type[inx] == type)
+        {
+          return table.index[inx];
+        }
+        inx = (inx + 1) & (registry::TABLE_SLOTS - 1);
+      }
+      return -1;
+    }
+
+    /**
+    * Build the class registered for the type; as the throwing Message constructors.
+    * @return  The message, or null if the type isn't registered.
+    */
+    static Message *make(uint16_t type, void *input, size_t msg_len)
+    {
+      int inx = indexOf(type);
+      return (inx < 0) ? NULL : makers[inx](input, msg_len);
+    }
+
+    /**
+    * As make(), but never throws.
+    * @param[out] registered  Whether the type is registered; a registered type can still
+    *                         return null, if its payload length is wrong.
+    */
+    static Message *makeChecked(uint16_t type, void *input, size_t msg_len, bool &registered)
+    {
+      int inx = indexOf(type);
+      registered = (inx >= 0);
+      return registered ? checked_makers[inx](input, msg_len) : NULL;
+    }
+
+  private:
+    typedef Message *(*Maker)(void *input, size_t msg_len);
+
+    static_assert(SIZE < 128 && SIZE * 2 <= registry::TABLE_SLOTS, "Too many message types for the table");
+
+    static constexpr uint16_t types[SIZE] = {Entries::type...};
+    static constexpr registry::Table table = registry::buildTable(types);
+    static constexpr Maker makers[SIZE] = {&registry::make<typename Entries::Class>...};
+    static constexpr Maker checked_makers[SIZE] = {&registry::makeChecked<typename Entries::Class>...};
+  };
+
+  template<typename... Entries>
+  constexpr uint16_t MessageRegistry<MessageTypeList<Entries...> >::types[];
+
+  template<typename... Entries>
+  constexpr registry::Table MessageRegistry<MessageTypeList<Entries...> >::table;
+
+  template<typename... Entries>
+  constexpr typename MessageRegistry<MessageTypeList<Entries...> >::Maker
+      MessageRegistry<MessageTypeList<Entries...> >::makers[];
+
+  template<typename... Entries>
+  constexpr typename MessageRegistry<MessageTypeList<Entries...> >::Maker
+      MessageRegistry<MessageTypeList<Entries...> >::checked_makers[];
+
+  typedef MessageRegistry<DataMessageTypes> DataMessages;
+
+/**
+* Compile-time facts about a registered data message class.
+*/
+  template<typename T>
+  struct MessageTraits
+  {
+    static const int index = registry::IndexOf<T, DataMessageTypes>::value;
+    static_assert(index >= 0, "Not a registered data message; add it to DataMessageTypes");
+
+    typedef typename registry::EntryAt<index, DataMessageTypes>::type Entry;
+    static const enum MessageTypes type = Entry::type;
+    static const uint16_t request = Entry::request;
+  };
+
+/**
+* Downcast a received message without RTTI. The factory always builds the registered
+* class for a type ID, so a matching ID is proof of the class.
+* A message of any other type is deleted.
+* @return  The message as T, or null.
+*/
+  template<typename T>
+  T *messageCast(Message *msg)
+  {
+    if (!msg)
+    {
+      return NULL;
+    }
+    if (msg->getType() != MessageTraits<T>::type)
+    {
+      delete msg;
+      return NULL;
+    }
+    return static_cast<T *>(msg);
+  }
+
+} // namespace clearpath
+
+#endif // CLEARPATH_MESSAGE_REGISTRY_H
@@ -48,14 +48,56 @@
 #define CLEARPATH_MESSAGE_DATA_H
 
 #include <iostream>
+#include <new>
 #include <string>
 #include <stdint.h>
 #include "husky_base/horizon_legacy/Message.h"
 #include "husky_base/horizon_legacy/Message_request.h"
+#include "husky_base/horizon_legacy/Number.h"
 
 namespace clearpath
 {
 
+/* Plain decoded copies of the data messages read every control/status cycle.
+ * Filled in one pass by the decode() member of the matching class; entries
+ * past the reported counts are zeroed. */
+  struct DifferentialSpeedSample
+  {
+    double left_speed;
+    double right_speed;
+    double left_accel;
+    double right_accel;
+  };
+
+  struct EncoderSample
+  {
+    static const size_t MAX_ENCODERS = 4;
+    size_t count;
+    double travel[MAX_ENCODERS];
+    double speed[MAX_ENCODERS];
+  };
+
+  struct PowerSystemSample
+  {
+    static const size_t MAX_BATTERIES = 4;
+    size_t battery_count;
+    double charge_estimate[MAX_BATTERIES];
+    int16_t capacity_estimate[MAX_BATTERIES];
+    uint8_t description[MAX_BATTERIES];
+  };
+
+  struct SystemStatusSample
+  {
+    static const size_t MAX_CHANNELS = 8;
+    uint32_t uptime;
+    size_t voltages_count;
+    size_t currents_count;
+    size_t temperatures_count;
+    double voltage[MAX_CHANNELS];
+    double current[MAX_CHANNELS];
+    double temperature[MAX_CHANNELS];
+  };
+
   class DataAckermannOutput : public Message
   {
   public:
@@ -69,6 +111,10 @@ namespace clearpath
   public:
     DataAckermannOutput(void *input, size_t msg_len);
 
+    DataAckermannOutput(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataAckermannOutput(const DataAckermannOutput &other);
 
     static DataAckermannOutput *popNext();
@@ -79,6 +125,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq = 0);
 
+    static DataAckermannOutput *popNext(Transport &transport);
+
+    static DataAckermannOutput *waitNext(Transport &transport, double timeout = 0);
+
+    static DataAckermannOutput *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq = 0);
+
     static enum MessageTypes getTypeID();
 
     double getSteering();
@@ -113,6 +167,10 @@ namespace clearpath
   public:
     DataDifferentialControl(void *input, size_t msg_len);
 
+    DataDifferentialControl(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataDifferentialControl(const DataDifferentialControl &other);
 
     static DataDifferentialControl *popNext();
@@ -123,6 +181,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq = 0);
 
+    static DataDifferentialControl *popNext(Transport &transport);
+
+    static DataDifferentialControl *waitNext(Transport &transport, double timeout = 0);
+
+    static DataDifferentialControl *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq = 0);
+
     static enum MessageTypes getTypeID();
 
     double getLeftP();
@@ -165,6 +231,10 @@ namespace clearpath
   public:
     DataDifferentialOutput(void *input, size_t msg_len);
 
+    DataDifferentialOutput(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataDifferentialOutput(const DataDifferentialOutput &other);
 
     static DataDifferentialOutput *popNext();
@@ -175,6 +245,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataDifferentialOutput *popNext(Transport &transport);
+
+    static DataDifferentialOutput *waitNext(Transport &transport, double timeout = 0);
+
+    static DataDifferentialOutput *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getLeft();
@@ -196,9 +274,22 @@ namespace clearpath
       PAYLOAD_LEN = 8
     };
 
+    struct Layout
+    {
+      typedef PayloadField<int16_t, LEFT_SPEED, 100> LeftSpeed;
+      typedef PayloadField<int16_t, RIGHT_SPEED, 100> RightSpeed;
+      typedef PayloadField<int16_t, LEFT_ACCEL, 100> LeftAccel;
+      typedef PayloadField<int16_t, RIGHT_ACCEL, 100> RightAccel;
+      static_assert(RightAccel::end == PAYLOAD_LEN, "DataDifferentialSpeed layout out of sync");
+    };
+
   public:
     DataDifferentialSpeed(void *input, size_t msg_len);
 
+    DataDifferentialSpeed(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataDifferentialSpeed(const DataDifferentialSpeed &other);
 
     static DataDifferentialSpeed *popNext();
@@ -209,6 +300,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataDifferentialSpeed *popNext(Transport &transport);
+
+    static DataDifferentialSpeed *waitNext(Transport &transport, double timeout = 0);
+
+    static DataDifferentialSpeed *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getLeftSpeed();
@@ -219,6 +318,8 @@ namespace clearpath
 
     double getRightAccel();
 
+    void decode(DifferentialSpeedSample &sample);
+
     virtual std::ostream &printMessage(std::ostream &stream = std::cout);
   };
 
@@ -227,6 +328,10 @@ namespace clearpath
   public:
     DataEcho(void *input, size_t msg_len);
 
+    DataEcho(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataEcho(const DataEcho &other);
 
     static DataEcho *popNext();
@@ -237,6 +342,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataEcho *popNext(Transport &transport);
+
+    static DataEcho *waitNext(Transport &transport, double timeout = 0);
+
+    static DataEcho *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     virtual std::ostream &printMessage(std::ostream &stream = std::cout);
@@ -249,8 +362,17 @@ namespace clearpath
     size_t speeds_offset;
 
   public:
+    // Count byte, then count int32 travels (mm), then count int16 speeds (mm/s)
+    typedef PayloadField<uint8_t, 0> Count;
+    static const unsigned TRAVEL_SCALE = 1000;
+    static const unsigned SPEED_SCALE = 1000;
+
     DataEncoders(void *input, size_t msg_len);
 
+    DataEncoders(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataEncoders(const DataEncoders &other);
 
     static DataEncoders *popNext();
@@ -261,6 +383,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataEncoders *popNext(Transport &transport);
+
+    static DataEncoders *waitNext(Transport &transport, double timeout = 0);
+
+    static DataEncoders *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getCount();
@@ -269,6 +399,8 @@ namespace clearpath
 
     double getSpeed(uint8_t index);
 
+    void decode(EncoderSample &sample);
+
     virtual std::ostream &printMessage(std::ostream &stream = std::cout);
   };
 
@@ -277,6 +409,10 @@ namespace clearpath
   public:
     DataEncodersRaw(void *input, size_t pkt_len);
 
+    DataEncodersRaw(void *input, size_t pkt_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataEncodersRaw(const DataEncodersRaw &other);
 
     static DataEncodersRaw *popNext();
@@ -287,6 +423,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataEncodersRaw *popNext(Transport &transport);
+
+    static DataEncodersRaw *waitNext(Transport &transport, double timeout = 0);
+
+    static DataEncodersRaw *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getCount();
@@ -347,6 +491,10 @@ namespace clearpath
   public:
     DataFirmwareInfo(void *input, size_t msg_len);
 
+    DataFirmwareInfo(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataFirmwareInfo(const DataFirmwareInfo &other);
 
     static DataFirmwareInfo *popNext();
@@ -357,6 +505,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataFirmwareInfo *popNext(Transport &transport);
+
+    static DataFirmwareInfo *waitNext(Transport &transport, double timeout = 0);
+
+    static DataFirmwareInfo *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getMajorFirmwareVersion();
@@ -377,6 +533,10 @@ namespace clearpath
   public:
     DataGear(void *input, size_t msg_len);
 
+    DataGear(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataGear(const DataGear &other);
 
     static DataGear *popNext();
@@ -387,6 +547,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataGear *popNext(Transport &transport);
+
+    static DataGear *waitNext(Transport &transport, double timeout = 0);
+
+    static DataGear *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getGear();
@@ -407,6 +575,10 @@ namespace clearpath
   public:
     DataMaxAcceleration(void *input, size_t msg_len);
 
+    DataMaxAcceleration(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataMaxAcceleration(const DataMaxAcceleration &other);
 
     static DataMaxAcceleration *popNext();
@@ -417,6 +589,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataMaxAcceleration *popNext(Transport &transport);
+
+    static DataMaxAcceleration *waitNext(Transport &transport, double timeout = 0);
+
+    static DataMaxAcceleration *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getForwardMax();
@@ -439,6 +619,10 @@ namespace clearpath
   public:
     DataMaxSpeed(void *input, size_t msg_len);
 
+    DataMaxSpeed(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataMaxSpeed(const DataMaxSpeed &other);
 
     static DataMaxSpeed *popNext();
@@ -449,6 +633,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataMaxSpeed *popNext(Transport &transport);
+
+    static DataMaxSpeed *waitNext(Transport &transport, double timeout = 0);
+
+    static DataMaxSpeed *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getForwardMax();
@@ -471,6 +663,10 @@ namespace clearpath
   public:
     DataPlatformAcceleration(void *input, size_t msg_len);
 
+    DataPlatformAcceleration(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataPlatformAcceleration(const DataPlatformAcceleration &other);
 
     static DataPlatformAcceleration *popNext();
@@ -481,6 +677,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq = 0);
 
+    static DataPlatformAcceleration *popNext(Transport &transport);
+
+    static DataPlatformAcceleration *waitNext(Transport &transport, double timeout = 0);
+
+    static DataPlatformAcceleration *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq = 0);
+
     static enum MessageTypes getTypeID();
 
     double getX();
@@ -500,6 +704,10 @@ namespace clearpath
   public:
     DataPlatformInfo(void *input, size_t msg_len);
 
+    DataPlatformInfo(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataPlatformInfo(const DataPlatformInfo &other);
 
     static DataPlatformInfo *popNext();
@@ -510,6 +718,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataPlatformInfo *popNext(Transport &transport);
+
+    static DataPlatformInfo *waitNext(Transport &transport, double timeout = 0);
+
+    static DataPlatformInfo *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     std::string getModel();
@@ -526,6 +742,10 @@ namespace clearpath
   public:
     DataPlatformName(void *input, size_t msg_len);
 
+    DataPlatformName(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataPlatformName(const DataPlatformName &other);
 
     static DataPlatformName *popNext();
@@ -536,6 +756,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataPlatformName *popNext(Transport &transport);
+
+    static DataPlatformName *waitNext(Transport &transport, double timeout = 0);
+
+    static DataPlatformName *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     std::string getName();
@@ -556,6 +784,10 @@ namespace clearpath
   public:
     DataPlatformMagnetometer(void *input, size_t msg_len);
 
+    DataPlatformMagnetometer(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataPlatformMagnetometer(const DataPlatformMagnetometer &other);
 
     static DataPlatformMagnetometer *popNext();
@@ -566,6 +798,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataPlatformMagnetometer *popNext(Transport &transport);
+
+    static DataPlatformMagnetometer *waitNext(Transport &transport, double timeout = 0);
+
+    static DataPlatformMagnetometer *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getX();
@@ -590,6 +830,10 @@ namespace clearpath
   public:
     DataPlatformOrientation(void *input, size_t msg_len);
 
+    DataPlatformOrientation(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataPlatformOrientation(const DataPlatformOrientation &other);
 
     static DataPlatformOrientation *popNext();
@@ -600,6 +844,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataPlatformOrientation *popNext(Transport &transport);
+
+    static DataPlatformOrientation *waitNext(Transport &transport, double timeout = 0);
+
+    static DataPlatformOrientation *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getRoll();
@@ -625,6 +877,10 @@ namespace clearpath
   public:
     DataPlatformRotation(void *input, size_t msg_len);
 
+    DataPlatformRotation(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataPlatformRotation(const DataPlatformRotation &other);
 
     static DataPlatformRotation *popNext();
@@ -635,6 +891,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataPlatformRotation *popNext(Transport &transport);
+
+    static DataPlatformRotation *waitNext(Transport &transport, double timeout = 0);
+
+    static DataPlatformRotation *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getRollRate();
@@ -684,6 +948,10 @@ namespace clearpath
   public:
     DataPowerSystem(void *input, size_t msg_len);
 
+    DataPowerSystem(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataPowerSystem(const DataPowerSystem &other);
 
     static DataPowerSystem *popNext();
@@ -694,6 +962,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataPowerSystem *popNext(Transport &transport);
+
+    static DataPowerSystem *waitNext(Transport &transport, double timeout = 0);
+
+    static DataPowerSystem *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getBatteryCount();
@@ -704,6 +980,8 @@ namespace clearpath
 
     BatteryDescription getDescription(uint8_t battery);
 
+    void decode(PowerSystemSample &sample);
+
     virtual std::ostream &printMessage(std::ostream &stream = std::cout);
   };
 
@@ -712,6 +990,10 @@ namespace clearpath
   public:
     DataProcessorStatus(void *input, size_t msg_len);
 
+    DataProcessorStatus(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataProcessorStatus(const DataProcessorStatus &other);
 
     static DataProcessorStatus *popNext();
@@ -722,6 +1004,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataProcessorStatus *popNext(Transport &transport);
+
+    static DataProcessorStatus *waitNext(Transport &transport, double timeout = 0);
+
+    static DataProcessorStatus *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getProcessCount();
@@ -736,6 +1026,10 @@ namespace clearpath
   public:
     DataRangefinders(void *input, size_t msg_len);
 
+    DataRangefinders(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRangefinders(const DataRangefinders &other);
 
     static DataRangefinders *popNext();
@@ -746,6 +1040,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRangefinders *popNext(Transport &transport);
+
+    static DataRangefinders *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRangefinders *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getRangefinderCount();
@@ -760,6 +1062,10 @@ namespace clearpath
   public:
     DataRangefinderTimings(void *input, size_t msg_len);
 
+    DataRangefinderTimings(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRangefinderTimings(const DataRangefinderTimings &other);
 
     static DataRangefinderTimings *popNext();
@@ -770,6 +1076,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRangefinderTimings *popNext(Transport &transport);
+
+    static DataRangefinderTimings *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRangefinderTimings *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getRangefinderCount();
@@ -794,6 +1108,10 @@ namespace clearpath
   public:
     DataRawAcceleration(void *input, size_t msg_len);
 
+    DataRawAcceleration(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRawAcceleration(const DataRawAcceleration &other);
 
     static DataRawAcceleration *popNext();
@@ -804,6 +1122,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRawAcceleration *popNext(Transport &transport);
+
+    static DataRawAcceleration *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRawAcceleration *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint16_t getX();
@@ -820,6 +1146,10 @@ namespace clearpath
   public:
     DataRawCurrent(void *input, size_t msg_len);
 
+    DataRawCurrent(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRawCurrent(const DataRawCurrent &other);
 
     static DataRawCurrent *popNext();
@@ -830,6 +1160,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRawCurrent *popNext(Transport &transport);
+
+    static DataRawCurrent *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRawCurrent *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getCurrentCount();
@@ -852,6 +1190,10 @@ namespace clearpath
   public:
     DataRawGyro(void *input, size_t msg_len);
 
+    DataRawGyro(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRawGyro(const DataRawGyro &other);
 
     static DataRawGyro *popNext();
@@ -862,6 +1204,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRawGyro *popNext(Transport &transport);
+
+    static DataRawGyro *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRawGyro *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint16_t getRoll();
@@ -886,6 +1236,10 @@ namespace clearpath
   public:
     DataRawMagnetometer(void *input, size_t msg_len);
 
+    DataRawMagnetometer(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRawMagnetometer(const DataRawMagnetometer &other);
 
     static DataRawMagnetometer *popNext();
@@ -896,6 +1250,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRawMagnetometer *popNext(Transport &transport);
+
+    static DataRawMagnetometer *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRawMagnetometer *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint16_t getX();
@@ -920,6 +1282,10 @@ namespace clearpath
   public:
     DataRawOrientation(void *input, size_t msg_len);
 
+    DataRawOrientation(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRawOrientation(const DataRawOrientation &other);
 
     static DataRawOrientation *popNext();
@@ -930,6 +1296,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRawOrientation *popNext(Transport &transport);
+
+    static DataRawOrientation *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRawOrientation *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint16_t getRoll();
@@ -946,6 +1320,10 @@ namespace clearpath
   public:
     DataRawTemperature(void *input, size_t msg_len);
 
+    DataRawTemperature(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRawTemperature(const DataRawTemperature &other);
 
     static DataRawTemperature *popNext();
@@ -956,6 +1334,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRawTemperature *popNext(Transport &transport);
+
+    static DataRawTemperature *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRawTemperature *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getTemperatureCount();
@@ -970,6 +1356,10 @@ namespace clearpath
   public:
     DataRawVoltage(void *input, size_t msg_len);
 
+    DataRawVoltage(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataRawVoltage(const DataRawVoltage &other);
 
     static DataRawVoltage *popNext();
@@ -980,6 +1370,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataRawVoltage *popNext(Transport &transport);
+
+    static DataRawVoltage *waitNext(Transport &transport, double timeout = 0);
+
+    static DataRawVoltage *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint8_t getVoltageCount();
@@ -992,8 +1390,14 @@ namespace clearpath
   class DataSafetySystemStatus : public Message
   {
   public:
+    typedef PayloadField<uint16_t, 0> Flags;
+
     DataSafetySystemStatus(void *input, size_t msg_len);
 
+    DataSafetySystemStatus(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataSafetySystemStatus(const DataSafetySystemStatus &other);
 
     static DataSafetySystemStatus *popNext();
@@ -1004,6 +1408,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataSafetySystemStatus *popNext(Transport &transport);
+
+    static DataSafetySystemStatus *waitNext(Transport &transport, double timeout = 0);
+
+    static DataSafetySystemStatus *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint16_t getFlags();
@@ -1021,6 +1433,10 @@ namespace clearpath
   public:
     DataSystemStatus(void *input, size_t msg_len);
 
+    DataSystemStatus(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataSystemStatus(const DataSystemStatus &other);
 
     static DataSystemStatus *popNext();
@@ -1031,6 +1447,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataSystemStatus *popNext(Transport &transport);
+
+    static DataSystemStatus *waitNext(Transport &transport, double timeout = 0);
+
+    static DataSystemStatus *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     uint32_t getUptime();
@@ -1047,6 +1471,8 @@ namespace clearpath
 
     double getTemperature(uint8_t index);
 
+    void decode(SystemStatusSample &sample);
+
     virtual std::ostream &printMessage(std::ostream &stream = std::cout);
   };
 
@@ -1063,6 +1489,10 @@ namespace clearpath
   public:
     DataVelocity(void *input, size_t msg_len);
 
+    DataVelocity(void *input, size_t msg_len, const std::nothrow_t &);
+
+    bool hasExpectedLength();
+
     DataVelocity(const DataVelocity &other);
 
     static DataVelocity *popNext();
@@ -1073,6 +1503,14 @@ namespace clearpath
 
     static void subscribe(uint16_t freq);
 
+    static DataVelocity *popNext(Transport &transport);
+
+    static DataVelocity *waitNext(Transport &transport, double timeout = 0);
+
+    static DataVelocity *getUpdate(Transport &transport, double timeout = 0);
+
+    static void subscribe(Transport &transport, uint16_t freq);
+
     static enum MessageTypes getTypeID();
 
     double getTranslational();
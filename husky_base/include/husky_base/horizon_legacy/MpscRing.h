@@ -0,0 +1,124 @@
+/**
+Software License Agreement (BSD)
+
+\file      MpscRing.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_MPSC_RING_H
+#define CLEARPATH_MPSC_RING_H
+
+#include <atomic>
+#include <cstdlib>
+#include <stdint.h>
+
+namespace clearpath
+{
+
+/**
+* Bounded, lock-free, multi-producer / single-consumer ring.
+* push() may be called from any number of threads, pop() from one thread only.
+* Each slot carries a sequence number saying whether it is free for the producer
+* claiming that position or filled for the consumer, so a producer that stalls
+* half way through a push only holds up the consumer, never the other producers.
+* Neither call allocates or blocks.
+*/
+  template<typename T, size_t Capacity>
+  class MpscRing
+  {
+    static_assert((Capacity & (Capacity - 1)) == 0, "MpscRing capacity must be a power of two");
+
+  public:
+    MpscRing() : tail(0), head(0)
+    {
+      for (size_t i = 0; i < Capacity; ++i)
+      {
+        cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    /**
+    * Producer side. Returns false, leaving the ring untouched, if it is full.
+    */
+    bool push(const T &item)
+    {
+      size_t pos = tail.load(std::memory_order_relaxed);
+      Cell *cell;
+      while (true)
+      {
+        cell = &cells[pos & (Capacity - 1)];
+        intptr_t diff = static_cast<intptr_t>(cell->seq.load(std::memory_order_acquire)) -
+                        static_cast<intptr_t>(pos);
+        if (diff == 0)
+        {
+          // Slot is free for this position, try to claim it
+          if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            break;
+          }
+        }
+        else if (diff < 0)
+        {
+          // Consumer hasn't freed this slot from the previous lap yet
+          return false;
+        }
+        else
+        {
+          pos = tail.load(std::memory_order_relaxed);
+        }
+      }
+
+      cell->item = item;
+      cell->seq.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+    * Consumer side. Returns false if the ring is empty.
+    */
+    bool pop(T &item)
+    {
+      Cell &cell = cells[head & (Capacity - 1)];
+      if (cell.seq.load(std::memory_order_acquire) != head + 1)
+      {
+        return false;
+      }
+      item = cell.item;
+      cell.seq.store(head + Capacity, std::memory_order_release);
+      ++head;
+      return true;
+    }
+
+  private:
+    struct Cell
+    {
+      std::atomic<size_t> seq;
+      T item;
+    };
+
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) size_t head;  // only touched by the consumer
+    alignas(64) Cell cells[Capacity];
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_MPSC_RING_H
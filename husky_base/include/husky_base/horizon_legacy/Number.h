@@ -49,8 +49,10 @@
 #define NUMBER_H_
 
 #include <cstdlib>
+#include <cstring>
 #include <stdint.h>
 #include <iostream>
+#include <type_traits>
 
 namespace clearpath
 {
@@ -71,13 +73,106 @@ namespace clearpath
 /* void toBytes(void* dest, size_t dest_len, float src, float scale); */
   void ftob(void *dest, size_t dest_len, double src, double scale);
 
-/* Number to little-endian byte array conversion routines
- * Need to provide all, since size of the int param matters. */
-  uint64_t btou(void *src, size_t src_len);
+/* Fixed-width little-endian loads for the message accessors.
+ * The memcpy compiles down to a single unaligned load (plus a byte swap on
+ * big-endian hosts), instead of a byte-at-a-time loop. */
+  inline uint8_t fromLE(uint8_t v) { return v; }
 
-  int64_t btoi(void *src, size_t src_len);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  inline uint16_t fromLE(uint16_t v) { return __builtin_bswap16(v); }
+  inline uint32_t fromLE(uint32_t v) { return __builtin_bswap32(v); }
+  inline uint64_t fromLE(uint64_t v) { return __builtin_bswap64(v); }
+#else
+  inline uint16_t fromLE(uint16_t v) { return v; }
+  inline uint32_t fromLE(uint32_t v) { return v; }
+  inline uint64_t fromLE(uint64_t v) { return v; }
+#endif
 
-  double btof(void *src, size_t src_len, double scale);
+  template<typename T>
+  inline T loadLE(const void *src)
+  {
+    static_assert(std::is_integral<T>::value, "loadLE only handles integer fields");
+    typedef typename std::make_unsigned<T>::type U;
+    U raw;
+    memcpy(&raw, src, sizeof(U));
+    return static_cast<T>(fromLE(raw));
+  }
+
+/* Little-endian byte array to number conversion routines.
+ * Inline, so a call with a known width folds down to its loads. */
+  inline uint64_t btou(void *src, size_t src_len)
+  {
+    const uint8_t *bytes = (const uint8_t *) src;
+
+    /* Tests rather than a switch, so a width that is the same on every call
+     * is checked once for a whole loop instead of costing a jump per field.
+     * Every width is at most three loads, none of them past the field. */
+    if (src_len < 4)
+    {
+      if (src_len == 1) { return bytes[0]; }
+      if (src_len == 2) { return loadLE<uint16_t>(bytes); }
+      if (src_len == 3) { return loadLE<uint16_t>(bytes) | ((uint64_t) bytes[2] << 16); }
+      return 0;
+    }
+    if (src_len == 4) { return loadLE<uint32_t>(bytes); }
+    if (src_len >= sizeof(uint64_t)) { return loadLE<uint64_t>(bytes); }
+    uint64_t low = loadLE<uint32_t>(bytes);
+    if (src_len == 5) { return low | ((uint64_t) bytes[4] << 32); }
+    low |= (uint64_t) loadLE<uint16_t>(bytes + 4) << 32;
+    if (src_len == 6) { return low; }
+    return low | ((uint64_t) bytes[6] << 48);
+  }
+
+  inline int64_t btoi(void *src, size_t src_len)
+  {
+    if (src_len == 2) { return loadLE<int16_t>(src); }
+    if (src_len == 4) { return loadLE<int32_t>(src); }
+    if (src_len == 1) { return loadLE<int8_t>(src); }
+    if (src_len >= sizeof(int64_t)) { return loadLE<int64_t>(src); }
+    if (!src_len) { return 0; }
+
+    /* Odd widths: shift the sign bit to the top and back down to propagate it */
+    unsigned shift = 64 - 8 * src_len;
+    return static_cast<int64_t>(btou(src, src_len) << shift) >> shift;
+  }
+
+  inline double btof(void *src, size_t src_len, double scale)
+  {
+    double retval = btoi(src, src_len);
+    return retval /= scale;
+  }
+
+/**
+* Compile-time description of a fixed-position payload field: wire type,
+* byte offset within the payload, and the fixed-point divisor applied to it.
+*/
+  template<typename T, size_t Offset, unsigned Scale = 1>
+  struct PayloadField
+  {
+    typedef T raw_type;
+    static constexpr size_t offset = Offset;
+    static constexpr size_t width = sizeof(T);
+    static constexpr size_t end = Offset + sizeof(T);
+
+    static T raw(const uint8_t *payload)
+    {
+      return loadLE<T>(payload + Offset);
+    }
+
+    static double value(const uint8_t *payload)
+    {
+      return raw(payload) / static_cast<double>(Scale);
+    }
+  };
+
+/**
+* Element i of a packed array of fixed-point fields starting at base.
+*/
+  template<typename T, unsigned Scale>
+  inline double loadScaled(const uint8_t *base, size_t i)
+  {
+    return loadLE<T>(base + i * sizeof(T)) / static_cast<double>(Scale);
+  }
 
 } // namespace clearpath
 
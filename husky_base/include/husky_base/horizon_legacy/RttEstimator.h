@@ -0,0 +1,119 @@
+/**
+Software License Agreement (BSD)
+
+\file      RttEstimator.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_RTT_ESTIMATOR_H
+#define CLEARPATH_RTT_ESTIMATOR_H
+
+#include <chrono>
+#include <mutex>
+
+namespace clearpath
+{
+
+/**
+* How long to wait for an ack before retransmitting, as TCP works it out
+* (RFC 6298): a smoothed round trip SRTT and its mean deviation RTTVAR,
+* with the timeout at SRTT + 4 * RTTVAR, kept within configured bounds and
+* doubled for every timeout in a row until the next answer. Only round trips
+* of messages which were sent once are sampled; an ack after a retransmit
+* can't be told apart from a late ack of the first write.
+*
+* By default (adaptive off) the timeout is the fixed 200 ms the Transport
+* always used.
+*
+* configure(), addSample(), addTimeout() and timeout() belong to the thread
+* sending on the Transport; estimate() may be used from any thread.
+*/
+  class RttEstimator
+  {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Estimate
+    {
+      bool adaptive;
+      double srtt;      // smoothed ack round trip, seconds
+      double rttvar;    // its mean deviation, seconds
+      double timeout;   // current ack timeout, seconds, backoff included
+      unsigned long samples;
+      unsigned long timeouts;  // acks which didn't arrive in time
+    };
+
+    RttEstimator();
+
+    /**
+    * Switch between adaptive and fixed timeouts. Adaptive timeouts stay
+    * within [min_timeout, max_timeout] seconds, and start out at the maximum
+    * until the first round trip is measured.
+    */
+    void configure(bool adaptive, double min_timeout, double max_timeout);
+
+    /**
+    * Forget everything measured, e.g. when the port is reopened.
+    */
+    void reset();
+
+    /**
+    * Account for the round trip of a message acked on its first write.
+    */
+    void addSample(Clock::duration rtt);
+
+    /**
+    * Account for an ack which didn't arrive within timeout().
+    */
+    void addTimeout();
+
+    Clock::duration timeout() const
+    {
+      return current;
+    }
+
+    /**
+    * Bound a wait for data which follows an acked request: at most the ack
+    * timeout once the round trip is known, never longer than asked for.
+    * @param timeout  Seconds, 0.0 for no timeout, which is left alone
+    */
+    double dataTimeout(double timeout) const;
+
+    Estimate estimate() const;
+
+  private:
+    void update();
+
+    bool adaptive;
+    double min_timeout, max_timeout;
+
+    double srtt, rttvar;
+    int backoff;
+    unsigned long samples, timeouts;
+    Clock::duration current;
+
+    mutable std::mutex published_mutex;
+    Estimate published;
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_RTT_ESTIMATOR_H
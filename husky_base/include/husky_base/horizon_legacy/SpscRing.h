@@ -0,0 +1,99 @@
+/**
+Software License Agreement (BSD)
+
+\file      SpscRing.h
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLEARPATH_SPSC_RING_H
+#define CLEARPATH_SPSC_RING_H
+
+#include <atomic>
+#include <cstdlib>
+
+namespace clearpath
+{
+
+/**
+* Bounded, lock-free, single-producer / single-consumer ring.
+* push() may only be called from one thread and pop() from one (other) thread.
+* Neither call allocates or blocks.
+*/
+  template<typename T, size_t Capacity>
+  class SpscRing
+  {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+  public:
+    SpscRing() : head(0), tail(0)
+    {
+    }
+
+    /**
+    * Producer side. Returns false, leaving the ring untouched, if it is full.
+    */
+    bool push(const T &item)
+    {
+      size_t t = tail.load(std::memory_order_relaxed);
+      if (t - head.load(std::memory_order_acquire) == Capacity)
+      {
+        return false;
+      }
+      slots[t & (Capacity - 1)] = item;
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+    * Consumer side. Returns false if the ring is empty.
+    */
+    bool pop(T &item)
+    {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h == tail.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+      item = slots[h & (Capacity - 1)];
+      head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool empty() const
+    {
+      return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() const
+    {
+      return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+  private:
+    // Keep the indices on separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) T slots[Capacity];
+  };
+
+} // namespace clearpath
+
+#endif  // CLEARPATH_SPSC_RING_H
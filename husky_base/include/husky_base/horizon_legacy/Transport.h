@@ -48,11 +48,22 @@
 #ifndef CLEARPATH_TRANSPORT_H
 #define CLEARPATH_TRANSPORT_H
 
+#include <atomic>
+#include <chrono>
 #include <list>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "husky_base/horizon_legacy/Message.h"
+#include "husky_base/horizon_legacy/ClockSync.h"
 #include "husky_base/horizon_legacy/Exception.h"
+#include "husky_base/horizon_legacy/FrameCapture.h"
+#include "husky_base/horizon_legacy/FrameScanner.h"
+#include "husky_base/horizon_legacy/LatencyHistogram.h"
+#include "husky_base/horizon_legacy/RttEstimator.h"
+#include "husky_base/horizon_legacy/SpscRing.h"
+#include "husky_base/horizon_legacy/serial.h"
 
 namespace clearpath
 {
@@ -103,75 +114,366 @@ namespace clearpath
       INVALID_MSG,  // bad format / CRC wrong
       IGNORED_ACK,  // ack we didn't care about
       QUEUE_FULL,   // dropped msg because of overfull queue
+      RETRANSMITS,  // messages written again after an ack timeout or bad checksum
+      ASYNC_UNACKED, // async sends given up on without an ack
+      RX_BYTES,     // bytes read from the port
+      RX_FRAMES,    // well-formed frames received
+      TX_BYTES,     // bytes written to the port
+      TX_FRAMES,    // frames written, retransmits included
+      PORT_ERRORS,  // waits that failed because the port hung up or errored
       NUM_COUNTERS  // end of list, not actual counter
     };
     static const char *counter_names[NUM_COUNTERS]; // N.B: must be updated with counterTypes
 
+    // Progress of a message handed to sendAsync()
+    enum sendStatus
+    {
+      SEND_UNKNOWN,     // never issued, or evicted by newer tickets
+      SEND_PENDING,     // written, waiting for the ack
+      SEND_ACKED,       // acknowledged with a zero result code
+      SEND_REJECTED,    // acknowledged with an error result code
+      SEND_TIMED_OUT,   // never acknowledged, retries exhausted
+      SEND_SUPERSEDED   // replaced by a newer message of the same type before being acked
+    };
+
+    // How the RX thread waits for serial input
+    enum rxWakeup
+    {
+      RX_WAKE_POLL,     // sleep in poll() until bytes arrive
+      RX_WAKE_SPIN      // poll() without sleeping; lowest latency, costs a whole core
+    };
+
 
   private:
     bool configured;
     void *serial;
     int retries;
 
-    static const int RETRY_DELAY_MS = 200;
+    // Applied on every configure(), and what the port actually ended up with
+    SerialProfile serial_profile;
+    SerialProfile serial_effective;
 
-    std::list<Message *> rx_queue;
-    static const size_t MAX_QUEUE_LEN = 10000;
+    static const size_t MAX_BATCH_LEN = 16;
 
-    unsigned long counters[NUM_COUNTERS];
+    // Received data messages, one bounded queue per message type, held in an
+    // open-addressed table. Queues default to depth 1, i.e. only the latest
+    // sample is kept; setQueueDepth() turns one into a FIFO. Only ever touched
+    // from the consumer's thread (the RX thread hands over through rx_ring).
+    struct QueueEntry
+    {
+      Message *msg;
+      unsigned long seq;  // arrival order across all types, for untyped popNext()
+    };
+    // Header of a frame kept in a compact queue; the raw frame follows it.
+    // A lone uint32_t size of zero marks the unused end of the ring before it
+    // wraps; that gap can be shorter than a whole FrameRecord.
+    struct FrameRecord
+    {
+      uint32_t size;  // of the whole record, header and padding included
+      uint32_t frame_len;
+      unsigned long seq;
+      std::chrono::steady_clock::time_point rx_time;
+    };
+    struct TypeQueue
+    {
+      bool in_use;
+      uint16_t type;
+      size_t depth;
+      size_t head;
+      size_t count;
+      std::vector<QueueEntry> entries;  // capacity == depth, sized outside the receive path
+      // Compact storage (setQueueBytes()): frames as FrameRecords in a byte ring,
+      // with head/count above indexing records instead of entries. Empty when unused.
+      std::vector<uint8_t> frames;
+      size_t frames_tail;
+    };
+    static const size_t TYPE_SLOTS = 64;
+    static const size_t MAX_QUEUE_LEN = 10000;
+    static const size_t RECORD_ALIGN = 8;
+    static const size_t MAX_QUEUE_BYTES = 4 << 20;
+    TypeQueue rx_queues[TYPE_SLOTS];
+    size_t rx_queued;
+    unsigned long rx_seq;
+
+    // Updated from both the RX thread and the caller's thread
+    std::atomic<unsigned long> counters[NUM_COUNTERS];
+
+    // Time from writing a message to receiving its ack, for any kind of send
+    LatencyHistogram ack_latency;
+
+    // Ack timeout before a retransmit, fixed or adapting to the measured round trips
+    RttEstimator rtt_estimator;
+
+    // Raw serial input staged for framing, see rxMessage()
+    FrameScanner rx_scanner;
+    // When the latest read returned; belongs to whichever thread reads the port
+    std::chrono::steady_clock::time_point rx_stamp;
+
+    // MCU clock against ours, fed every data message as it is queued
+    ClockSync clock_sync;
+
+    // Recorder of raw port traffic, created by the first startCapture() and
+    // kept until destruction so the RX thread never sees it go away
+    std::atomic<FrameCapture *> capture;
+
+    // Optional background receiver. When running, it is the only reader of the
+    // serial port and hands complete frames over through rx_ring.
+    static const size_t RX_RING_LEN = 1024;
+    static const int RX_THREAD_WAKEUP_MS = 10;
+    SpscRing<Message *, RX_RING_LEN> rx_ring;
+    std::thread rx_thread;
+    std::atomic<bool> rx_thread_running;
+    bool rx_thread_enabled;
+    int rx_cpu;  // CPU to pin the RX thread to, -1 for none
+    enum rxWakeup rx_wakeup;
+    // eventfd the RX thread signals whenever it pushes frames into rx_ring
+    int rx_event_fd;
+    // Set once a wait on the port fails (e.g. USB unplugged), cleared by configure()
+    std::atomic<bool> port_failed;
+
+    // Outstanding sendAsync() messages, matched to acks by type and timestamp.
+    // Slot is ticket % MAX_PENDING_SENDS; only touched from the caller's thread.
+    struct PendingSend
+    {
+      unsigned long ticket;
+      enum sendStatus status;
+      uint16_t type;
+      uint32_t timestamp;
+      uint16_t result_code;
+      int transmit_times;
+      std::chrono::steady_clock::time_point written;
+      std::chrono::steady_clock::time_point deadline;
+      uint8_t data[Message::MAX_MSG_LENGTH];
+      size_t total_len;
+    };
+    static const size_t MAX_PENDING_SENDS = 32;
+    PendingSend pending[MAX_PENDING_SENDS];
+    size_t num_pending;
+    unsigned long next_ticket;
+    uint32_t next_async_stamp;
 
   private:
     Message *rxMessage();
 
+    Message *nextFrame();
+
+    void rxThreadMain();
+    void portError();
+
+    void startRxThread();
+
+    void stopRxThread();
+
     Message *getAck();
 
+    bool handleAsyncAck(Message *ack);
+
+    void serviceAsyncSends();
+
+    void writePending(PendingSend &p);
+
+    void writeFrames(const uint8_t *data, size_t len, size_t frames);
+
     void enqueueMessage(Message *msg);
 
+    TypeQueue *findQueue(uint16_t type, bool create);
+
+    TypeQueue *oldestQueue();
+
+    Message *takeOldest(TypeQueue &queue);
+
+    void dropOldest(TypeQueue &queue);
+
+    unsigned long oldestSeq(TypeQueue &queue);
+
+    void storeCompact(TypeQueue &queue, Message *msg);
+
+    FrameRecord *headRecord(TypeQueue &queue);
+
+    void advanceRecord(TypeQueue &queue);
+
     int openComm(const char *device);
 
     int closeComm();
 
     void resetCounters();
 
-  protected:
+  public:
+    /**
+    * One Transport per port. Each has its own RX thread, queues and counters,
+    * so separate ports never contend with each other.
+    */
     Transport();
 
     ~Transport();
 
-  public:
+    // The RX ring is cache line aligned, which plain operator new doesn't honour before C++17
+    static void *operator new(size_t size);
+
+    static void operator delete(void *ptr);
+
+    Transport(const Transport &) = delete;
+
+    Transport &operator=(const Transport &) = delete;
+
+    /**
+    * Process-wide Transport, used by the calls that don't take one.
+    */
     static Transport &instance();
 
     void configure(const char *device, int retries);
 
+    void enableRxThread(bool enable)
+    {
+      rx_thread_enabled = enable;
+    }
+
+    /**
+    * CPU affinity and wait strategy of the RX thread, apply from the next configure().
+    */
+    void setRxThreadOptions(int cpu, enum rxWakeup wakeup)
+    {
+      rx_cpu = cpu;
+      rx_wakeup = wakeup;
+    }
+
+    /**
+    * Port settings used from the next configure() on.
+    */
+    void setSerialProfile(const SerialProfile &profile)
+    {
+      serial_profile = profile;
+    }
+
+    /**
+    * Settings read back from the port by the last successful configure().
+    */
+    const SerialProfile &serialSettings()
+    {
+      return serial_effective;
+    }
+
+    bool isRxThreadRunning()
+    {
+      return rx_thread_running;
+    }
+
     bool isConfigured()
     {
       return configured;
     }
 
+    /**
+    * Whether the port has hung up or errored since the last configure().
+    * Safe to call from any thread.
+    */
+    bool portFailed()
+    {
+      return port_failed.load(std::memory_order_relaxed);
+    }
+
     int close();
 
     void poll();
 
     void send(Message *m);
 
+    enum transferResult trySend(Message *m, uint16_t *ack_code = 0);
+
+    void sendBatch(Message **msgs, size_t count,
+                   std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    enum transferResult trySendBatch(Message **msgs, size_t count,
+                                     std::chrono::steady_clock::time_point deadline =
+                                         std::chrono::steady_clock::time_point::max(),
+                                     uint16_t *ack_code = 0);
+
+    bool waitForInput(std::chrono::steady_clock::time_point deadline);
+
+    unsigned long sendAsync(Message *m, bool supersede = false);
+
+    enum transferResult trySendAsync(Message *m, bool supersede, unsigned long *ticket);
+
+    enum sendStatus getSendStatus(unsigned long ticket, uint16_t *result_code = 0);
+
+    size_t pendingSends()
+    {
+      return num_pending;
+    }
+
     Message *popNext();
 
     Message *popNext(enum MessageTypes type);
 
+    Message *popLatest(enum MessageTypes type);
+
+    void setQueueDepth(enum MessageTypes type, size_t depth);
+
+    void setQueueBytes(enum MessageTypes type, size_t bytes);
+
+    size_t queueLength()
+    {
+      return rx_queued;
+    }
+
     Message *waitNext(double timeout = 0.0);
 
     Message *waitNext(enum MessageTypes type, double timeout = 0.0);
 
+    enum transferResult tryWaitNext(enum MessageTypes type, double timeout, Message **msg);
+
     void flush(std::list<Message *> *queue = 0);
 
     void flush(enum MessageTypes type, std::list<Message *> *queue = 0);
 
     unsigned long getCounter(enum counterTypes counter)
     {
-      return counters[counter];
+      return counters[counter].load(std::memory_order_relaxed);
     }
 
     void printCounters(std::ostream &stream = std::cout);
+
+    LatencyHistogram &ackLatency()
+    {
+      return ack_latency;
+    }
+
+    ClockSync &clockSync()
+    {
+      return clock_sync;
+    }
+
+    /**
+    * Ack timeouts of every kind of send. Configure it, adaptive or fixed,
+    * while the Transport is not in use; it is kept across configure().
+    */
+    RttEstimator &rttEstimator()
+    {
+      return rtt_estimator;
+    }
+
+    /**
+    * When the MCU took the sample in a data message received here, on the
+    * steady clock; its receive time until the clock estimate has settled.
+    */
+    std::chrono::steady_clock::time_point sampleTime(Message &msg)
+    {
+      return clock_sync.toHost(msg.getTimestamp(), msg.getRxTime());
+    }
+
+    bool startCapture(const char *path);
+
+    void stopCapture();
+
+    /**
+    * Recorder used by startCapture(), null if a capture was never started.
+    */
+    const FrameCapture *frameCapture()
+    {
+      return capture.load(std::memory_order_acquire);
+    }
+
+    static void throwResult(enum transferResult result, uint16_t ack_code);
   };
 
 } // namespace clearpath
@@ -50,12 +50,30 @@
 
 int OpenSerial(void **handle, const char *port_name);
 
+/* Port settings applied by SetupSerialProfile() */
+typedef struct
+{
+  int baud;              /* bits per second, one of the standard termios rates */
+  int low_latency;       /* request ASYNC_LOW_LATENCY, which drops an FTDI latency timer to 1 ms */
+  int vmin;              /* termios VMIN and VTIME (tenths of a second); the port is */
+  int vtime;             /* opened O_NDELAY, so these only affect blocking readers */
+  int latency_timer_ms;  /* reported back: USB-serial latency timer, -1 if the adapter has none */
+} SerialProfile;
+
+/* 115200 8-N-1, VMIN 0 / VTIME 1, low latency left as the driver has it */
+void DefaultSerialProfile(SerialProfile *profile);
+
 int SetupSerial(void *handle);
 
+/* Returns 0 on success and fills in effective (if not null) with the settings read back from the port */
+int SetupSerialProfile(void *handle, const SerialProfile *requested, SerialProfile *effective);
+
 int WriteData(void *handle, const char *buffer, int length);
 
 int ReadData(void *handle, char *buffer, int length);
 
+int WaitForData(void *handle, int timeout_ms);
+
 int CloseSerial(void *handle);
 
 #endif /* SERIAL_H_ */
@@ -32,11 +32,24 @@
 #ifndef HUSKY_BASE_HORIZON_LEGACY_WRAPPER_H
 #define HUSKY_BASE_HORIZON_LEGACY_WRAPPER_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "husky_base/horizon_legacy/clearpath.h"
+#include "husky_base/horizon_legacy/Logger.h"
+#include "husky_base/horizon_legacy/MessageRegistry.h"
 
 namespace
 {
@@ -46,13 +59,221 @@ namespace
 namespace horizon_legacy
 {
 
-  void connect(std::string port);
+  enum LinkState
+  {
+    LINK_DOWN,        // lost, or never opened; waiting for the next reconnect attempt
+    LINK_CONNECTING,  // background thread is reopening the port and restoring settings
+    LINK_UP           // usable from the control thread
+  };
+
+  /**
+  * Outcome of Link::handshake(). On failure, step names the stage which
+  * failed or was still waiting when the deadline passed.
+  */
+  struct Handshake
+  {
+    bool ok;
+    const char *step;
+    std::chrono::steady_clock::duration elapsed;
+    std::shared_ptr<clearpath::DataEncoders> encoders;
+    // Only asked for with identify, and left null if the MCU doesn't know the request
+    std::shared_ptr<clearpath::DataFirmwareInfo> firmware;
+    std::shared_ptr<clearpath::DataPlatformInfo> platform;
+  };
+
+  /**
+  * Connection to one MCU. Owns the port's Transport and a background thread
+  * which (re)opens it; the Transport is handed back and forth through the
+  * link state: the control thread only touches it while the link is LINK_UP,
+  * the reconnect thread only while it is not, so neither needs a lock around
+  * it. Links are independent of each other, so one process can drive several
+  * robots, each from its own control thread.
+  */
+  class Link
+  {
+  public:
+    Link();
+
+    ~Link();
+
+    Link(const Link &) = delete;
+
+    Link &operator=(const Link &) = delete;
+
+    /**
+    * Link over clearpath::Transport::instance(), used by the free functions below.
+    */
+    static Link &instance();
+
+    /**
+    * Open the link to the MCU. The port is (re)opened by the background thread
+    * which retries with exponential backoff; this waits a bounded time for the
+    * first attempt and returns whether the link came up.
+    */
+    bool connect(const std::string &port, bool rx_thread = false);
+
+    bool connect(const std::string &port, bool rx_thread, std::chrono::milliseconds timeout);
+
+    /**
+    * Bring the link up and configure the MCU within one overall deadline: the
+    * port has to answer an echo, then the limits and an encoder sample are
+    * exchanged in a single batched write, along with the firmware and platform
+    * info requests if identify is set. The limits are restored after every
+    * reconnect, as with configureLimits(), whatever the outcome.
+    * @param timeout  Seconds for the whole exchange
+    */
+    Handshake handshake(const std::string &port, bool rx_thread, double max_speed, double max_accel,
+                        bool identify, double timeout);
+
+    /**
+    * Hand the link over to the background thread for reopening. Never blocks;
+    * until the link is back, the calls below return without touching the port.
+    */
+    void reconnect();
+
+    /**
+    * Hand the link over for reopening if the port has failed under it (e.g.
+    * the USB adapter was unplugged). Control thread only: the reconnect thread
+    * just records the failure, and takes the Transport once this has run.
+    * @return true if the link was handed over
+    */
+    bool checkPort();
+
+    LinkState state()
+    {
+      return static_cast<LinkState>(state_.load(std::memory_order_acquire));
+    }
+
+    bool up()
+    {
+      return state() == LINK_UP;
+    }
+
+    /**
+    * Bookkeeping for requests which got no answer. A few timeouts in a row are
+    * taken as a lost link, any answer resets the count.
+    */
+    void reportTimeout();
+
+    void reportResponse();
+
+    /**
+    * Register an action to replay every time the link is re-established, e.g.
+    * limits and subscriptions. Hooks run on the reconnect thread in key order,
+    * and return false to fail the reconnect attempt.
+    */
+    void setRestoreHook(int key, std::function<bool()> hook);
+
+    void clearRestoreHook(int key);
+
+    /**
+    * Resends of an unacknowledged message before giving up on it, from the next (re)connect.
+    */
+    void setRetries(int retries)
+    {
+      retries_ = retries;
+    }
+
+    /**
+    * Common handling of a transfer outcome: logs failures and keeps the link
+    * bookkeeping (timeouts are counted, a dead port is reconnected).
+    * @return true for TRANSFER_OK
+    */
+    bool checkResult(enum clearpath::transferResult result, uint16_t ack_code, const char *what);
+
+    /**
+    * Set the speed and acceleration limits now, if the link is up, and again after every reconnect.
+    */
+    void configureLimits(double max_speed, double max_accel);
+
+    /**
+    * Command wheel speeds. With async, the command is sent fire-and-forget and
+    * supersedes any older unacked speed command; a reconnect is only attempted
+    * once a previous command has gone unacknowledged through all its retries.
+    * The command is dropped while the link is down.
+    * @return whether the command was sent (and, unless async, acknowledged)
+    */
+    bool controlSpeed(double speed_left, double speed_right, double accel_left, double accel_right,
+                      bool async = false);
+
+    /**
+    * Round trip times of the requestData() and requestMany() calls which got their answers.
+    */
+    clearpath::LatencyHistogram &requestLatency()
+    {
+      return request_latency_;
+    }
+
+    clearpath::Transport &transport()
+    {
+      return *transport_;
+    }
+
+  private:
+    explicit Link(clearpath::Transport &transport);
+
+    void lost();
+
+    void rememberLimits(double max_speed, double max_accel);
+
+    bool waitUp(std::chrono::milliseconds timeout);
+
+    void run();
+
+    bool tryConnect(const std::string &port);
+
+    // Declared first so it is destroyed last, after the thread is joined
+    std::unique_ptr<clearpath::Transport> owned_transport_;
+    clearpath::Transport *transport_;
+
+    std::atomic<int> state_;
+    bool stopping_;
+    std::string port_;
+    std::atomic<int> retries_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+
+    std::mutex hooks_mutex_;
+    std::map<int, std::function<bool()>> hooks_;
+
+    // Only ever touched from the control thread, or by the reconnect thread while the link is down
+    int consecutive_timeouts_;
+    unsigned long speed_ticket_;
+
+    clearpath::LatencyHistogram request_latency_;
+  };
+
+  /*
+  * The calls below act on Link::instance(), for code which only ever talks to one MCU.
+  */
+  bool connect(std::string port, bool rx_thread = false);
 
   void reconnect();
 
+  LinkState linkState();
+
+  bool linkUp();
+
+  void reportTimeout();
+
+  void reportResponse();
+
+  void setRestoreHook(int key, std::function<bool()> hook);
+
+  void clearRestoreHook(int key);
+
+  clearpath::LatencyHistogram &requestLatency();
+
+  namespace detail
+  {
+    bool checkResult(enum clearpath::transferResult result, uint16_t ack_code, const char *what);
+  } // namespace detail
+
   void configureLimits(double max_speed, double max_accel);
 
-  void controlSpeed(double speed_left, double speed_right, double accel_left, double accel_right);
+  bool controlSpeed(double speed_left, double speed_right, double accel_left, double accel_right,
+                    bool async = false);
 
   template<typename T>
   struct Channel
@@ -64,61 +285,277 @@ namespace horizon_legacy
       "T must be a descendant of clearpath::Message"
     );
 
-    static Ptr getLatest(double timeout)
+    static Ptr getLatest(Link &link, double timeout)
     {
-      T *latest = 0;
-
-      // Iterate over all messages in queue and find the latest
-      while (T *next = T::popNext())
+      if (!link.up())
       {
-        if (latest)
-        {
-          delete latest;
-          latest = 0;
-        }
-        latest = next;
+        return Ptr();
       }
 
+      T *latest = popLatestRaw(link.transport());
+
       // If no messages found in queue, then poll for timeout until one is received
       if (!latest)
       {
-        latest = T::waitNext(timeout);
+        clearpath::Message *msg = 0;
+        enum clearpath::transferResult result =
+          link.transport().tryWaitNext(clearpath::MessageTraits<T>::type, timeout, &msg);
+        if (result != clearpath::TRANSFER_OK && result != clearpath::TRANSFER_TIMED_OUT)
+        {
+          link.checkResult(result, 0, "Error waiting for data: ");
+          return Ptr();
+        }
+        latest = cast(msg);
       }
 
       // If no messages received within timeout, make a request
       if (!latest)
       {
-        return requestData(timeout);
+        return requestData(link, timeout);
       }
 
-      return Ptr(latest);
+      return wrap(latest);
     }
 
-    static Ptr requestData(double timeout)
+    /**
+    * Non-blocking counterpart of getLatest(), intended for subscribed channels.
+    * Drains the queue and returns the newest message, or null if nothing has been
+    * received since the last call. Never waits and never makes a request.
+    */
+    static Ptr popLatest(Link &link)
     {
-      T *update = 0;
-      while (!update)
+      if (!link.up())
+      {
+        return Ptr();
+      }
+      return wrap(popLatestRaw(link.transport()));
+    }
+
+    /**
+    * Make one request and wait up to timeout for the answer.
+    * Returns null on timeout, or straight away while the link is down.
+    */
+    static Ptr requestData(Link &link, double timeout)
+    {
+      if (!link.up())
+      {
+        return Ptr();
+      }
+
+      clearpath::Transport &transport = link.transport();
+      // Don't mistake an old sample for the answer; can't throw, the link is up so the Transport is configured
+      transport.flush(clearpath::MessageTraits<T>::type);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+      uint16_t ack_code = 0;
+      clearpath::Message *update = 0;
+      enum clearpath::transferResult result = trySubscribe(transport, 0, &ack_code);
+      if (result == clearpath::TRANSFER_OK)
+      {
+        result = transport.tryWaitNext(clearpath::MessageTraits<T>::type,
+                                       transport.rttEstimator().dataTimeout(timeout), &update);
+      }
+      if (!link.checkResult(result, ack_code, "Error requesting data: "))
       {
-        update = T::getUpdate(timeout);
-        if (!update)
+        return Ptr();
+      }
+      link.requestLatency().record(std::chrono::steady_clock::now() - start);
+      return wrap(cast(update));
+    }
+
+    /**
+    * Subscribe now if the link is up, and again after every reconnect.
+    */
+    static void subscribe(Link &link, double frequency)
+    {
+      uint16_t freq = static_cast<uint16_t>(frequency);
+      clearpath::Transport *transport = &link.transport();
+      link.setRestoreHook(clearpath::MessageTraits<T>::type, [transport, freq]()
         {
-          reconnect();
-        }
+          return trySubscribe(*transport, freq) == clearpath::TRANSFER_OK;
+        });
+      if (!link.up())
+      {
+        return;
       }
-      return Ptr(update);
+
+      // On failure the restore hook subscribes again once the link is back
+      uint16_t ack_code = 0;
+      link.checkResult(trySubscribe(link.transport(), freq, &ack_code), ack_code, "Error subscribing to data: ");
+    }
+
+    static void unsubscribe(Link &link)
+    {
+      link.clearRestoreHook(clearpath::MessageTraits<T>::type);
+      if (!link.up())
+      {
+        return;
+      }
+
+      uint16_t ack_code = 0;
+      link.checkResult(trySubscribe(link.transport(), UNSUBSCRIBE, &ack_code), ack_code,
+                       "Error unsubscribing from data: ");
+    }
+
+    /* As above, on Link::instance() */
+    static Ptr getLatest(double timeout)
+    {
+      return getLatest(Link::instance(), timeout);
+    }
+
+    static Ptr popLatest()
+    {
+      return popLatest(Link::instance());
+    }
+
+    static Ptr requestData(double timeout)
+    {
+      return requestData(Link::instance(), timeout);
     }
 
     static void subscribe(double frequency)
     {
-      T::subscribe(frequency);
+      subscribe(Link::instance(), frequency);
     }
 
     static void unsubscribe()
     {
-      T::subscribe(UNSUBSCRIBE);
+      unsubscribe(Link::instance());
+    }
+
+  private:
+    // Control block comes from the pool too, so handing out a message stays off the heap
+    static Ptr wrap(T *msg)
+    {
+      if (!msg)
+      {
+        return Ptr();
+      }
+      return Ptr(msg, std::default_delete<T>(), clearpath::PoolAllocator<T>());
+    }
+
+    static T *popLatestRaw(clearpath::Transport &transport)
+    {
+      // Older samples of the type are discarded by the Transport
+      return cast(transport.popLatest(clearpath::MessageTraits<T>::type));
+    }
+
+    static T *cast(clearpath::Message *msg)
+    {
+      // Queues are per type and the registry fixes the class per type, so no RTTI is needed
+      return clearpath::messageCast<T>(msg);
+    }
+
+    // Same request T::subscribe() makes, without the exceptions
+    static enum clearpath::transferResult trySubscribe(clearpath::Transport &transport, uint16_t freq,
+                                                       uint16_t *ack_code = 0)
+    {
+      return clearpath::Request(clearpath::MessageTraits<T>::request, freq).trySend(transport, ack_code);
     }
 
   };
 
+  namespace detail
+  {
+    // Pack-expansion helper, evaluates its arguments in order
+    typedef int expand[];
+
+    template<typename T>
+    bool collect(Link &link, typename Channel<T>::Ptr &slot)
+    {
+      if (!slot)
+      {
+        slot = Channel<T>::popLatest(link);
+      }
+      return static_cast<bool>(slot);
+    }
+
+    template<typename... Ts, size_t... I>
+    bool collectAll(Link &link, std::tuple<typename Channel<Ts>::Ptr...> &result, std::index_sequence<I...>)
+    {
+      bool done = true;
+      (void) expand{0, (done = collect<Ts>(link, std::get<I>(result)) && done, 0)...};
+      return done;
+    }
+  } // namespace detail
+
+  /**
+  * Request one sample of each of several data types at once.
+  * All Request frames go out in a single write; acks and data are then
+  * collected in whatever order they arrive, against one combined deadline.
+  * Types that fail to arrive in time come back as null pointers, as do all
+  * of them while the link is down.
+  * @param timeout   Time to wait for the data in seconds, 0.0 for no timeout.
+  * @return A tuple holding one Channel<T>::Ptr per requested type.
+  */
+  template<typename... Ts>
+  std::tuple<typename Channel<Ts>::Ptr...> requestMany(Link &link, double timeout)
+  {
+    std::tuple<typename Channel<Ts>::Ptr...> result;
+    if (!link.up())
+    {
+      return result;
+    }
+    clearpath::Transport &transport = link.transport();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    if (timeout > 0.0)
+    {
+      deadline = start +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(timeout));
+    }
+
+    // Don't mistake old samples for the answers
+    (void) detail::expand{0, (transport.flush(clearpath::MessageTraits<Ts>::type), 0)...};
+
+    clearpath::Request requests[] = {clearpath::Request(clearpath::MessageTraits<Ts>::request, 0)...};
+    clearpath::Message *batch[sizeof...(Ts)];
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+    {
+      batch[i] = &requests[i];
+    }
+    uint16_t ack_code = 0;
+    enum clearpath::transferResult sent = transport.trySendBatch(batch, sizeof...(Ts), deadline, &ack_code);
+    if (sent == clearpath::TRANSFER_NOT_CONFIGURED)
+    {
+      link.checkResult(sent, ack_code, "Error requesting data: ");
+      return result;
+    }
+    // Otherwise some requests may still have gone through, so collect whatever turns up
+    if (sent != clearpath::TRANSFER_OK)
+    {
+      CPR_ALOG_THROTTLE(clearpath::Logger::WARNING, 1.0, "Error requesting data: %s", clearpath::transferResultString(sent));
+    }
+    else if (timeout > 0.0)
+    {
+      // All acked, so the data is on its way right behind the acks
+      deadline = std::min(deadline, std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(transport.rttEstimator().dataTimeout(timeout))));
+    }
+
+    bool complete = false;
+    while (!(complete = detail::collectAll<Ts...>(link, result, std::index_sequence_for<Ts...>())) &&
+           transport.waitForInput(deadline))
+    {
+    }
+
+    if (complete)
+    {
+      link.requestLatency().record(std::chrono::steady_clock::now() - start);
+    }
+    link.checkResult(complete ? clearpath::TRANSFER_OK : clearpath::TRANSFER_TIMED_OUT, 0,
+                        "Error collecting data: ");
+    return result;
+  }
+
+  template<typename... Ts>
+  std::tuple<typename Channel<Ts>::Ptr...> requestMany(double timeout)
+  {
+    return requestMany<Ts...>(Link::instance(), timeout);
+  }
+
 } // namespace husky_base
 #endif  // HUSKY_BASE_HORIZON_LEGACY_WRAPPER_H
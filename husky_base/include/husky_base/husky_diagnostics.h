@@ -32,62 +32,115 @@
 #ifndef HUSKY_BASE_HUSKY_DIAGNOSTICS_H
 #define HUSKY_BASE_HUSKY_DIAGNOSTICS_H
 
-#include "ros/ros.h"
-#include "diagnostic_updater/diagnostic_updater.h"
+#include <atomic>
+#include <chrono>
+
+#include "diagnostic_updater/diagnostic_updater.hpp"
+#include "husky_base/command_shaper.hpp"
 #include "husky_base/horizon_legacy_wrapper.h"
-#include "husky_msgs/HuskyStatus.h"
+#include "husky_base/sample_cache.hpp"
+#include "husky_msgs/msg/husky_status.hpp"
 
 namespace husky_base
 {
 
+  /**
+  * Control loop rate. updateControlFrequency() is called from the control
+  * thread, run() from the diagnostic updater's.
+  */
   class HuskySoftwareDiagnosticTask :
     public diagnostic_updater::DiagnosticTask
   {
   public:
-    explicit HuskySoftwareDiagnosticTask(husky_msgs::HuskyStatus &msg, double target_control_freq);
+    explicit HuskySoftwareDiagnosticTask(double target_control_freq);
 
-    void run(diagnostic_updater::DiagnosticStatusWrapper &stat);
+    void run(diagnostic_updater::DiagnosticStatusWrapper &stat) override;
 
     void updateControlFrequency(double frequency);
 
   private:
-    void reset();
+    std::atomic<double> control_freq_;
+    double target_control_freq_;
+  };
 
-    double control_freq_, target_control_freq_;
-    husky_msgs::HuskyStatus &msg_;
+  /**
+  * Health of the serial link: latency histograms of the control loop's
+  * read() and write(), of data requests and of acks, plus traffic rates,
+  * error counts from the Transport and the speed commands held back, all
+  * over the interval since the last run.
+  */
+  class HuskyLinkDiagnosticTask :
+    public diagnostic_updater::DiagnosticTask
+  {
+  public:
+    /**
+    * @param link           Connection whose Transport and request latencies are reported
+    * @param read_latency   Histogram the control loop records read() times into
+    * @param write_latency  Histogram the control loop records write() times into
+    * @param shaper         Filter the control loop passes its speed commands through
+    * @param request_warn   Warn once the slowest 1% of requests take longer than this, in seconds
+    */
+    HuskyLinkDiagnosticTask(horizon_legacy::Link &link, clearpath::LatencyHistogram &read_latency,
+                            clearpath::LatencyHistogram &write_latency, const CommandShaper &shaper,
+                            double request_warn);
+
+    void run(diagnostic_updater::DiagnosticStatusWrapper &stat) override;
+
+  private:
+    unsigned long counterDelta(enum clearpath::Transport::counterTypes counter);
+
+    horizon_legacy::Link &link_;
+    clearpath::LatencyHistogram &read_latency_;
+    clearpath::LatencyHistogram &write_latency_;
+    const CommandShaper &shaper_;
+    double request_warn_us_;
+    unsigned long last_commands_sent_, last_commands_skipped_;
+    unsigned long last_counters_[clearpath::Transport::NUM_COUNTERS];
+    std::chrono::steady_clock::time_point last_run_;
   };
 
+  /**
+  * MCU status groups, reported from the samples the control loop last put
+  * in the cache; nothing here talks to the MCU.
+  */
   template<typename T>
   class HuskyHardwareDiagnosticTask :
     public diagnostic_updater::DiagnosticTask
   {
   public:
-    explicit HuskyHardwareDiagnosticTask(husky_msgs::HuskyStatus &msg);
+    explicit HuskyHardwareDiagnosticTask(const StatusCache &cache);
 
-    void run(diagnostic_updater::DiagnosticStatusWrapper &stat)
+    void run(diagnostic_updater::DiagnosticStatusWrapper &stat) override
     {
-      typename horizon_legacy::Channel<T>::Ptr latest = horizon_legacy::Channel<T>::requestData(1.0);
-      if (latest)
+      typename SampleSlot<T>::Sample latest = cache_.template slot<T>().load();
+      if (!latest.data)
       {
-        update(stat, latest);
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::STALE, "No data received");
+        return;
       }
+      update(stat, latest.data);
+      stat.add("Sample Age (s)",
+               std::chrono::duration<double>(SampleSlot<T>::Clock::now() - latest.stamp).count());
     }
 
     void update(diagnostic_updater::DiagnosticStatusWrapper &stat, typename horizon_legacy::Channel<T>::Ptr &status);
 
   private:
-    husky_msgs::HuskyStatus &msg_;
+    const StatusCache &cache_;
+    husky_msgs::msg::HuskyStatus msg_;
   };
 
   template<>
-  HuskyHardwareDiagnosticTask<clearpath::DataSystemStatus>::HuskyHardwareDiagnosticTask(husky_msgs::HuskyStatus &msg);
+  HuskyHardwareDiagnosticTask<clearpath::DataSystemStatus>::HuskyHardwareDiagnosticTask(
+    const StatusCache &cache);
 
   template<>
-  HuskyHardwareDiagnosticTask<clearpath::DataPowerSystem>::HuskyHardwareDiagnosticTask(husky_msgs::HuskyStatus &msg);
+  HuskyHardwareDiagnosticTask<clearpath::DataPowerSystem>::HuskyHardwareDiagnosticTask(
+    const StatusCache &cache);
 
   template<>
   HuskyHardwareDiagnosticTask<clearpath::DataSafetySystemStatus>::HuskyHardwareDiagnosticTask(
-    husky_msgs::HuskyStatus &msg);
+    const StatusCache &cache);
 
   template<>
   void HuskyHardwareDiagnosticTask<clearpath::DataSystemStatus>::update(
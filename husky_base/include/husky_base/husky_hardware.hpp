@@ -17,8 +17,15 @@
 #include "rclcpp/macros.hpp"
 #include "rclcpp/rclcpp.hpp"
 
+#include "diagnostic_updater/diagnostic_updater.hpp"
+#include "husky_base/command_shaper.hpp"
 #include "husky_base/horizon_legacy_wrapper.h"
+#include "husky_base/husky_diagnostics.h"
 #include "husky_base/husky_status.hpp"
+#include "husky_base/imu_state.hpp"
+#include "husky_base/rate_scheduler.hpp"
+#include "husky_base/sample_cache.hpp"
+#include "husky_base/velocity_estimator.hpp"
 
 
 using namespace std::chrono_literals;
@@ -55,25 +62,99 @@ public:
 
 private:
   void resetTravelOffset();
+  void applyTravelOffset(clearpath::DataEncoders &enc);
   double linearToAngular(const double &travel) const;
   double angularToLinear(const double &angle) const;
   void writeCommandsToHardware();
   void limitDifferentialSpeed(double &diff_speed_left, double &diff_speed_right);
-  void updateJointsFromHardware();
-  void readStatusFromHardware();
+  void updateJointsFromHardware(uint32_t groups);
+  void updateJointPositions(const horizon_legacy::Channel<clearpath::DataEncoders>::Ptr &enc);
+  void updateJointVelocities(const horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::Ptr &speed);
+  std::chrono::steady_clock::time_point stampSample(clearpath::Message &msg);
+  void updateSampleAges();
+  void readStatusFromHardware(uint32_t groups);
+  void readSafetyStatus();
+  void readPowerStatus();
+  void readSystemStatus();
+  void readImu();
+  bool checkLink();
   uint8_t isLeft(const std::string &str);
 
   // ROS Parameters
   std::string serial_port_;
   double polling_timeout_;
+  // Rate at which the MCU streams encoder and speed data, 0 to poll every read()
+  double streaming_frequency_;
+  // Parse serial input on a background thread instead of inside read()/write()
+  bool rx_thread_;
+  // Send speed commands without blocking write() on the MCU's ack
+  bool async_commands_;
+  // Seconds configure() may spend bringing up and configuring the MCU, 0 to leave it to the background
+  double startup_timeout_;
+  // Ask for the firmware and platform info during startup, for the log
+  bool startup_identify_;
+  // Where joint velocities come from; all but the first need no DataDifferentialSpeed traffic
+  enum VelocitySource
+  {
+    VELOCITY_DIFFERENTIAL_SPEED,  // DataDifferentialSpeed, requested or streamed alongside the encoders
+    VELOCITY_ENCODER_SPEED,       // speeds reported in DataEncoders, estimated from travel if absent
+    VELOCITY_ENCODER_TRAVEL       // estimated from timestamped encoder travel
+  } velocity_source_;
   double wheel_diameter_, max_accel_, max_speed_;
 
+  // This robot's MCU connection and Transport; declared ahead of everything
+  // that uses it, so it goes last
+  horizon_legacy::Link link_;
+
   // Store the command for the robot
   std::vector<double> hw_commands_;
   std::vector<double> hw_states_position_, hw_states_position_offset_, hw_states_velocity_;
+  std::vector<VelocityEstimator> velocity_estimators_;
+
+  // When the MCU took the latest encoder and speed samples, latency compensated
+  std::chrono::steady_clock::time_point encoder_stamp_, speed_stamp_;
+  // Exported as state interfaces of the hardware component, in seconds: how long
+  // before the end of read() the samples were taken, and how long the latest one
+  // took to get from the MCU to us
+  double hw_encoder_age_, hw_speed_age_, hw_link_latency_;
 
   uint8_t left_cmd_joint_index_, right_cmd_joint_index_;
 
+  // Last time a streamed sample arrived, used to detect a stalled subscription
+  std::chrono::steady_clock::time_point last_stream_sample_;
+  bool stream_stalled_;
+
+  // Whether the link was down on the last read, so its return can be logged
+  bool link_down_reported_;
+
+  // Holds back speed commands which would not change anything
+  CommandShaper command_shaper_;
+  // Safety flags of the latest DataSafetySystemStatus, a change forces the next command out
+  uint16_t safety_flags_;
+
+  // Which data groups read() fetches on each tick
+  RateScheduler read_scheduler_;
+
+  // IMU sensor state from the MCU's platform data, streamed at imu_rate_ when a sensor is declared
+  ImuState imu_;
+  double imu_rate_;
+
+  // Expected controller_manager update rate, for the software diagnostics
+  double control_frequency_;
+  std::chrono::steady_clock::time_point last_read_;
+  clearpath::LatencyHistogram read_latency_, write_latency_;
+
+  // Latest status samples, filled by read() and shared with the diagnostics
+  StatusCache status_cache_;
+
+  // Declared ahead of status_node_, so its executor thread is gone before they are
+  std::unique_ptr<HuskySoftwareDiagnosticTask> software_task_;
+  std::unique_ptr<HuskyLinkDiagnosticTask> link_task_;
+  std::unique_ptr<HuskyHardwareDiagnosticTask<clearpath::DataSafetySystemStatus>> safety_task_;
+  std::unique_ptr<HuskyHardwareDiagnosticTask<clearpath::DataPowerSystem>> power_task_;
+  std::unique_ptr<HuskyHardwareDiagnosticTask<clearpath::DataSystemStatus>> system_task_;
+  std::shared_ptr<diagnostic_updater::Updater> diagnostic_updater_;
+
   std::shared_ptr<husky_status::HuskyStatus> status_node_;
   husky_msgs::msg::HuskyStatus status_msg_;
 };
@@ -26,6 +26,10 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 #ifndef HUSKY_BASE__HUSKY_STATUS_HPP
 #define HUSKY_BASE__HUSKY_STATUS_HPP
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "rclcpp/rclcpp.hpp"
 
 #include "husky_msgs/msg/husky_status.hpp"
@@ -33,18 +37,90 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 namespace husky_status
 {
 
+/**
+ * @brief Lock-free single-reader, single-writer hand-off of the latest value.
+ *
+ * Triple buffer: the writer fills its own slot and swaps it with the shared
+ * middle slot, the reader swaps the middle slot for its own when it is fresh.
+ * Neither side blocks or allocates, and intermediate values are simply
+ * overwritten if the reader falls behind.
+ */
+template<typename T>
+class LatestValueMailbox
+{
+  public:
+  LatestValueMailbox()
+  : back_(0), middle_(1), front_(2)
+  {
+  }
+
+  /**
+   * @brief Writer side, publish a new latest value
+   */
+  void write(const T & value)
+  {
+    slots_[back_] = value;
+    back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  /**
+   * @brief Reader side, take the latest value if one arrived since the last take
+   *
+   * @return Pointer to the value, valid until the next take(), or nullptr
+   */
+  const T * take()
+  {
+    if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0)
+    {
+      return nullptr;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+    return &slots_[front_];
+  }
+
+  private:
+  static const unsigned int INDEX_MASK = 0x3;
+  static const unsigned int FRESH = 0x4;
+
+  T slots_[3];
+  unsigned int back_;                 // owned by the writer
+  std::atomic<unsigned int> middle_;  // shared, index plus FRESH flag
+  unsigned int front_;                // owned by the reader
+};
+
 class HuskyStatus
 : public rclcpp::Node
 {
   public:
-  explicit HuskyStatus();
+  explicit HuskyStatus(
+    const rclcpp::NodeOptions & options = rclcpp::NodeOptions().use_intra_process_comms(true));
+
+  ~HuskyStatus();
 
-  void publish_status(husky_msgs::msg::HuskyStatus status_msg);
+  /**
+   * @brief Spin this node on its own executor thread and publish posted status at up to rate hz
+   */
+  void start_publishing(double rate);
+
+  void stop_publishing();
+
+  /**
+   * @brief Hand a status message to the publishing thread; real-time safe
+   */
+  void post_status(const husky_msgs::msg::HuskyStatus & status_msg);
+
+  void publish_status(const husky_msgs::msg::HuskyStatus & status_msg);
 
   private:
+  void publish_pending();
+
   rclcpp::Publisher<husky_msgs::msg::HuskyStatus>::SharedPtr pub_status_;
+  rclcpp::TimerBase::SharedPtr publish_timer_;
+  rclcpp::executors::SingleThreadedExecutor executor_;
+  std::thread executor_thread_;
+  LatestValueMailbox<husky_msgs::msg::HuskyStatus> mailbox_;
 };
 
 }
 
-#endif  // HUSKY_BASE__HUSKY_STATUS_HPP
\ No newline at end of file
+#endif  // HUSKY_BASE__HUSKY_STATUS_HPP
@@ -0,0 +1,120 @@
+/**
+Software License Agreement (BSD)
+
+\file      imu_state.hpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef HUSKY_BASE__IMU_STATE_HPP_
+#define HUSKY_BASE__IMU_STATE_HPP_
+
+#include <cstdint>
+#include <string>
+
+namespace husky_base
+{
+
+/**
+* Backing store for the state interfaces of an IMU sensor fed by the MCU's
+* platform orientation, rotation, acceleration and magnetometer data. The
+* interfaces are named as imu_sensor_broadcaster expects them (orientation.x,
+* angular_velocity.z, linear_acceleration.y, ...), plus magnetic_field.x/y/z.
+* Each data source is only subscribed to if one of its interfaces is declared.
+* Values are NaN until the first sample of their source arrives.
+*/
+class ImuState
+{
+public:
+  enum Source
+  {
+    ORIENTATION,
+    ROTATION,
+    ACCELERATION,
+    MAGNETOMETER,
+    NUM_SOURCES
+  };
+
+  ImuState();
+
+  /**
+  * Declare a state interface by name.
+  * @return where its value lives, or null if the name is not one of ours
+  */
+  double *addInterface(const std::string &name);
+
+  /**
+  * Whether any declared interface is fed by this source.
+  */
+  bool uses(Source source) const
+  {
+    return (sources_ & (1u << source)) != 0;
+  }
+
+  bool empty() const
+  {
+    return sources_ == 0;
+  }
+
+  /**
+  * Orientation as reported by the MCU, in radians, turned into a quaternion.
+  */
+  void setOrientation(double roll, double pitch, double yaw);
+
+  /**
+  * Rotation rates in rad/s.
+  */
+  void setRotation(double roll_rate, double pitch_rate, double yaw_rate);
+
+  /**
+  * Acceleration in g, stored in m/s^2.
+  */
+  void setAcceleration(double x, double y, double z);
+
+  /**
+  * Magnetometer reading, stored as reported.
+  */
+  void setMagnetometer(double x, double y, double z);
+
+private:
+  enum Field
+  {
+    ORIENTATION_X,
+    ORIENTATION_Y,
+    ORIENTATION_Z,
+    ORIENTATION_W,
+    ANGULAR_VELOCITY_X,
+    ANGULAR_VELOCITY_Y,
+    ANGULAR_VELOCITY_Z,
+    LINEAR_ACCELERATION_X,
+    LINEAR_ACCELERATION_Y,
+    LINEAR_ACCELERATION_Z,
+    MAGNETIC_FIELD_X,
+    MAGNETIC_FIELD_Y,
+    MAGNETIC_FIELD_Z,
+    NUM_FIELDS
+  };
+
+  double values_[NUM_FIELDS];
+  uint32_t sources_;
+};
+
+}  // namespace husky_base
+
+#endif  // HUSKY_BASE__IMU_STATE_HPP_
@@ -0,0 +1,94 @@
+/**
+Software License Agreement (BSD)
+
+\file      rate_scheduler.hpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef HUSKY_BASE__RATE_SCHEDULER_HPP_
+#define HUSKY_BASE__RATE_SCHEDULER_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+namespace husky_base
+{
+
+/**
+* Decides which data groups to read from the MCU on each control tick.
+* Groups without a rate are read every tick. Groups with a rate are read when
+* their period has elapsed, measured in wall time so the rate does not depend
+* on the controller's update rate. Groups marked exclusive (the slow status
+* reads) are staggered and at most one of them is handed out per tick, so
+* their serial round trips never stack up on the same tick.
+*/
+class RateScheduler
+{
+public:
+  enum Group
+  {
+    ENCODERS,
+    SPEEDS,
+    SAFETY,
+    POWER,
+    SYSTEM,
+    NUM_GROUPS
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  RateScheduler();
+
+  /**
+  * Set a group's target rate in hz, 0 to read it on every tick.
+  */
+  void setRate(Group group, double rate, bool exclusive);
+
+  /**
+  * Restart all periods from now, staggering the exclusive groups across one period.
+  */
+  void reset(Clock::time_point now);
+
+  /**
+  * Groups to read on this tick, as a bitmask of (1 << Group).
+  */
+  uint32_t due(Clock::time_point now);
+
+  static bool includes(uint32_t mask, Group group)
+  {
+    return (mask & (1u << group)) != 0;
+  }
+
+private:
+  struct Entry
+  {
+    Clock::duration period;  // zero means every tick
+    bool exclusive;
+    Clock::time_point next_due;
+  };
+
+  static void advance(Entry &entry, Clock::time_point now);
+
+  Entry groups_[NUM_GROUPS];
+};
+
+}  // namespace husky_base
+
+#endif  // HUSKY_BASE__RATE_SCHEDULER_HPP_
@@ -0,0 +1,105 @@
+/**
+Software License Agreement (BSD)
+
+\file      sample_cache.hpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef HUSKY_BASE__SAMPLE_CACHE_HPP_
+#define HUSKY_BASE__SAMPLE_CACHE_HPP_
+
+#include <chrono>
+#include <memory>
+#include <tuple>
+
+#include "husky_base/horizon_legacy_wrapper.h"
+
+namespace husky_base
+{
+
+/**
+* Latest sample of one MCU data type with the time it was received. One
+* thread stores (the control loop), any number of threads load; a loaded
+* sample stays valid however long the reader holds on to it.
+*/
+template<typename T>
+class SampleSlot
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Sample
+  {
+    typename horizon_legacy::Channel<T>::Ptr data;
+    Clock::time_point stamp;
+  };
+
+  void store(const typename horizon_legacy::Channel<T>::Ptr &data, Clock::time_point stamp)
+  {
+    std::shared_ptr<const Sample> sample = std::make_shared<const Sample>(Sample{data, stamp});
+    std::atomic_store_explicit(&latest_, sample, std::memory_order_release);
+  }
+
+  /**
+  * Latest sample, or one with null data if nothing has been stored yet.
+  */
+  Sample load() const
+  {
+    std::shared_ptr<const Sample> sample = std::atomic_load_explicit(&latest_, std::memory_order_acquire);
+    return sample ? *sample : Sample();
+  }
+
+private:
+  std::shared_ptr<const Sample> latest_;
+};
+
+/**
+* One SampleSlot per data type, so a sample read from the MCU once can be
+* handed to every consumer that wants it.
+*/
+template<typename ... Ts>
+class SampleCache
+{
+public:
+  template<typename T>
+  SampleSlot<T> & slot()
+  {
+    return std::get<SampleSlot<T>>(slots_);
+  }
+
+  template<typename T>
+  const SampleSlot<T> & slot() const
+  {
+    return std::get<SampleSlot<T>>(slots_);
+  }
+
+private:
+  std::tuple<SampleSlot<Ts>...> slots_;
+};
+
+/**
+* The slow status groups HuskyHardware reads and the diagnostics report on.
+*/
+typedef SampleCache<clearpath::DataSafetySystemStatus, clearpath::DataPowerSystem, clearpath::DataSystemStatus>
+  StatusCache;
+
+}  // namespace husky_base
+
+#endif  // HUSKY_BASE__SAMPLE_CACHE_HPP_
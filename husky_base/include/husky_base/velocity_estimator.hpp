@@ -0,0 +1,93 @@
+/**
+Software License Agreement (BSD)
+
+\file      velocity_estimator.hpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef HUSKY_BASE__VELOCITY_ESTIMATOR_HPP_
+#define HUSKY_BASE__VELOCITY_ESTIMATOR_HPP_
+
+#include <cstddef>
+
+namespace husky_base
+{
+
+/**
+* Velocity of one wheel from successive position readings, each dated with
+* when it was sampled (the MCU's timestamp, through the link's clock
+* estimate) rather than when it arrived, so serial and scheduling delays
+* don't turn into speed noise. Either a finite difference over the last few
+* samples, or an alpha-beta tracker.
+*/
+class VelocityEstimator
+{
+public:
+  enum Filter
+  {
+    FINITE_DIFFERENCE,
+    ALPHA_BETA
+  };
+
+  static const size_t MAX_WINDOW = 32;
+
+  VelocityEstimator();
+
+  /**
+  * @param window  Samples the finite difference spans, 1 to MAX_WINDOW
+  * @param alpha   Alpha-beta position gain, 0 to 1
+  * @param beta    Alpha-beta velocity gain, 0 to 2
+  */
+  void configure(Filter filter, size_t window, double alpha, double beta);
+
+  /**
+  * Start over from the next sample, at standstill.
+  */
+  void reset();
+
+  /**
+  * Add a position sample taken at stamp (seconds) and return the new estimate.
+  * Samples no newer than the last are ignored; after a long gap the estimate restarts.
+  */
+  double update(double position, double stamp);
+
+  double velocity() const
+  {
+    return velocity_;
+  }
+
+private:
+  Filter filter_;
+  size_t window_;
+  double alpha_, beta_;
+
+  // Last window_ + 1 samples, for the finite difference
+  double positions_[MAX_WINDOW + 1];
+  double stamps_[MAX_WINDOW + 1];
+  size_t count_, next_;
+
+  // Alpha-beta state
+  double position_;
+  double velocity_;
+};
+
+}  // namespace husky_base
+
+#endif  // HUSKY_BASE__VELOCITY_ESTIMATOR_HPP_
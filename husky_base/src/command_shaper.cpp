@@ -0,0 +1,80 @@
+/**
+Software License Agreement (BSD)
+
+\file      command_shaper.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cmath>
+
+#include "husky_base/command_shaper.hpp"
+
+namespace husky_base
+{
+
+  CommandShaper::CommandShaper() :
+      tolerance_(0.0),
+      keepalive_(Clock::duration::zero()),
+      pending_reset_(true),
+      last_left_(0.0),
+      last_right_(0.0),
+      sent_(0),
+      skipped_(0)
+  {
+  }
+
+  void CommandShaper::configure(double tolerance, double keepalive)
+  {
+    tolerance_ = tolerance > 0 ? tolerance : 0.0;
+    keepalive_ = keepalive > 0 ?
+      std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(keepalive)) :
+      Clock::duration::zero();
+    reset();
+  }
+
+  void CommandShaper::reset()
+  {
+    pending_reset_ = true;
+  }
+
+  bool CommandShaper::shouldSend(double left, double right, Clock::time_point now)
+  {
+    bool send = keepalive_ == Clock::duration::zero() || pending_reset_ ||
+      now - last_sent_ >= keepalive_ ||
+      std::abs(left - last_left_) > tolerance_ || std::abs(right - last_right_) > tolerance_ ||
+      (left == 0.0 && right == 0.0 && (last_left_ != 0.0 || last_right_ != 0.0));
+    if (!send)
+    {
+      skipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return send;
+  }
+
+  void CommandShaper::sent(double left, double right, Clock::time_point now)
+  {
+    pending_reset_ = false;
+    last_left_ = left;
+    last_right_ = right;
+    last_sent_ = now;
+    sent_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+}  // namespace husky_base
@@ -0,0 +1,184 @@
+/**
+Software License Agreement (BSD)
+
+\file      CaptureReplay.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "husky_base/horizon_legacy/CaptureReplay.h"
+
+namespace clearpath
+{
+
+  const int CaptureReplay::WAKEUP_MS;
+
+  CaptureReplay::CaptureReplay() :
+      master(-1),
+      running(false),
+      done(false),
+      replayed(0)
+  {
+    port_name[0] = '\0';
+  }
+
+  CaptureReplay::~CaptureReplay()
+  {
+    stop();
+    if (master >= 0)
+    {
+      ::close(master);
+    }
+  }
+
+  bool CaptureReplay::open(const char *capture_path)
+  {
+    if (!capture.open(capture_path))
+    {
+      return false;
+    }
+
+    master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+        ptsname_r(master, port_name, sizeof(port_name)) != 0)
+    {
+      if (master >= 0)
+      {
+        ::close(master);
+        master = -1;
+      }
+      return false;
+    }
+    return true;
+  }
+
+  void CaptureReplay::play(double speed)
+  {
+    stop();
+    capture.rewind();
+    done = false;
+    replayed = 0;
+    running = true;
+    thread = std::thread(&CaptureReplay::threadMain, this, speed);
+  }
+
+  void CaptureReplay::stop()
+  {
+    if (!running)
+    {
+      return;
+    }
+    running = false;
+    thread.join();
+  }
+
+  void CaptureReplay::discardInput()
+  {
+    uint8_t buf[512];
+    while (::read(master, buf, sizeof(buf)) > 0)
+    {
+    }
+  }
+
+  bool CaptureReplay::writeAll(const uint8_t *data, size_t len)
+  {
+    while (len > 0)
+    {
+      ssize_t n = ::write(master, data, len);
+      if (n > 0)
+      {
+        data += n;
+        len -= static_cast<size_t>(n);
+        continue;
+      }
+      // Reader is behind, wait for room, and keep its writes from backing up meanwhile
+      discardInput();
+      struct pollfd pfd;
+      pfd.fd = master;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+      ::poll(&pfd, 1, WAKEUP_MS);
+      if (!running)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void CaptureReplay::threadMain(double speed)
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t first_ns = 0;
+    bool first = true;
+
+    CaptureFile::Record record;
+    while (running && capture.next(record))
+    {
+      if (record.direction != CAPTURE_RX)
+      {
+        continue;
+      }
+      if (first)
+      {
+        first_ns = record.stamp_ns;
+        first = false;
+      }
+
+      if (speed > 0.0)
+      {
+        std::chrono::steady_clock::time_point due = start + std::chrono::duration_cast<
+            std::chrono::steady_clock::duration>(std::chrono::nanoseconds(record.stamp_ns - first_ns) / speed);
+        while (running && std::chrono::steady_clock::now() < due)
+        {
+          discardInput();
+          std::chrono::steady_clock::duration left = due - std::chrono::steady_clock::now();
+          std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+              left, std::chrono::milliseconds(WAKEUP_MS)));
+        }
+      }
+
+      if (!writeAll(record.data, record.len))
+      {
+        break;
+      }
+      replayed.fetch_add(record.len, std::memory_order_relaxed);
+    }
+    done.store(true, std::memory_order_release);
+
+    // Keep draining so the reader never blocks on a full port while it winds down
+    while (running)
+    {
+      discardInput();
+      std::this_thread::sleep_for(std::chrono::milliseconds(WAKEUP_MS));
+    }
+  }
+
+} // namespace clearpath
@@ -0,0 +1,235 @@
+/**
+Software License Agreement (BSD)
+
+\file      ClockSync.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "husky_base/horizon_legacy/ClockSync.h"
+
+namespace
+{
+  // Stretch of MCU time each bucket keeps the least delayed frame of
+  const double BUCKET_LEN = 1.0;
+  // Crystals are good to tens of ppm; anything far beyond is not a clock
+  const double MAX_DRIFT = 1e-3;
+  // Change in delay between two frames taken as the MCU clock being set or restarted
+  const double MAX_JUMP = 1.0;
+  const double NEVER = std::numeric_limits<double>::infinity();
+}
+
+namespace clearpath
+{
+
+  const size_t ClockSync::MAX_BUCKETS;
+
+  ClockSync::ClockSync() :
+      wire_byte_time(10.0 / 115200)
+  {
+    reset();
+  }
+
+  void ClockSync::reset()
+  {
+    restart();
+    rtt_min = rtt_window_min = NEVER;
+    rtt_count = 0;
+    path_delay = 0.0;
+    samples = 0;
+    resets = 0;
+
+    std::lock_guard<std::mutex> lock(published_mutex);
+    published = Estimate();
+  }
+
+  void ClockSync::restart()
+  {
+    started = false;
+    num_buckets = 0;
+    next_bucket = 0;
+    current_count = 0;
+    fit.synced = false;
+    fit.offset = 0.0;
+    fit.drift = 0.0;
+  }
+
+  void ClockSync::setBaud(int baud)
+  {
+    if (baud > 0)
+    {
+      wire_byte_time = 10.0 / baud;
+    }
+  }
+
+  void ClockSync::addSample(uint32_t mcu_ms, Clock::time_point rx_time, size_t frame_len)
+  {
+    int64_t host_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(rx_time.time_since_epoch()).count();
+    if (!started)
+    {
+      started = true;
+      last_raw_ms = mcu_ms;
+      last_mcu_ms = mcu_ms;
+      origin_mcu_ms = mcu_ms;
+      origin_host_ns = host_ns;
+    }
+
+    int64_t mcu = unwrap(mcu_ms);
+    double x = (mcu - origin_mcu_ms) * 1e-3;
+    // Taken from when the first byte went out, so frames of any length line up
+    double d = (host_ns - origin_host_ns) * 1e-9 - wireTime(frame_len) - x;
+
+    if (current_count + num_buckets > 0 && std::abs(d - last_d) > MAX_JUMP)
+    {
+      ++resets;
+      restart();
+      addSample(mcu_ms, rx_time, frame_len);
+      return;
+    }
+    last_raw_ms = mcu_ms;
+    last_mcu_ms = mcu;
+    last_d = d;
+    ++samples;
+
+    if (current_count && x - current_start >= BUCKET_LEN)
+    {
+      buckets[next_bucket] = current;
+      next_bucket = (next_bucket + 1) % MAX_BUCKETS;
+      num_buckets = std::min(num_buckets + 1, MAX_BUCKETS);
+      current_count = 0;
+      refit();
+    }
+    if (!current_count)
+    {
+      current_start = x;
+      current.x = x;
+      current.d = d;
+    }
+    else if (d < current.d)
+    {
+      current.x = x;
+      current.d = d;
+    }
+    ++current_count;
+
+    if (fit.synced)
+    {
+      double residual = d - (fit.offset + fit.drift * x);
+      if (residual < 0.0)
+      {
+        // Quicker than anything before it; the line was too high
+        fit.offset += residual;
+        residual = 0.0;
+      }
+      link_latency.recordMicros(static_cast<uint64_t>((residual + wireTime(frame_len) + path_delay) * 1e6));
+    }
+  }
+
+  void ClockSync::addRoundTrip(Clock::duration rtt, size_t tx_len, size_t rx_len)
+  {
+    double delay = std::chrono::duration<double>(rtt).count() - wireTime(tx_len) - wireTime(rx_len);
+    rtt_window_min = std::min(rtt_window_min, std::max(delay, 0.0));
+    if (++rtt_count % RTT_WINDOW == 0)
+    {
+      // Minimum over the last one to two windows, so it can follow the link getting slower
+      rtt_min = rtt_window_min;
+      rtt_window_min = NEVER;
+    }
+    path_delay = std::min(rtt_min, rtt_window_min) / 2;
+  }
+
+/**
+* Least squares drift through the bucket minima, then the offset that puts
+* the line under all of them.
+*/
+  void ClockSync::refit()
+  {
+    if (num_buckets < MIN_BUCKETS)
+    {
+      return;
+    }
+
+    double mean_x = 0.0, mean_d = 0.0;
+    for (size_t i = 0; i < num_buckets; ++i)
+    {
+      mean_x += buckets[i].x;
+      mean_d += buckets[i].d;
+    }
+    mean_x /= num_buckets;
+    mean_d /= num_buckets;
+
+    double sxx = 0.0, sxd = 0.0;
+    for (size_t i = 0; i < num_buckets; ++i)
+    {
+      sxx += (buckets[i].x - mean_x) * (buckets[i].x - mean_x);
+      sxd += (buckets[i].x - mean_x) * (buckets[i].d - mean_d);
+    }
+    double drift = sxx > 0.0 ? sxd / sxx : 0.0;
+
+    double offset = NEVER;
+    for (size_t i = 0; i < num_buckets; ++i)
+    {
+      offset = std::min(offset, buckets[i].d - drift * buckets[i].x);
+    }
+
+    // Timestamps that don't advance with the host clock (or an MCU that leaves them zero) never sync
+    fit.synced = std::abs(drift) <= MAX_DRIFT;
+    fit.offset = offset;
+    fit.drift = drift;
+
+    std::lock_guard<std::mutex> lock(published_mutex);
+    published.synced = fit.synced;
+    double x = (last_mcu_ms - origin_mcu_ms) * 1e-3;
+    published.offset = (origin_host_ns * 1e-9 - origin_mcu_ms * 1e-3) + offset + drift * x - path_delay;
+    published.drift = -drift / (1.0 + drift);
+    published.path_delay = path_delay;
+    published.samples = samples;
+    published.resets = resets;
+  }
+
+  ClockSync::Clock::time_point ClockSync::toHost(uint32_t mcu_ms, Clock::time_point rx_time) const
+  {
+    if (!fit.synced)
+    {
+      return rx_time;
+    }
+
+    double x = (unwrap(mcu_ms) - origin_mcu_ms) * 1e-3;
+    double host = x + fit.offset + fit.drift * x - path_delay;
+    Clock::time_point stamp = Clock::time_point(std::chrono::nanoseconds(origin_host_ns)) +
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(host));
+    if (stamp > rx_time || rx_time - stamp > std::chrono::duration<double>(MAX_JUMP))
+    {
+      return rx_time;
+    }
+    return stamp;
+  }
+
+  ClockSync::Estimate ClockSync::estimate() const
+  {
+    std::lock_guard<std::mutex> lock(published_mutex);
+    return published;
+  }
+
+} // namespace clearpath
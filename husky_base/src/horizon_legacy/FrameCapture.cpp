@@ -0,0 +1,275 @@
+/**
+Software License Agreement (BSD)
+
+\file      FrameCapture.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <new>
+
+#include "husky_base/horizon_legacy/FrameCapture.h"
+
+namespace clearpath
+{
+
+  const int FrameCapture::WRITER_WAKEUP_MS;
+
+  namespace
+  {
+    uint64_t steadyNanos()
+    {
+      return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+  } // namespace
+
+  FrameCapture::FrameCapture() :
+      file(NULL),
+      active(false),
+      writer_running(false),
+      recorded_count(0),
+      dropped_count(0)
+  {
+  }
+
+  FrameCapture::~FrameCapture()
+  {
+    close();
+  }
+
+  void *FrameCapture::operator new(size_t size)
+  {
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, alignof(FrameCapture), size) != 0)
+    {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+  void FrameCapture::operator delete(void *ptr)
+  {
+    free(ptr);
+  }
+
+  bool FrameCapture::open(const char *path)
+  {
+    close();
+
+    file = fopen(path, "wb");
+    if (!file)
+    {
+      return false;
+    }
+
+    CaptureFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.header_len = sizeof(header);
+    header.start_ns = steadyNanos();
+    fwrite(&header, sizeof(header), 1, file);
+
+    // Anything a producer slipped in after the previous close() belongs to that capture
+    Chunk stale;
+    while (ring.pop(stale))
+    {
+    }
+
+    recorded_count = 0;
+    dropped_count = 0;
+    writer_running = true;
+    writer = std::thread(&FrameCapture::writerMain, this);
+    active.store(true, std::memory_order_release);
+    return true;
+  }
+
+  void FrameCapture::close()
+  {
+    if (!file)
+    {
+      return;
+    }
+    // Producers check active before touching the ring; whatever they already
+    // pushed is picked up by the writer's final drain
+    active.store(false, std::memory_order_release);
+    writer_running = false;
+    writer.join();
+    fclose(file);
+    file = NULL;
+  }
+
+  void FrameCapture::record(enum captureDirection direction, const uint8_t *data, size_t len)
+  {
+    if (!active.load(std::memory_order_acquire))
+    {
+      return;
+    }
+
+    uint64_t stamp = steadyNanos();
+    while (len > 0)
+    {
+      Chunk chunk;
+      size_t n = len < CAPTURE_MAX_CHUNK ? len : CAPTURE_MAX_CHUNK;
+      memset(&chunk.header, 0, sizeof(chunk.header));
+      chunk.header.stamp_ns = stamp;
+      chunk.header.len = static_cast<uint16_t>(n);
+      chunk.header.direction = static_cast<uint8_t>(direction);
+      memcpy(chunk.data, data, n);
+
+      if (ring.push(chunk))
+      {
+        recorded_count.fetch_add(1, std::memory_order_relaxed);
+      }
+      else
+      {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+      }
+      data += n;
+      len -= n;
+    }
+  }
+
+  bool FrameCapture::drain()
+  {
+    static const uint8_t padding[8] = {0};
+    bool any = false;
+    Chunk chunk;
+    while (ring.pop(chunk))
+    {
+      size_t len = chunk.header.len;
+      fwrite(&chunk.header, sizeof(chunk.header), 1, file);
+      fwrite(chunk.data, 1, len, file);
+      fwrite(padding, 1, captureRecordSize(len) - sizeof(chunk.header) - len, file);
+      any = true;
+    }
+    return any;
+  }
+
+  void FrameCapture::writerMain()
+  {
+    while (writer_running.load(std::memory_order_relaxed))
+    {
+      if (drain())
+      {
+        // Keep the file current, a capture is most useful right up to a crash
+        fflush(file);
+      }
+      else
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_WAKEUP_MS));
+      }
+    }
+    drain();
+    fflush(file);
+  }
+
+  CaptureFile::CaptureFile() :
+      base(NULL),
+      size(0),
+      offset(0)
+  {
+  }
+
+  CaptureFile::~CaptureFile()
+  {
+    close();
+  }
+
+  bool CaptureFile::open(const char *path)
+  {
+    close();
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(CaptureFileHeader))
+    {
+      ::close(fd);
+      return false;
+    }
+    void *mapped = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+      return false;
+    }
+    base = static_cast<const uint8_t *>(mapped);
+    size = static_cast<size_t>(st.st_size);
+
+    const CaptureFileHeader *header = reinterpret_cast<const CaptureFileHeader *>(base);
+    if (memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CAPTURE_VERSION || header->header_len != sizeof(CaptureFileHeader))
+    {
+      close();
+      return false;
+    }
+    madvise(const_cast<uint8_t *>(base), size, MADV_SEQUENTIAL);
+    rewind();
+    return true;
+  }
+
+  void CaptureFile::close()
+  {
+    if (base)
+    {
+      munmap(const_cast<uint8_t *>(base), size);
+    }
+    base = NULL;
+    size = 0;
+    offset = 0;
+  }
+
+  uint64_t CaptureFile::startTime() const
+  {
+    return base ? reinterpret_cast<const CaptureFileHeader *>(base)->start_ns : 0;
+  }
+
+  bool CaptureFile::next(Record &record)
+  {
+    if (!base || size - offset < sizeof(CaptureRecordHeader))
+    {
+      return false;
+    }
+    const CaptureRecordHeader *header = reinterpret_cast<const CaptureRecordHeader *>(base + offset);
+    if (header->len > CAPTURE_MAX_CHUNK || size - offset < captureRecordSize(header->len))
+    {
+      return false;
+    }
+    record.stamp_ns = header->stamp_ns;
+    record.direction = static_cast<enum captureDirection>(header->direction);
+    record.data = base + offset + sizeof(CaptureRecordHeader);
+    record.len = header->len;
+    offset += captureRecordSize(header->len);
+    return true;
+  }
+
+} // namespace clearpath
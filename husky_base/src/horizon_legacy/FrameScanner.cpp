@@ -0,0 +1,117 @@
+/**
+Software License Agreement (BSD)
+
+\file      FrameScanner.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+
+#include "husky_base/horizon_legacy/FrameScanner.h"
+#include "husky_base/horizon_legacy/Message.h"
+
+namespace clearpath
+{
+
+  FrameScanner::FrameScanner() :
+      head(0),
+      tail(0)
+  {
+  }
+
+  size_t FrameScanner::prepare()
+  {
+    if (head == tail)
+    {
+      head = tail = 0;
+    }
+    else if (head > 0 && (BUFFER_LEN - tail) < Message::MAX_MSG_LENGTH)
+    {
+      // Slide the partial frame down so there is always room for a whole one behind it
+      memmove(buf, buf + head, tail - head);
+      tail -= head;
+      head = 0;
+    }
+    return BUFFER_LEN - tail;
+  }
+
+  void FrameScanner::commit(size_t n)
+  {
+    tail += n;
+    if (tail > BUFFER_LEN)
+    {
+      tail = BUFFER_LEN;
+    }
+  }
+
+  size_t FrameScanner::append(const void *data, size_t len)
+  {
+    size_t space = prepare();
+    if (len > space)
+    {
+      len = space;
+    }
+    memcpy(writePointer(), data, len);
+    commit(len);
+    return len;
+  }
+
+  bool FrameScanner::nextFrame(const uint8_t **frame, size_t *len, unsigned long *garbled)
+  {
+    while (true)
+    {
+      /* Skip to the next SOH */
+      const uint8_t *soh = static_cast<const uint8_t *>(memchr(buf + head, Message::SOH, tail - head));
+      size_t skipped = soh ? static_cast<size_t>(soh - (buf + head)) : (tail - head);
+      head += skipped;
+      *garbled += skipped;
+
+      /* Need SOH, length and ~length before anything can be decided */
+      if (tail - head < 3)
+      {
+        return false;
+      }
+
+      uint8_t length = buf[head + 1];
+      size_t msg_len = static_cast<size_t>(length) + 3;
+      if (static_cast<uint8_t>(length ^ buf[head + 2]) != 0xFF ||
+          msg_len < Message::MIN_MSG_LENGTH || msg_len > Message::MAX_MSG_LENGTH)
+      {
+        // Not a real frame start, resume the search right after this SOH
+        ++head;
+        ++(*garbled);
+        continue;
+      }
+
+      /* Wait for the rest of the message */
+      if (tail - head < msg_len)
+      {
+        return false;
+      }
+
+      *frame = buf + head;
+      *len = msg_len;
+      head += msg_len;
+      return true;
+    }
+  }
+
+} // namespace clearpath
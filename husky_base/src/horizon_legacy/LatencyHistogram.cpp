@@ -0,0 +1,134 @@
+/**
+Software License Agreement (BSD)
+
+\file      LatencyHistogram.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "husky_base/horizon_legacy/LatencyHistogram.h"
+
+namespace clearpath
+{
+
+  LatencyHistogram::Snapshot::Snapshot() :
+      sum_us(0),
+      max_us(0)
+  {
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+      counts[i] = 0;
+    }
+  }
+
+  uint64_t LatencyHistogram::Snapshot::count() const
+  {
+    uint64_t total = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+      total += counts[i];
+    }
+    return total;
+  }
+
+  double LatencyHistogram::Snapshot::mean() const
+  {
+    uint64_t total = count();
+    return total ? static_cast<double>(sum_us) / total : 0.0;
+  }
+
+  double LatencyHistogram::Snapshot::percentile(double p) const
+  {
+    uint64_t total = count();
+    if (total == 0)
+    {
+      return 0.0;
+    }
+
+    // Rank of the sample asked for, counting from 1
+    uint64_t rank = static_cast<uint64_t>(p * total + 0.5);
+    if (rank < 1) { rank = 1; }
+    if (rank > total) { rank = total; }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+      seen += counts[i];
+      if (seen >= rank)
+      {
+        uint64_t edge = bucketUpperEdge(i);
+        return static_cast<double>(edge < max_us ? edge : max_us);
+      }
+    }
+    return static_cast<double>(max_us);
+  }
+
+  LatencyHistogram::LatencyHistogram() :
+      sum_us(0),
+      max_us(0)
+  {
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+      counts[i] = 0;
+    }
+  }
+
+  void LatencyHistogram::collect(Snapshot &snapshot)
+  {
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+      snapshot.counts[i] = counts[i].exchange(0, std::memory_order_relaxed);
+    }
+    snapshot.sum_us = sum_us.exchange(0, std::memory_order_relaxed);
+    snapshot.max_us = max_us.exchange(0, std::memory_order_relaxed);
+  }
+
+/**
+* Values below SUB_BUCKETS get a bucket each, after that every power of two
+* is split into SUB_BUCKETS equal parts.
+*/
+  size_t LatencyHistogram::bucketOf(uint64_t us)
+  {
+    if (us < SUB_BUCKETS)
+    {
+      return static_cast<size_t>(us);
+    }
+
+    size_t octave = 63 - __builtin_clzll(us);  // floor(log2(us)), at least 2
+    size_t sub = static_cast<size_t>(us >> (octave - 2)) & (SUB_BUCKETS - 1);
+    size_t bucket = (octave - 1) * SUB_BUCKETS + sub;
+    return bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1;
+  }
+
+  uint64_t LatencyHistogram::bucketUpperEdge(size_t bucket)
+  {
+    if (bucket < SUB_BUCKETS)
+    {
+      return bucket;
+    }
+
+    // Lower edge of the next bucket, less one
+    size_t next = bucket + 1;
+    size_t octave = next / SUB_BUCKETS + 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + next % SUB_BUCKETS) << (octave - 2);
+    return lower - 1;
+  }
+
+} // namespace clearpath
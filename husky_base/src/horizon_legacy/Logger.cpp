@@ -47,6 +47,8 @@
 #include <iostream>
 #include <fstream>
 #include <signal.h>
+#include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace std;
@@ -57,6 +59,116 @@ namespace clearpath
 {
 
   const char *Logger::levelNames[] = {"ERROR", "EXCEPTION", "WARNING", "INFO", "DETAIL"};
+  const int Logger::DRAIN_PERIOD_MS;
+
+  void LogRecord::add(const char *value)
+  {
+    if (num_args == MAX_ARGS) { return; }
+    if (!value) { value = "(null)"; }
+    kinds[num_args] = ARG_STRING;
+    values[num_args++].text_offset = text_len;
+
+    // Copy as much as fits; text_len never passes the last byte, so every string stays terminated
+    size_t room = TEXT_LEN - text_len;
+    size_t len = strnlen(value, room - 1);
+    memcpy(text + text_len, value, len);
+    text[text_len + len] = '\0';
+    size_t next = text_len + len + 1;
+    text_len = static_cast<uint8_t>(next < TEXT_LEN ? next : TEXT_LEN - 1);
+  }
+
+  size_t LogRecord::format_to(char *buf, size_t buf_len) const
+  {
+    size_t out = 0;
+    size_t arg = 0;
+    const char *f = format;
+
+    while (*f && out + 1 < buf_len)
+    {
+      if (*f != '%')
+      {
+        buf[out++] = *f++;
+        continue;
+      }
+      if (f[1] == '%')
+      {
+        buf[out++] = '%';
+        f += 2;
+        continue;
+      }
+
+      // Keep flags, width and precision; length modifiers are replaced to match the stored value
+      char spec[32];
+      size_t n = 0;
+      spec[n++] = *f++;
+      while (*f && strchr("-+ #0123456789.", *f) && n < 24) { spec[n++] = *f++; }
+      while (*f && strchr("hlLqjzt", *f)) { ++f; }
+      char conv = *f;
+      if (!conv) { break; }
+      ++f;
+      if (arg >= num_args) { continue; }
+
+      uint8_t kind = kinds[arg];
+      const Value &value = values[arg++];
+      long long as_int = kind == ARG_DOUBLE ? static_cast<long long>(value.d) :
+                         kind == ARG_UINT ? static_cast<long long>(value.u) : value.i;
+      double as_double = kind == ARG_DOUBLE ? value.d :
+                         kind == ARG_UINT ? static_cast<double>(value.u) : static_cast<double>(value.i);
+
+      int written = 0;
+      switch (conv)
+      {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+          spec[n++] = 'l';
+          spec[n++] = 'l';
+          spec[n++] = conv;
+          spec[n] = '\0';
+          written = snprintf(buf + out, buf_len - out, spec, as_int);
+          break;
+        case 'c':
+          spec[n++] = conv;
+          spec[n] = '\0';
+          written = snprintf(buf + out, buf_len - out, spec, static_cast<int>(as_int));
+          break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+          spec[n++] = conv;
+          spec[n] = '\0';
+          written = snprintf(buf + out, buf_len - out, spec, as_double);
+          break;
+        case 's':
+          spec[n++] = 's';
+          spec[n] = '\0';
+          written = snprintf(buf + out, buf_len - out, spec,
+                             kind == ARG_STRING ? text + value.text_offset : "?");
+          break;
+        default:
+          spec[n++] = 'p';
+          spec[n] = '\0';
+          written = snprintf(buf + out, buf_len - out, spec, kind == ARG_POINTER ? value.p : NULL);
+          break;
+      }
+      if (written > 0)
+      {
+        out += static_cast<size_t>(written);
+        if (out >= buf_len) { out = buf_len - 1; }
+      }
+    }
+
+    buf[out] = '\0';
+    return out;
+  }
 
   void loggerTermHandler(int signum)
   {
@@ -82,13 +194,17 @@ namespace clearpath
   Logger::Logger() :
       enabled(true),
       level(WARNING),
-      stream(&cerr)
+      stream(&cerr),
+      dropped(0),
+      async_running(false),
+      sink(NULL)
   {
     nullStream = new ofstream("/dev/null");
   }
 
   Logger::~Logger()
   {
+    setAsync(false);
     close();
   }
 
@@ -124,6 +240,97 @@ namespace clearpath
     return *stream;
   }
 
+  void Logger::submit(const LogRecord &record)
+  {
+    if (!async_running.load(std::memory_order_acquire))
+    {
+      deliver(record);
+    }
+    else if (!ring.push(record))
+    {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void Logger::deliver(const LogRecord &record)
+  {
+    char text[512];
+    size_t len = record.format_to(text, sizeof(text));
+    if (record.suppressed)
+    {
+      snprintf(text + len, sizeof(text) - len, " (%u similar messages suppressed)", record.suppressed);
+    }
+
+    enum logLevels msg_level = static_cast<enum logLevels>(record.level);
+    if (sink)
+    {
+      sink(msg_level, record.file, record.line, text);
+    }
+    else
+    {
+      entry(msg_level, record.file, record.line) << text << endl;
+    }
+  }
+
+  void Logger::drain()
+  {
+    LogRecord record;
+    while (ring.pop(record))
+    {
+      deliver(record);
+    }
+
+    static unsigned long reported = 0;
+    unsigned long now_dropped = dropped.load(std::memory_order_relaxed);
+    if (now_dropped != reported)
+    {
+      LogRecord note;
+      note.format = "%lu log messages dropped, ring full";
+      note.file = __FILE__;
+      note.line = __LINE__;
+      note.level = WARNING;
+      note.num_args = 0;
+      note.text_len = 0;
+      note.suppressed = 0;
+      note.add(now_dropped - reported);
+      reported = now_dropped;
+      deliver(note);
+    }
+  }
+
+  void Logger::drainThreadMain()
+  {
+    while (async_running.load(std::memory_order_acquire))
+    {
+      drain();
+      std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_PERIOD_MS));
+    }
+  }
+
+/**
+* Switch log() between writing on the calling thread and handing records to
+* a background drain thread. Switching off flushes whatever is still queued.
+*/
+  void Logger::setAsync(bool async)
+  {
+    if (async && !async_running)
+    {
+      async_running = true;
+      drain_thread = std::thread(&Logger::drainThreadMain, this);
+    }
+    else if (!async && async_running)
+    {
+      async_running = false;
+      drain_thread.join();
+      drain();
+    }
+  }
+
+  void Logger::setSink(Sink new_sink)
+  {
+    sink = new_sink;
+  }
+
   void Logger::setEnabled(bool en)
   {
     enabled = en;
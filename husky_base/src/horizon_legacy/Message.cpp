@@ -50,6 +50,7 @@
 #include "husky_base/horizon_legacy/crc.h"
 #include "husky_base/horizon_legacy/Message.h"
 #include "husky_base/horizon_legacy/Message_data.h"
+#include "husky_base/horizon_legacy/MessageRegistry.h"
 #include "husky_base/horizon_legacy/Number.h"
 #include "husky_base/horizon_legacy/Transport.h"
 
@@ -71,32 +72,57 @@ namespace clearpath
 #endif
   }
 
+  const char *transferResultString(enum transferResult result)
+  {
+    switch (result)
+    {
+      case TRANSFER_OK:
+        return "OK";
+      case TRANSFER_NOT_CONFIGURED:
+        return "Transport not configured";
+      case TRANSFER_UNACKNOWLEDGED:
+        return "Unacknowledged send";
+      case TRANSFER_BAD_ACK:
+        return "Bad acknowledgment";
+      case TRANSFER_TIMED_OUT:
+        return "Timed out";
+      case TRANSFER_TOO_LONG:
+        return "Batch too long";
+    }
+    return "Unknown";
+  }
+
   Message::Message() :
-      is_sent(false)
+      is_sent(false),
+      crc_state(CRC_UNCHECKED)
   {
     total_len = HEADER_LENGTH + CRC_LENGTH;
     memset(data, 0, MAX_MSG_LENGTH);
   }
 
   Message::Message(void *input, size_t msg_len) :
-      is_sent(false)
+      is_sent(false),
+      crc_state(CRC_UNCHECKED)
   {
     total_len = msg_len;
-    memset(data, 0, MAX_MSG_LENGTH);
     memcpy(data, input, msg_len);
+    memset(data + msg_len, 0, MAX_MSG_LENGTH - msg_len);
   }
 
   Message::Message(const Message &other) :
-      is_sent(false)
+      is_sent(false),
+      rx_time(other.rx_time),
+      crc_state(other.crc_state)
   {
     total_len = other.total_len;
-    memset(data, 0, MAX_MSG_LENGTH);
     memcpy(data, other.data, total_len);
+    memset(data + total_len, 0, MAX_MSG_LENGTH - total_len);
   }
 
   Message::Message(uint16_t type, uint8_t *payload, size_t payload_len,
       uint32_t timestamp, uint8_t flags, uint8_t version) :
-      is_sent(false)
+      is_sent(false),
+      crc_state(CRC_UNCHECKED)
   {
     /* Copy in data */
     total_len = HEADER_LENGTH + payload_len + CRC_LENGTH;
@@ -122,6 +148,7 @@ namespace clearpath
     /* Generate checksum */
     uint16_t checksum = crc16(crcOffset(), CRC_INIT_VAL, data);
     utob(data + crcOffset(), 2, checksum);
+    crc_state = CRC_GOOD;
   }
 
   Message::~Message()
@@ -131,31 +158,60 @@ namespace clearpath
 
   void Message::send()
   {
-    // We will retry up to 3 times if we receive CRC errors
-    for (int i = 0; i < 2; ++i)
+    send(Transport::instance());
+  }
+
+  void Message::send(Transport &transport)
+  {
+    uint16_t ack_code = 0;
+    enum transferResult result = trySend(transport, &ack_code);
+    if (result != TRANSFER_OK)
     {
-      try
-      {
-        Transport::instance().send(this);
-        return;
-      }
-      catch (BadAckException *ex)
-      {
-        // Any bad ack other than bad checksum needs to
-        // be thrown on
-        if (ex->ack_flag != BadAckException::BAD_CHECKSUM)
-        {
-          throw ex;
-        }
-      }
+      Transport::throwResult(result, ack_code);
     }
+  }
 
-    /* Make the final attempt outside the try, so any exception
-     * just goes straight through */
+  enum transferResult Message::trySend(uint16_t *ack_code)
+  {
+    return trySend(Transport::instance(), ack_code);
+  }
+
+/**
+* Send, waiting for the ack, without throwing or allocating.
+* Resent up to twice more if the firmware reports a bad checksum.
+* @param ack_code  If not null, set to the ack's result code on TRANSFER_BAD_ACK
+*/
+  enum transferResult Message::trySend(Transport &transport, uint16_t *ack_code)
+  {
+    uint16_t code = 0;
+    enum transferResult result = TRANSFER_OK;
+    for (int i = 0; i < 3; ++i)
+    {
+      result = transport.trySend(this, &code);
+      // Any bad ack other than bad checksum is final
+      if (result != TRANSFER_BAD_ACK || code != BadAckException::BAD_CHECKSUM)
+      {
+        break;
+      }
 #ifdef LOGGING_AVAIL
-    CPR_WARN() << "Bad checksum twice in a row." << endl;
+      if (i == 1) { CPR_WARN() << "Bad checksum twice in a row." << endl; }
 #endif
-    Transport::instance().send(this);
+    }
+    if (ack_code) { *ack_code = code; }
+    return result;
+  }
+
+  unsigned long Message::sendAsync(bool supersede)
+  {
+    return sendAsync(Transport::instance(), supersede);
+  }
+
+/**
+* Send without waiting for the ack; see Transport::sendAsync().
+*/
+  unsigned long Message::sendAsync(Transport &transport, bool supersede)
+  {
+    return transport.sendAsync(this, supersede);
   }
 
 /**
@@ -220,6 +276,7 @@ namespace clearpath
 
   void Message::setLength(uint8_t len)
   {
+    crc_state = CRC_UNCHECKED;
     size_t new_total_len = len + 3;
     if (new_total_len > MAX_MSG_LENGTH) { return; }
     total_len = new_total_len;
@@ -229,21 +286,25 @@ namespace clearpath
 
   void Message::setVersion(uint8_t version)
   {
+    crc_state = CRC_UNCHECKED;
     data[VERSION_OFST] = version;
   }
 
   void Message::setTimestamp(uint32_t timestamp)
   {
+    crc_state = CRC_UNCHECKED;
     utob(data + TIMESTAMP_OFST, 4, timestamp);
   }
 
   void Message::setFlags(uint8_t flags)
   {
+    crc_state = CRC_UNCHECKED;
     data[FLAGS_OFST] = flags;
   }
 
   void Message::setType(uint16_t type)
   {
+    crc_state = CRC_UNCHECKED;
     utob(data + TYPE_OFST, 2, type);
   }
 
@@ -255,6 +316,7 @@ namespace clearpath
 */
   void Message::setPayloadLength(uint8_t len)
   {
+    crc_state = CRC_UNCHECKED;
 
     if (((size_t) (len) + HEADER_LENGTH + CRC_LENGTH) > MAX_MSG_LENGTH) { return; }
     total_len = len + HEADER_LENGTH + CRC_LENGTH;
@@ -269,6 +331,7 @@ namespace clearpath
 */
   void Message::setPayload(void *buf, size_t buf_size)
   {
+    crc_state = CRC_UNCHECKED;
     if ((buf_size + HEADER_LENGTH + CRC_LENGTH) > MAX_MSG_LENGTH) { return; }
     setPayloadLength(buf_size);
     if (buf_size > getPayloadLength()) { return; }
@@ -325,8 +388,12 @@ namespace clearpath
       if (whyNot) { strncpy(whyNot, "Length is wrong.", strLen); }
       return false;
     }
-    // Check the CRC
-    if (crc16(crcOffset(), CRC_INIT_VAL, this->data) != getChecksum())
+    // Check the CRC, unless this exact frame has been checked before
+    if (crc_state == CRC_UNCHECKED)
+    {
+      crc_state = (crc16(crcOffset(), CRC_INIT_VAL, this->data) == getChecksum()) ? CRC_GOOD : CRC_BAD;
+    }
+    if (crc_state != CRC_GOOD)
     {
       if (whyNot) { strncpy(whyNot, "CRC is wrong.", strLen); }
       return false;
@@ -345,6 +412,7 @@ namespace clearpath
     data[LENGTH_COMP_OFST] = ~data[LENGTH_OFST];
     uint16_t checksum = crc16(crcOffset(), CRC_INIT_VAL, data);
     utob(data + crcOffset(), 2, checksum);
+    crc_state = CRC_GOOD;
   }
 
   std::ostream &Message::printMessage(std::ostream &stream)
@@ -386,101 +454,21 @@ namespace clearpath
   {
     uint16_t type = btou((char *) input + TYPE_OFST, 2);
 
-    switch (type)
-    {
-      case DATA_ACCEL:
-        return new DataPlatformAcceleration(input, msg_len);
-
-      case DATA_ACCEL_RAW:
-        return new DataRawAcceleration(input, msg_len);
-
-      case DATA_ACKERMANN_SETPTS:
-        return new DataAckermannOutput(input, msg_len);
-
-      case DATA_CURRENT_RAW:
-        return new DataRawCurrent(input, msg_len);
-
-      case DATA_PLATFORM_NAME:
-        return new DataPlatformName(input, msg_len);
-
-      case DATA_DIFF_CTRL_CONSTS:
-        return new DataDifferentialControl(input, msg_len);
-
-      case DATA_DIFF_WHEEL_SPEEDS:
-        return new DataDifferentialSpeed(input, msg_len);
-
-      case DATA_DIFF_WHEEL_SETPTS:
-        return new DataDifferentialOutput(input, msg_len);
-
-      case DATA_DISTANCE_DATA:
-        return new DataRangefinders(input, msg_len);
-
-      case DATA_DISTANCE_TIMING:
-        return new DataRangefinderTimings(input, msg_len);
-
-      case DATA_ECHO:
-        return new DataEcho(input, msg_len);
-
-      case DATA_ENCODER:
-        return new DataEncoders(input, msg_len);
-
-      case DATA_ENCODER_RAW:
-        return new DataEncodersRaw(input, msg_len);
-
-      case DATA_FIRMWARE_INFO:
-        return new DataFirmwareInfo(input, msg_len);
-
-      case DATA_GYRO_RAW:
-        return new DataRawGyro(input, msg_len);
-
-      case DATA_MAGNETOMETER:
-        return new DataPlatformMagnetometer(input, msg_len);
-
-      case DATA_MAGNETOMETER_RAW:
-        return new DataRawMagnetometer(input, msg_len);
-
-      case DATA_MAX_ACCEL:
-        return new DataMaxAcceleration(input, msg_len);
-
-      case DATA_MAX_SPEED:
-        return new DataMaxSpeed(input, msg_len);
-
-      case DATA_ORIENT:
-        return new DataPlatformOrientation(input, msg_len);
-
-      case DATA_ORIENT_RAW:
-        return new DataRawOrientation(input, msg_len);
-
-      case DATA_PLATFORM_INFO:
-        return new DataPlatformInfo(input, msg_len);
-
-      case DATA_POWER_SYSTEM:
-        return new DataPowerSystem(input, msg_len);
-
-      case DATA_PROC_STATUS:
-        return new DataProcessorStatus(input, msg_len);
-
-      case DATA_ROT_RATE:
-        return new DataPlatformRotation(input, msg_len);
-
-      case DATA_SAFETY_SYSTEM:
-        return new DataSafetySystemStatus(input, msg_len);
-
-      case DATA_SYSTEM_STATUS:
-        return new DataSystemStatus(input, msg_len);
-
-      case DATA_TEMPERATURE_RAW:
-        return new DataRawTemperature(input, msg_len);
-
-      case DATA_VELOCITY_SETPT:
-        return new DataVelocity(input, msg_len);
+    Message *msg = DataMessages::make(type, input, msg_len);
+    return msg ? msg : new Message(input, msg_len);
+  } // factory()
 
-      case DATA_VOLTAGE_RAW:
-        return new DataRawVoltage(input, msg_len);
+/**
+* As factory(), but never throws: returns null if the payload length doesn't
+* match the message type instead of raising a MessageException.
+*/
+  Message *Message::factory(void *input, size_t msg_len, const std::nothrow_t &)
+  {
+    uint16_t type = btou((char *) input + TYPE_OFST, 2);
 
-      default:
-        return new Message(input, msg_len);
-    } // switch getType()
+    bool registered;
+    Message *msg = DataMessages::makeChecked(type, input, msg_len, registered);
+    return registered ? msg : new Message(input, msg_len);
   } // factory()
 
   Message *Message::popNext()
@@ -493,6 +481,16 @@ namespace clearpath
     return Transport::instance().waitNext(timeout);
   }
 
+  Message *Message::popNext(Transport &transport)
+  {
+    return transport.popNext();
+  }
+
+  Message *Message::waitNext(Transport &transport, double timeout)
+  {
+    return transport.waitNext(timeout);
+  }
+
 } // namespace clearpath
 
 std::ostream &operator<<(std::ostream &stream, clearpath::Message &msg)
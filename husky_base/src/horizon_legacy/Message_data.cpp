@@ -1,4 +1,5 @@
 #include "husky_base/horizon_legacy/Message_data.h"
+#include "husky_base/horizon_legacy/MessageRegistry.h"
 #include "husky_base/horizon_legacy/Number.h"
 #include "husky_base/horizon_legacy/Transport.h"
 
@@ -18,19 +19,25 @@ namespace clearpath
 * expected payload length of the message.  If the length reported in the message
 * header does not match, and exception will be thrown.  If ExpectedLength is -1,
 * the length check will be skipped.
+* The std::nothrow constructor skips the check; Message::factory(..., std::nothrow)
+* runs it afterwards through hasExpectedLength() instead.
 * NB: Some Messages need to do some extra work in the constructor and don't use
 *     this macro!
 */
 #define MESSAGE_CONSTRUCTORS(MessageClass, ExpectedLength) \
 MessageClass::MessageClass(void* input, size_t msg_len) : Message(input, msg_len) \
 { \
-    if( ((ExpectedLength) >= 0) && ((ssize_t)getPayloadLength() != (ExpectedLength)) ) { \
+    if( !hasExpectedLength() ) { \
         stringstream ss; \
         ss << "Bad payload length: actual="<<getPayloadLength(); \
         ss <<" vs. expected="<<(ExpectedLength); \
         throw new MessageException(ss.str().c_str(), MessageException::INVALID_LENGTH); \
     } \
 } \
+MessageClass::MessageClass(void* input, size_t msg_len, const std::nothrow_t &) : Message(input, msg_len) {} \
+bool MessageClass::hasExpectedLength() { \
+    return ((ExpectedLength) < 0) || ((ssize_t)getPayloadLength() == (ExpectedLength)); \
+} \
 MessageClass::MessageClass(const MessageClass& other) : Message(other) {}
 
 
@@ -38,33 +45,49 @@ MessageClass::MessageClass(const MessageClass& other) : Message(other) {}
 * Macro which generates definitios of the Message convenience functions
 * All message classes should use this macro to define these functions.
 */
-#define MESSAGE_CONVENIENCE_FNS(MessageClass, DataMsgID) \
+#define MESSAGE_CONVENIENCE_FNS(MessageClass) \
 MessageClass* MessageClass::popNext() { \
-    return dynamic_cast<MessageClass*>(Transport::instance().popNext(DataMsgID)); \
+    return popNext(Transport::instance()); \
+} \
+\
+MessageClass* MessageClass::popNext(Transport &transport) { \
+    return messageCast<MessageClass>(transport.popNext(MessageTraits<MessageClass>::type)); \
 } \
 \
 MessageClass* MessageClass::waitNext(double timeout) { \
-    return dynamic_cast<MessageClass*>(Transport::instance().waitNext(DataMsgID, timeout)); \
+    return waitNext(Transport::instance(), timeout); \
+} \
+\
+MessageClass* MessageClass::waitNext(Transport &transport, double timeout) { \
+    return messageCast<MessageClass>(transport.waitNext(MessageTraits<MessageClass>::type, timeout)); \
 } \
 \
 MessageClass* MessageClass::getUpdate(double timeout) { \
-    Transport::instance().flush(DataMsgID); \
-    subscribe(0); \
-    return dynamic_cast<MessageClass*>( \
-            Transport::instance().waitNext(DataMsgID, timeout) ); \
+    return getUpdate(Transport::instance(), timeout); \
+} \
+\
+MessageClass* MessageClass::getUpdate(Transport &transport, double timeout) { \
+    transport.flush(MessageTraits<MessageClass>::type); \
+    subscribe(transport, 0); \
+    return messageCast<MessageClass>( \
+            transport.waitNext(MessageTraits<MessageClass>::type, timeout) ); \
 }\
 \
 void MessageClass::subscribe(uint16_t freq) { \
-    Request(DataMsgID-0x4000, freq).send(); \
+    subscribe(Transport::instance(), freq); \
+} \
+\
+void MessageClass::subscribe(Transport &transport, uint16_t freq) { \
+    Request(MessageTraits<MessageClass>::request, freq).send(transport); \
 } \
 \
 enum MessageTypes MessageClass::getTypeID() { \
-    return DataMsgID; \
+    return MessageTraits<MessageClass>::type; \
 }
 
   MESSAGE_CONSTRUCTORS(DataAckermannOutput, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataAckermannOutput, DATA_ACKERMANN_SETPTS)
+  MESSAGE_CONVENIENCE_FNS(DataAckermannOutput)
 
   double DataAckermannOutput::getSteering()
   {
@@ -95,7 +118,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataDifferentialControl, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataDifferentialControl, DATA_DIFF_CTRL_CONSTS)
+  MESSAGE_CONVENIENCE_FNS(DataDifferentialControl)
 
   double DataDifferentialControl::getLeftP()
   {
@@ -179,7 +202,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataDifferentialOutput, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataDifferentialOutput, DATA_DIFF_WHEEL_SETPTS)
+  MESSAGE_CONVENIENCE_FNS(DataDifferentialOutput)
 
   double DataDifferentialOutput::getLeft()
   {
@@ -204,26 +227,35 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataDifferentialSpeed, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataDifferentialSpeed, DATA_DIFF_WHEEL_SPEEDS)
+  MESSAGE_CONVENIENCE_FNS(DataDifferentialSpeed)
 
   double DataDifferentialSpeed::getLeftSpeed()
   {
-    return btof(getPayloadPointer(LEFT_SPEED), 2, 100);
+    return Layout::LeftSpeed::value(getPayloadPointer());
   }
 
   double DataDifferentialSpeed::getLeftAccel()
   {
-    return btof(getPayloadPointer(LEFT_ACCEL), 2, 100);
+    return Layout::LeftAccel::value(getPayloadPointer());
   }
 
   double DataDifferentialSpeed::getRightSpeed()
   {
-    return btof(getPayloadPointer(RIGHT_SPEED), 2, 100);
+    return Layout::RightSpeed::value(getPayloadPointer());
   }
 
   double DataDifferentialSpeed::getRightAccel()
   {
-    return btof(getPayloadPointer(RIGHT_ACCEL), 2, 100);
+    return Layout::RightAccel::value(getPayloadPointer());
+  }
+
+  void DataDifferentialSpeed::decode(DifferentialSpeedSample &sample)
+  {
+    const uint8_t *payload = getPayloadPointer();
+    sample.left_speed = Layout::LeftSpeed::value(payload);
+    sample.right_speed = Layout::RightSpeed::value(payload);
+    sample.left_accel = Layout::LeftAccel::value(payload);
+    sample.right_accel = Layout::RightAccel::value(payload);
   }
 
   ostream &DataDifferentialSpeed::printMessage(ostream &stream)
@@ -240,7 +272,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataEcho, 0)
 
-  MESSAGE_CONVENIENCE_FNS(DataEcho, DATA_ECHO)
+  MESSAGE_CONVENIENCE_FNS(DataEcho)
 
   ostream &DataEcho::printMessage(ostream &stream)
   {
@@ -251,7 +283,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   DataEncoders::DataEncoders(void *input, size_t msg_len) : Message(input, msg_len)
   {
-    if ((ssize_t) getPayloadLength() != (1 + getCount() * 6))
+    if (!hasExpectedLength())
     {
       stringstream ss;
       ss << "Bad payload length: actual=" << getPayloadLength();
@@ -262,25 +294,54 @@ enum MessageTypes MessageClass::getTypeID() { \
     speeds_offset = travels_offset + (getCount() * 4);
   }
 
-  DataEncoders::DataEncoders(const DataEncoders &other) : Message(other)
+  DataEncoders::DataEncoders(void *input, size_t msg_len, const std::nothrow_t &) : Message(input, msg_len)
+  {
+    travels_offset = 1;
+    speeds_offset = travels_offset + (getCount() * 4);
+  }
+
+  bool DataEncoders::hasExpectedLength()
+  {
+    return (ssize_t) getPayloadLength() == (1 + getCount() * 6);
+  }
+
+  DataEncoders::DataEncoders(const DataEncoders &other) :
+      Message(other),
+      travels_offset(other.travels_offset),
+      speeds_offset(other.speeds_offset)
   {
   }
 
-  MESSAGE_CONVENIENCE_FNS(DataEncoders, DATA_ENCODER)
+  MESSAGE_CONVENIENCE_FNS(DataEncoders)
 
   uint8_t DataEncoders::getCount()
   {
-    return *getPayloadPointer(0);
+    return Count::raw(getPayloadPointer());
   }
 
   double DataEncoders::getTravel(uint8_t index)
   {
-    return btof(getPayloadPointer(travels_offset + index * 4), 4, 1000);
+    return loadScaled<int32_t, TRAVEL_SCALE>(getPayloadPointer(travels_offset), index);
   }
 
   double DataEncoders::getSpeed(uint8_t index)
   {
-    return btof(getPayloadPointer(speeds_offset + index * 2), 2, 1000);
+    return loadScaled<int16_t, SPEED_SCALE>(getPayloadPointer(speeds_offset), index);
+  }
+
+  void DataEncoders::decode(EncoderSample &sample)
+  {
+    const uint8_t *travels = getPayloadPointer(travels_offset);
+    const uint8_t *speeds = getPayloadPointer(speeds_offset);
+    sample.count = getCount();
+    if (sample.count > EncoderSample::MAX_ENCODERS) { sample.count = EncoderSample::MAX_ENCODERS; }
+
+    for (size_t i = 0; i < EncoderSample::MAX_ENCODERS; ++i)
+    {
+      bool present = i < sample.count;
+      sample.travel[i] = present ? loadScaled<int32_t, TRAVEL_SCALE>(travels, i) : 0.0;
+      sample.speed[i] = present ? loadScaled<int16_t, SPEED_SCALE>(speeds, i) : 0.0;
+    }
   }
 
   ostream &DataEncoders::printMessage(ostream &stream)
@@ -301,7 +362,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataEncodersRaw, (1 + getCount() * 4))
 
-  MESSAGE_CONVENIENCE_FNS(DataEncodersRaw, DATA_ENCODER_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataEncodersRaw)
 
   uint8_t DataEncodersRaw::getCount()
   {
@@ -328,7 +389,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataFirmwareInfo, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataFirmwareInfo, DATA_FIRMWARE_INFO)
+  MESSAGE_CONVENIENCE_FNS(DataFirmwareInfo)
 
   uint8_t DataFirmwareInfo::getMajorFirmwareVersion()
   {
@@ -374,7 +435,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataGear, 1)
 
-  MESSAGE_CONVENIENCE_FNS(DataGear, DATA_GEAR_SETPT)
+  MESSAGE_CONVENIENCE_FNS(DataGear)
 
   uint8_t DataGear::getGear()
   {
@@ -393,7 +454,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataMaxAcceleration, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataMaxAcceleration, DATA_MAX_ACCEL)
+  MESSAGE_CONVENIENCE_FNS(DataMaxAcceleration)
 
   double DataMaxAcceleration::getForwardMax()
   {
@@ -418,7 +479,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataMaxSpeed, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataMaxSpeed, DATA_MAX_SPEED)
+  MESSAGE_CONVENIENCE_FNS(DataMaxSpeed)
 
   double DataMaxSpeed::getForwardMax()
   {
@@ -443,7 +504,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataPlatformAcceleration, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataPlatformAcceleration, DATA_ACCEL)
+  MESSAGE_CONVENIENCE_FNS(DataPlatformAcceleration)
 
   double DataPlatformAcceleration::getX()
   {
@@ -474,7 +535,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataPlatformInfo, (int) strlenModel() + 6)
 
-  MESSAGE_CONVENIENCE_FNS(DataPlatformInfo, DATA_PLATFORM_INFO)
+  MESSAGE_CONVENIENCE_FNS(DataPlatformInfo)
 
   uint8_t DataPlatformInfo::strlenModel()
   {
@@ -518,7 +579,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataPlatformName, (int) (*getPayloadPointer()) + 1)
 
-  MESSAGE_CONVENIENCE_FNS(DataPlatformName, DATA_PLATFORM_NAME)
+  MESSAGE_CONVENIENCE_FNS(DataPlatformName)
 
   string DataPlatformName::getName()
   {
@@ -541,7 +602,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataPlatformMagnetometer, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataPlatformMagnetometer, DATA_MAGNETOMETER)
+  MESSAGE_CONVENIENCE_FNS(DataPlatformMagnetometer)
 
   double DataPlatformMagnetometer::getX()
   {
@@ -572,7 +633,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataPlatformOrientation, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataPlatformOrientation, DATA_ORIENT)
+  MESSAGE_CONVENIENCE_FNS(DataPlatformOrientation)
 
   double DataPlatformOrientation::getRoll()
   {
@@ -604,7 +665,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataPlatformRotation, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataPlatformRotation, DATA_ROT_RATE)
+  MESSAGE_CONVENIENCE_FNS(DataPlatformRotation)
 
   double DataPlatformRotation::getRollRate()
   {
@@ -635,7 +696,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataPowerSystem, 1 + getBatteryCount() * 5)
 
-  MESSAGE_CONVENIENCE_FNS(DataPowerSystem, DATA_POWER_SYSTEM)
+  MESSAGE_CONVENIENCE_FNS(DataPowerSystem)
 
   uint8_t DataPowerSystem::getBatteryCount()
   {
@@ -665,6 +726,24 @@ enum MessageTypes MessageClass::getTypeID() { \
     return BatteryDescription(*getPayloadPointer(offset));
   }
 
+  void DataPowerSystem::decode(PowerSystemSample &sample)
+  {
+    const uint8_t *payload = getPayloadPointer();
+    size_t count = getBatteryCount();
+    const uint8_t *charges = payload + 1;
+    const uint8_t *capacities = charges + 2 * count;
+    const uint8_t *descriptions = capacities + 2 * count;
+
+    sample.battery_count = (count > PowerSystemSample::MAX_BATTERIES) ? PowerSystemSample::MAX_BATTERIES : count;
+    for (size_t i = 0; i < PowerSystemSample::MAX_BATTERIES; ++i)
+    {
+      bool present = i < sample.battery_count;
+      sample.charge_estimate[i] = present ? loadScaled<int16_t, 100>(charges, i) : 0.0;
+      sample.capacity_estimate[i] = present ? loadLE<int16_t>(capacities + 2 * i) : 0;
+      sample.description[i] = present ? descriptions[i] : 0;
+    }
+  }
+
   ostream &DataPowerSystem::printMessage(ostream &stream)
   {
     stream << "Power System Status Data" << endl;
@@ -706,7 +785,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataProcessorStatus, (1 + getProcessCount() * 2))
 
-  MESSAGE_CONVENIENCE_FNS(DataProcessorStatus, DATA_PROC_STATUS)
+  MESSAGE_CONVENIENCE_FNS(DataProcessorStatus)
 
   uint8_t DataProcessorStatus::getProcessCount()
   {
@@ -734,7 +813,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRangefinders, (1 + getRangefinderCount() * 2))
 
-  MESSAGE_CONVENIENCE_FNS(DataRangefinders, DATA_DISTANCE_DATA)
+  MESSAGE_CONVENIENCE_FNS(DataRangefinders)
 
   uint8_t DataRangefinders::getRangefinderCount()
   {
@@ -762,7 +841,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRangefinderTimings, (1 + getRangefinderCount() * 6))
 
-  MESSAGE_CONVENIENCE_FNS(DataRangefinderTimings, DATA_DISTANCE_TIMING)
+  MESSAGE_CONVENIENCE_FNS(DataRangefinderTimings)
 
   uint8_t DataRangefinderTimings::getRangefinderCount()
   {
@@ -797,7 +876,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRawAcceleration, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataRawAcceleration, DATA_ACCEL_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataRawAcceleration)
 
   uint16_t DataRawAcceleration::getX()
   {
@@ -828,7 +907,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRawCurrent, (1 + getCurrentCount() * 2))
 
-  MESSAGE_CONVENIENCE_FNS(DataRawCurrent, DATA_CURRENT_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataRawCurrent)
 
   uint8_t DataRawCurrent::getCurrentCount()
   {
@@ -857,7 +936,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRawGyro, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataRawGyro, DATA_GYRO_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataRawGyro)
 
   uint16_t DataRawGyro::getRoll()
   {
@@ -888,7 +967,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRawMagnetometer, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataRawMagnetometer, DATA_MAGNETOMETER_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataRawMagnetometer)
 
   uint16_t DataRawMagnetometer::getX()
   {
@@ -919,7 +998,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRawOrientation, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataRawOrientation, DATA_ORIENT_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataRawOrientation)
 
   uint16_t DataRawOrientation::getRoll()
   {
@@ -950,7 +1029,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRawTemperature, (1 + 2 * getTemperatureCount()))
 
-  MESSAGE_CONVENIENCE_FNS(DataRawTemperature, DATA_TEMPERATURE_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataRawTemperature)
 
   uint8_t DataRawTemperature::getTemperatureCount()
   {
@@ -980,7 +1059,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataRawVoltage, (1 + 2 * getVoltageCount()))
 
-  MESSAGE_CONVENIENCE_FNS(DataRawVoltage, DATA_VOLTAGE_RAW)
+  MESSAGE_CONVENIENCE_FNS(DataRawVoltage)
 
   uint8_t DataRawVoltage::getVoltageCount()
   {
@@ -1010,11 +1089,11 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataSafetySystemStatus, 2)
 
-  MESSAGE_CONVENIENCE_FNS(DataSafetySystemStatus, DATA_SAFETY_SYSTEM)
+  MESSAGE_CONVENIENCE_FNS(DataSafetySystemStatus)
 
   uint16_t DataSafetySystemStatus::getFlags()
   {
-    return btou(getPayloadPointer(), 2);
+    return Flags::raw(getPayloadPointer());
   }
 
   ostream &DataSafetySystemStatus::printMessage(ostream &stream)
@@ -1032,25 +1111,42 @@ enum MessageTypes MessageClass::getTypeID() { \
     currents_offset = voltages_offset + 1 + getVoltagesCount() * 2;
     temperatures_offset = currents_offset + 1 + getCurrentsCount() * 2;
 
-    size_t expect_len = (7 + 2 * getVoltagesCount() + 2 * getCurrentsCount() + 2 * getTemperaturesCount());
-    if (getPayloadLength() != expect_len)
+    if (!hasExpectedLength())
     {
       stringstream ss;
       ss << "Bad payload length: actual=" << getPayloadLength();
-      ss << " vs. expected=" << expect_len;
+      ss << " vs. expected=" << (7 + 2 * getVoltagesCount() + 2 * getCurrentsCount() + 2 * getTemperaturesCount());
       throw new MessageException(ss.str().c_str(), MessageException::INVALID_LENGTH);
     }
   }
 
-  DataSystemStatus::DataSystemStatus(const DataSystemStatus &other) : Message(other)
+  DataSystemStatus::DataSystemStatus(void *input, size_t msg_len, const std::nothrow_t &) : Message(input, msg_len)
+  {
+    voltages_offset = 4;
+    currents_offset = voltages_offset + 1 + getVoltagesCount() * 2;
+    temperatures_offset = currents_offset + 1 + getCurrentsCount() * 2;
+  }
+
+  bool DataSystemStatus::hasExpectedLength()
   {
+    // Needs the offsets, so only valid once constructed
+    size_t expect_len = (7 + 2 * getVoltagesCount() + 2 * getCurrentsCount() + 2 * getTemperaturesCount());
+    return getPayloadLength() == expect_len;
   }
 
-  MESSAGE_CONVENIENCE_FNS(DataSystemStatus, DATA_SYSTEM_STATUS)
+  DataSystemStatus::DataSystemStatus(const DataSystemStatus &other) :
+      Message(other),
+      voltages_offset(other.voltages_offset),
+      currents_offset(other.currents_offset),
+      temperatures_offset(other.temperatures_offset)
+  {
+  }
+
+  MESSAGE_CONVENIENCE_FNS(DataSystemStatus)
 
   uint32_t DataSystemStatus::getUptime()
   {
-    return btou(getPayloadPointer(0), 4);
+    return loadLE<uint32_t>(getPayloadPointer(0));
   }
 
   uint8_t DataSystemStatus::getVoltagesCount()
@@ -1060,7 +1156,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   double DataSystemStatus::getVoltage(uint8_t index)
   {
-    return btof(getPayloadPointer(voltages_offset + 1 + (index * 2)), 2, 100);
+    return loadScaled<int16_t, 100>(getPayloadPointer(voltages_offset + 1), index);
   }
 
   uint8_t DataSystemStatus::getCurrentsCount()
@@ -1070,7 +1166,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   double DataSystemStatus::getCurrent(uint8_t index)
   {
-    return btof(getPayloadPointer(currents_offset + 1 + (index * 2)), 2, 100);
+    return loadScaled<int16_t, 100>(getPayloadPointer(currents_offset + 1), index);
   }
 
   uint8_t DataSystemStatus::getTemperaturesCount()
@@ -1080,7 +1176,30 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   double DataSystemStatus::getTemperature(uint8_t index)
   {
-    return btof(getPayloadPointer(temperatures_offset + 1 + (index * 2)), 2, 100);
+    return loadScaled<int16_t, 100>(getPayloadPointer(temperatures_offset + 1), index);
+  }
+
+  /* Decodes one count-prefixed block of int16 fixed-point channels */
+  static size_t decodeChannels(const uint8_t *block, double *out, size_t max_count)
+  {
+    size_t count = block[0];
+    if (count > max_count) { count = max_count; }
+    for (size_t i = 0; i < max_count; ++i)
+    {
+      out[i] = (i < count) ? loadScaled<int16_t, 100>(block + 1, i) : 0.0;
+    }
+    return count;
+  }
+
+  void DataSystemStatus::decode(SystemStatusSample &sample)
+  {
+    sample.uptime = getUptime();
+    sample.voltages_count = decodeChannels(
+        getPayloadPointer(voltages_offset), sample.voltage, SystemStatusSample::MAX_CHANNELS);
+    sample.currents_count = decodeChannels(
+        getPayloadPointer(currents_offset), sample.current, SystemStatusSample::MAX_CHANNELS);
+    sample.temperatures_count = decodeChannels(
+        getPayloadPointer(temperatures_offset), sample.temperature, SystemStatusSample::MAX_CHANNELS);
   }
 
   ostream &DataSystemStatus::printMessage(ostream &stream)
@@ -1119,7 +1238,7 @@ enum MessageTypes MessageClass::getTypeID() { \
 
   MESSAGE_CONSTRUCTORS(DataVelocity, PAYLOAD_LEN)
 
-  MESSAGE_CONVENIENCE_FNS(DataVelocity, DATA_VELOCITY_SETPT)
+  MESSAGE_CONVENIENCE_FNS(DataVelocity)
 
   double DataVelocity::getTranslational()
   {
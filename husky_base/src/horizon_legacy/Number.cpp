@@ -118,50 +118,4 @@ namespace clearpath
     itob(dest, dest_len, (int64_t) src);
   }
 
-  uint64_t btou(void *src, size_t src_len)
-  {
-    uint64_t retval = 0;
-
-    if (!src_len) { return 0; }
-    size_t i = src_len - 1;
-    do
-    {
-      retval = retval << 8;
-      retval |= ((uint8_t *) src)[i];
-    } while (i--);
-
-    return retval;
-  }
-
-  int64_t btoi(void *src, size_t src_len)
-  {
-    int64_t retval = 0;
-    size_t i = sizeof(int64_t);
-
-    if (!src_len) { return 0; }
-
-    /* If array is shorter than int, need to propagate sign bit */
-    for (; i >= src_len; --i)
-    {
-      retval = retval << 8;
-      if (((uint8_t *) src)[src_len - 1] & 0x80)
-      {  // MSB is set, int is negative
-        retval |= 0xff;
-      }
-    }
-    do
-    {
-      retval = retval << 8;
-      retval |= ((uint8_t *) src)[i];
-    } while (i--);
-
-    return retval;
-  }
-
-  double btof(void *src, size_t src_len, double scale)
-  {
-    double retval = btoi(src, src_len);
-    return retval /= scale;
-  }
-
 } // namespace clearpath
@@ -0,0 +1,137 @@
+/**
+Software License Agreement (BSD)
+
+\file      RttEstimator.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "husky_base/horizon_legacy/RttEstimator.h"
+
+namespace
+{
+  // What the Transport waited for an ack before the timeout adapted
+  const double FIXED_TIMEOUT = 0.2;
+  // RFC 6298 gains, and its floor under the deviation term at about the clock granularity
+  const double SRTT_GAIN = 1.0 / 8;
+  const double RTTVAR_GAIN = 1.0 / 4;
+  const double RTTVAR_SCALE = 4.0;
+  const double GRANULARITY = 0.001;
+  // Doubling stops here; by then max_timeout has long been reached anyway
+  const int MAX_BACKOFF = 16;
+}
+
+namespace clearpath
+{
+
+  RttEstimator::RttEstimator() :
+      adaptive(false),
+      min_timeout(FIXED_TIMEOUT),
+      max_timeout(FIXED_TIMEOUT)
+  {
+    reset();
+  }
+
+  void RttEstimator::configure(bool adaptive, double min_timeout, double max_timeout)
+  {
+    this->adaptive = adaptive;
+    this->min_timeout = std::max(min_timeout, GRANULARITY);
+    this->max_timeout = std::max(max_timeout, this->min_timeout);
+    update();
+  }
+
+  void RttEstimator::reset()
+  {
+    srtt = rttvar = 0.0;
+    backoff = 0;
+    samples = timeouts = 0;
+    update();
+  }
+
+  void RttEstimator::addSample(Clock::duration rtt)
+  {
+    double r = std::chrono::duration<double>(rtt).count();
+    if (r < 0.0)
+    {
+      return;
+    }
+    if (samples == 0)
+    {
+      srtt = r;
+      rttvar = r / 2;
+    }
+    else
+    {
+      rttvar += RTTVAR_GAIN * (std::abs(srtt - r) - rttvar);
+      srtt += SRTT_GAIN * (r - srtt);
+    }
+    ++samples;
+    backoff = 0;
+    update();
+  }
+
+  void RttEstimator::addTimeout()
+  {
+    ++timeouts;
+    if (backoff < MAX_BACKOFF)
+    {
+      ++backoff;
+    }
+    update();
+  }
+
+  double RttEstimator::dataTimeout(double timeout) const
+  {
+    if (!adaptive || samples == 0 || timeout <= 0.0)
+    {
+      return timeout;
+    }
+    return std::min(timeout, std::chrono::duration<double>(current).count());
+  }
+
+  RttEstimator::Estimate RttEstimator::estimate() const
+  {
+    std::lock_guard<std::mutex> lock(published_mutex);
+    return published;
+  }
+
+  void RttEstimator::update()
+  {
+    double t = FIXED_TIMEOUT;
+    if (adaptive)
+    {
+      t = samples ? srtt + std::max(GRANULARITY, RTTVAR_SCALE * rttvar) : max_timeout;
+      t = std::min(std::max(t, min_timeout) * std::ldexp(1.0, backoff), max_timeout);
+    }
+    current = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(t));
+
+    std::lock_guard<std::mutex> lock(published_mutex);
+    published.adaptive = adaptive;
+    published.srtt = srtt;
+    published.rttvar = rttvar;
+    published.timeout = t;
+    published.samples = samples;
+    published.timeouts = timeouts;
+  }
+
+} // namespace clearpath
@@ -44,8 +44,13 @@
 *
 */
 
+#include <poll.h>
+#include <pthread.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
@@ -56,6 +61,7 @@
 #include "husky_base/horizon_legacy/Transport.h"
 #include "husky_base/horizon_legacy/Number.h"
 #include "husky_base/horizon_legacy/Message.h"
+#include "husky_base/horizon_legacy/MessageRegistry.h"
 #include "husky_base/horizon_legacy/Message_request.h"
 #include "husky_base/horizon_legacy/Message_cmd.h"
 #include "husky_base/horizon_legacy/serial.h"
@@ -70,7 +76,14 @@ namespace clearpath
       "Garbled bytes",
       "Invalid messages",
       "Ignored acknowledgment",
-      "Message queue overflow"
+      "Message queue overflow",
+      "Retransmitted messages",
+      "Unacknowledged async sends",
+      "Bytes received",
+      "Frames received",
+      "Bytes sent",
+      "Frames sent",
+      "Serial port errors"
   };
 
   TransportException::TransportException(const char *msg, enum errors ex_type)
@@ -115,6 +128,47 @@ namespace clearpath
     CPR_EXCEPT() << "BadAckException (0x" << hex << flag << dec << "): " << message << endl << flush;
   }
 
+/**
+* Raise the exception the throwing API uses for a try*() result.
+* Does nothing for TRANSFER_OK and TRANSFER_TIMED_OUT, which aren't errors there.
+*/
+  void Transport::throwResult(enum transferResult result, uint16_t ack_code)
+  {
+    switch (result)
+    {
+      case TRANSFER_OK:
+      case TRANSFER_TIMED_OUT:
+        return;
+      case TRANSFER_NOT_CONFIGURED:
+        throw new TransportException("Transport not configured", TransportException::NOT_CONFIGURED);
+      case TRANSFER_UNACKNOWLEDGED:
+        throw new TransportException("Unacknowledged send", TransportException::UNACKNOWLEDGED_SEND);
+      case TRANSFER_BAD_ACK:
+        throw new BadAckException(ack_code);
+      case TRANSFER_TOO_LONG:
+        throw new TransportException("Batch too long", TransportException::ERROR_BASE);
+    }
+  }
+
+/**
+* Convert a relative timeout in seconds (0.0 meaning none) into a deadline
+* for waitForInput().
+*/
+  static std::chrono::steady_clock::time_point waitDeadline(double timeout)
+  {
+    if (timeout == 0.0)
+    {
+      return std::chrono::steady_clock::time_point::max();
+    }
+    if (timeout < 0.0)
+    {
+      timeout = 0.0;
+    }
+    return std::chrono::steady_clock::now() +
+           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+               std::chrono::duration<double>(timeout));
+  }
+
 #define CHECK_THROW_CONFIGURED() \
     do { \
         if( ! configured ) { \
@@ -123,8 +177,8 @@ namespace clearpath
     } while( 0 )
 
 /**
-* Transport singleton instance accessor.
-* @return  The Transport singleton instance.
+* Default Transport instance accessor.
+* @return  The process-wide Transport, for code which doesn't manage its own.
 */
   Transport &Transport::instance()
   {
@@ -138,17 +192,62 @@ namespace clearpath
   Transport::Transport() :
       configured(false),
       serial(0),
-      retries(0)
+      retries(0),
+      rx_queued(0),
+      rx_seq(0),
+      capture(NULL),
+      rx_thread_running(false),
+      rx_thread_enabled(false),
+      rx_cpu(-1),
+      rx_wakeup(RX_WAKE_POLL),
+      rx_event_fd(-1),
+      port_failed(false),
+      num_pending(0),
+      next_ticket(1),
+      next_async_stamp(0)
   {
     for (int i = 0; i < NUM_COUNTERS; ++i)
     {
       counters[i] = 0;
     }
+    DefaultSerialProfile(&serial_profile);
+    serial_effective = serial_profile;
+    for (size_t i = 0; i < MAX_PENDING_SENDS; ++i)
+    {
+      pending[i].ticket = 0;
+      pending[i].status = SEND_UNKNOWN;
+    }
+    for (size_t i = 0; i < TYPE_SLOTS; ++i)
+    {
+      rx_queues[i].in_use = false;
+      rx_queues[i].type = 0;
+      rx_queues[i].depth = 1;
+      rx_queues[i].head = 0;
+      rx_queues[i].count = 0;
+      rx_queues[i].entries.resize(1);
+      rx_queues[i].frames_tail = 0;
+    }
   }
 
   Transport::~Transport()
   {
     close();
+    delete capture.load();
+  }
+
+  void *Transport::operator new(size_t size)
+  {
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, alignof(Transport), size) != 0)
+    {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+  void Transport::operator delete(void *ptr)
+  {
+    free(ptr);
   }
 
 /**
@@ -156,6 +255,8 @@ namespace clearpath
 * If this Transport is already configured, it will be closed and reconfigured.
 * The RX buffer and Message queue will be flushed.
 * Counters will be reset.
+* If enableRxThread(true) was called, a background thread is started which
+* takes over all reads from the device.
 * @param device    The device to communicate over.  (Currently, must be serial)
 * @param retries   Number of times to resend an unacknowledged message.
 * @throws TransportException if configuration fails
@@ -173,10 +274,20 @@ namespace clearpath
     resetCounters();
 
     this->retries = retries;
+    port_failed = false;
 
     if (!openComm(device))
     {
       configured = true;
+      rx_scanner.reset();
+      // Could be a different MCU, or the same one rebooted
+      clock_sync.reset();
+      clock_sync.setBaud(serial_effective.baud);
+      rtt_estimator.reset();
+      if (rx_thread_enabled)
+      {
+        startRxThread();
+      }
     }
     else
     {
@@ -194,16 +305,25 @@ namespace clearpath
     int retval = 0;
     if (configured)
     {
+      // The receiver must be gone before the port is, and anything it left behind is flushed below
+      stopRxThread();
       flush();
       retval = closeComm();
+
+      // Nothing more will be acked or retransmitted
+      for (size_t i = 0; i < MAX_PENDING_SENDS; ++i)
+      {
+        if (pending[i].status == SEND_PENDING) { pending[i].status = SEND_TIMED_OUT; }
+      }
+      num_pending = 0;
     }
     configured = false;
     return retval;
   }
 
 /**
-* Opens a serial port with the default configuration
-* (115200 bps, 8-N-1), using the device specified in the constructor
+* Opens a serial port with the configured SerialProfile
+* (115200 bps, 8-N-1 by default), using the device specified in the constructor
 */
   int Transport::openComm(const char *device)
   {
@@ -212,9 +332,10 @@ namespace clearpath
     {
       return -1;
     }
-    tmp = SetupSerial(this->serial);
+    tmp = SetupSerialProfile(this->serial, &serial_profile, &serial_effective);
     if (tmp < 0)
     {
+      CloseSerial(this->serial);
       return -2;
     }
     return 0;
@@ -232,79 +353,248 @@ namespace clearpath
 
 /**
 * Non-blocking message receive function.
-* !!! Absolutely not reentrant !!!
-* !!! Keeps internal static state !!!
+* Serial input is pulled in with as few read(2) calls as possible: whatever
+* the port has available goes into the staging buffer in one go, and frames
+* are located in place from there.
+* Keeps the framing state in members, so it must only ever be driven from one
+* thread at a time: the RX thread when it is running, the caller otherwise.
 * @return  A pointer to a dynamically allocated message, if one has been received
 *          this call.  Null if no complete message has been received.  Bad data
 *          are silently eaten.
 */
   Message *Transport::rxMessage()
   {
-    /* Each time this function is called, any available characters are added
-     * to the receive buffer.  A new Message is created and returned when
-     * a complete message has been received (the message may be aggregated
-     * from data received over multiple calls) */
-    static char rx_buf[Message::MAX_MSG_LENGTH];
-    static size_t rx_inx = 0;
-    static size_t msg_len = 0;
+    const uint8_t *frame = NULL;
+    size_t frame_len = 0;
 
-    if (!rx_inx) { memset(rx_buf, 0xba, Message::MAX_MSG_LENGTH); }
+    while (true)
+    {
+      /* Hand out anything already buffered before going back to the port */
+      unsigned long garbled = 0;
+      bool found = rx_scanner.nextFrame(&frame, &frame_len, &garbled);
+      if (garbled) { counters[GARBLE_BYTES] += garbled; }
+      if (found)
+      {
+        Message *msg = Message::factory(const_cast<uint8_t *>(frame), frame_len, std::nothrow);
+        if (!msg)
+        {
+          // Frame with a payload length that doesn't match its type
+          ++counters[INVALID_MSG];
+          continue;
+        }
+        ++counters[RX_FRAMES];
+        msg->rx_time = rx_stamp;
+        return msg;
+      }
 
-    /* Read in and handle characters, one at a time.
-     * (This is a simple state machine, using 'rx_inx' as state) */
-    while (ReadData(serial, rx_buf + rx_inx, 1) == 1)
+      // Port is non-blocking, so this returns immediately with whatever is available
+      size_t space = rx_scanner.prepare();
+      int bytes = ReadData(serial, reinterpret_cast<char *>(rx_scanner.writePointer()), space);
+      if (bytes <= 0)
+      {
+        // Breaking out of loop indicates end of available serial input
+        return NULL;
+      }
+      counters[RX_BYTES] += bytes;
+      // Every complete frame is handed out before reading again, so this is when each one arrived
+      rx_stamp = std::chrono::steady_clock::now();
+      if (FrameCapture *recorder = capture.load(std::memory_order_acquire))
+      {
+        recorder->record(CAPTURE_RX, rx_scanner.writePointer(), bytes);
+      }
+      rx_scanner.commit(bytes);
+    }
+  }
+
+/**
+* Fetch the next complete frame, either straight from the serial port or,
+* when the RX thread is running, from the frame ring it fills.
+* @return  A dynamically allocated message, or null if none is available.
+*/
+  Message *Transport::nextFrame()
+  {
+    if (!rx_thread_running)
+    {
+      return rxMessage();
+    }
+
+    Message *msg = NULL;
+    rx_ring.pop(msg);
+    return msg;
+  }
+
+/**
+* Body of the background receiver. Owns the serial port for reading, runs the
+* framing state machine and pushes complete frames into rx_ring.
+*/
+  void Transport::rxThreadMain()
+  {
+    if (rx_cpu >= 0)
     {
-      switch (rx_inx)
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(rx_cpu, &cpus);
+      if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
       {
+        CPR_ALOG(Logger::WARNING, "Could not pin the RX thread to CPU %d", rx_cpu);
+      }
+    }
 
-        /* Waiting for SOH */
-        case 0:
-          if ((uint8_t) (rx_buf[0]) == (uint8_t) (Message::SOH))
-          {
-            rx_inx++;
-          }
-          else { counters[GARBLE_BYTES]++; }
-          break;
+    int wait_ms = (rx_wakeup == RX_WAKE_SPIN) ? 0 : RX_THREAD_WAKEUP_MS;
+    while (rx_thread_running.load(std::memory_order_relaxed))
+    {
+      int ready = WaitForData(serial, wait_ms);
+      if (ready < 0)
+      {
+        // Port hung up (e.g. USB unplugged); back off instead of spinning on it
+        portError();
+        usleep(1000);
+        continue;
+      }
+      if (ready == 0)
+      {
+        continue;
+      }
 
-          /* Waiting for length */
-        case 1:
-          rx_inx++;
-          break;
+      bool pushed = false;
+      while (Message *msg = rxMessage())
+      {
+        if (rx_ring.push(msg))
+        {
+          pushed = true;
+        }
+        else
+        {
+          // Consumer is not keeping up, drop the newest frame
+          ++counters[QUEUE_FULL];
+          delete msg;
+        }
+      }
 
-          /* Waiting for ~length */
-        case 2:
-          rx_inx++;
-          msg_len = rx_buf[1] + 3;
+      if (pushed)
+      {
+        // One wake-up per batch is enough, waitForInput() drains the whole ring
+        uint64_t one = 1;
+        ssize_t ret = ::write(rx_event_fd, &one, sizeof(one));
+        (void) ret;
+      }
+    }
+  }
 
-          /* Check for valid length */
-          if (static_cast<unsigned char>(rx_buf[1] ^ rx_buf[2]) != 0xFF ||
-              (msg_len < Message::MIN_MSG_LENGTH))
-          {
-            counters[GARBLE_BYTES] += rx_inx;
-            rx_inx = 0;
-          }
+/**
+* Count a failed wait on the port and flag it as gone. Reporting is left to
+* whoever owns the link, which polls portFailed() and reconnects.
+*/
+  void Transport::portError()
+  {
+    ++counters[PORT_ERRORS];
+    port_failed.store(true, std::memory_order_relaxed);
+  }
 
-          break;
+  void Transport::startRxThread()
+  {
+    if (rx_thread_running)
+    {
+      return;
+    }
+    rx_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (rx_event_fd < 0)
+    {
+      // Without a wake-up channel, waiters could not tell when frames arrive
+      throw new TransportException("Failed to create RX thread eventfd", TransportException::CONFIGURE_FAIL);
+    }
+    rx_thread_running = true;
+    rx_thread = std::thread(&Transport::rxThreadMain, this);
+  }
 
-          //case 9:
-          //case 10:
-          //    cout << hex << " " << (unsigned int)(rx_buf[rx_inx]);
-          //    if(rx_inx==10) cout << endl;
+  void Transport::stopRxThread()
+  {
+    if (!rx_thread_running)
+    {
+      return;
+    }
+    rx_thread_running = false;
+    if (rx_thread.joinable())
+    {
+      rx_thread.join();
+    }
+    ::close(rx_event_fd);
+    rx_event_fd = -1;
 
-          /* Waiting for the rest of the message */
-        default:
-          rx_inx++;
-          if (rx_inx < msg_len) { break; }
-          /* Finished rxing, reset this state machine and return msg */
-          rx_inx = 0;
-          Message *msg = Message::factory(rx_buf, msg_len);
-          return msg;
+    // Now that we are the only reader again, hand anything left over to the queue
+    Message *msg = NULL;
+    while (rx_ring.pop(msg))
+    {
+      if (msg->isData())
+      {
+        enqueueMessage(msg);
+      }
+      else
+      {
+        if (!handleAsyncAck(msg)) { ++counters[IGNORED_ACK]; }
+        delete msg;
+      }
+    }
+  }
 
-      } // switch( rx_inx )
-    } // while( get character )
+/**
+* Block until new input may be available or the deadline passes, whichever
+* comes first. Waits on the serial port itself, or on the RX thread's eventfd
+* when the thread owns the port, so an early frame wakes the caller at once.
+* Spurious wake-ups are possible; callers re-check for frames and loop.
+* @param deadline  Monotonic deadline. time_point::max() waits with no timeout.
+* @return  false once the deadline has passed, true otherwise.
+*/
+  bool Transport::waitForInput(std::chrono::steady_clock::time_point deadline)
+  {
+    int timeout_ms = -1;
+    if (deadline != std::chrono::steady_clock::time_point::max())
+    {
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      if (now >= deadline)
+      {
+        return false;
+      }
+      // Round up, so we never wake just short of the deadline and spin
+      timeout_ms = static_cast<int>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              deadline - now + std::chrono::microseconds(999)).count());
+    }
 
-    // Breaking out of loop indicates end of available serial input
-    return NULL;
+    int ret;
+    if (rx_thread_running)
+    {
+      struct pollfd pfd;
+      pfd.fd = rx_event_fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      ret = ::poll(&pfd, 1, timeout_ms);
+      if (ret > 0)
+      {
+        uint64_t count;
+        ssize_t got = ::read(rx_event_fd, &count, sizeof(count));
+        (void) got;
+      }
+      else if (ret < 0 && errno == EINTR)
+      {
+        ret = 0;
+      }
+    }
+    else
+    {
+      ret = WaitForData(serial, timeout_ms);
+    }
+
+    if (ret < 0)
+    {
+      // Port in a bad state (e.g. hung up); back off instead of spinning on it
+      if (!rx_thread_running)
+      {
+        portError();
+      }
+      usleep(1000);
+    }
+    return true;
   }
 
 /**
@@ -317,7 +607,7 @@ namespace clearpath
   {
     Message *msg = NULL;
 
-    while ((msg = rxMessage()))
+    while ((msg = nextFrame()))
     {
       /* Queue any data messages that turn up */
       if (msg->isData())
@@ -334,6 +624,13 @@ namespace clearpath
         continue;
       }
 
+      /* Acks for sendAsync() messages are not the one being waited for */
+      if (handleAsyncAck(msg))
+      {
+        delete msg;
+        continue;
+      }
+
       return msg;
     }
 
@@ -341,9 +638,9 @@ namespace clearpath
   }
 
 /**
-* Add a Message to the Message queue.
+* Add a Message to the queue for its type.
 * Checks Message validity, and drops invalid messages.
-* Trims queue down to size if it gets too big.
+* A full queue drops its oldest message to make room.
 * @param msg   The message to enqueue.
 */
   void Transport::enqueueMessage(Message *msg)
@@ -356,24 +653,322 @@ namespace clearpath
       return;
     }
 
-    // Enqueue
-    rx_queue.push_back(msg);
+    TypeQueue *queue = findQueue(msg->getType(), true);
+    if (!queue)
+    {
+      // More distinct types than slots; not something the MCU sends
+      ++counters[QUEUE_FULL];
+      delete msg;
+      return;
+    }
+
+    /* Replacing the sample is the whole point of a latest-value queue,
+     * so only count it as an overflow for FIFOs */
+    size_t depth = queue->depth;
+    if (queue->count == depth)
+    {
+      if (depth > 1) { ++counters[QUEUE_FULL]; }
+      dropOldest(*queue);
+    }
+
+    clock_sync.addSample(msg->getTimestamp(), msg->rx_time, msg->total_len);
 
-    /* Drop the oldest messages if the queue has overflowed */
-    while (rx_queue.size() > MAX_QUEUE_LEN)
+    if (!queue->frames.empty())
     {
+      storeCompact(*queue, msg);
+      return;
+    }
+
+    QueueEntry &entry = queue->entries[(queue->head + queue->count) % depth];
+    entry.msg = msg;
+    entry.seq = rx_seq++;
+    ++queue->count;
+    ++rx_queued;
+  }
+
+/**
+* Look up the queue for a message type.
+* Registered data messages own the slot at their registry index; anything else
+* shares the slots above those.
+* @param create  Claim a free slot for the type if it has none yet.
+* @return  The queue, or null if there is none (or no room for a new one).
+*/
+  Transport::TypeQueue *Transport::findQueue(uint16_t type, bool create)
+  {
+    static_assert(DataMessages::SIZE < TYPE_SLOTS, "No receive slots left for unregistered types");
+    static const size_t SHARED_SLOTS = TYPE_SLOTS - DataMessages::SIZE;
+
+    int registered = DataMessages::indexOf(type);
+    if (registered >= 0)
+    {
+      TypeQueue &queue = rx_queues[registered];
+      if (!queue.in_use)
+      {
+        if (!create) { return NULL; }
+        queue.in_use = true;
+        queue.type = type;
+      }
+      return &queue;
+    }
+
+    // Fibonacci hash spreads the clustered type IDs (0x80xx, 0x88xx, ...) over the table
+    size_t inx = (((type * 40503u) & 0xFFFF) * SHARED_SLOTS) >> 16;
+    for (size_t probe = 0; probe < SHARED_SLOTS; ++probe)
+    {
+      TypeQueue &queue = rx_queues[DataMessages::SIZE + inx];
+      if (!queue.in_use)
+      {
+        if (!create) { return NULL; }
+        queue.in_use = true;
+        queue.type = type;
+        return &queue;
+      }
+      if (queue.type == type)
+      {
+        return &queue;
+      }
+      inx = (inx + 1 == SHARED_SLOTS) ? 0 : inx + 1;
+    }
+    return NULL;
+  }
+
+/**
+* @return  The queue holding the oldest message of any type, or null if all are empty.
+*/
+  Transport::TypeQueue *Transport::oldestQueue()
+  {
+    TypeQueue *oldest = NULL;
+    if (!rx_queued)
+    {
+      return NULL;
+    }
+    for (size_t i = 0; i < TYPE_SLOTS; ++i)
+    {
+      TypeQueue &queue = rx_queues[i];
+      if (queue.count && (!oldest || oldestSeq(queue) < oldestSeq(*oldest)))
+      {
+        oldest = &queue;
+      }
+    }
+    return oldest;
+  }
+
+  unsigned long Transport::oldestSeq(TypeQueue &queue)
+  {
+    return queue.frames.empty() ? queue.entries[queue.head].seq : headRecord(queue)->seq;
+  }
+
+  Message *Transport::takeOldest(TypeQueue &queue)
+  {
+    if (!queue.frames.empty())
+    {
+      // Rebuild the message; the frame was validated on the way in
+      FrameRecord *record = headRecord(queue);
+      void *frame = record + 1;
+      Message *msg = Message::factory(frame, record->frame_len, std::nothrow);
+      if (!msg) { msg = new Message(frame, record->frame_len); }
+      msg->rx_time = record->rx_time;
+      msg->crc_state = Message::CRC_GOOD;
+      advanceRecord(queue);
+      return msg;
+    }
+
+    Message *msg = queue.entries[queue.head].msg;
+    queue.head = (queue.head + 1) % queue.entries.size();
+    --queue.count;
+    --rx_queued;
+    return msg;
+  }
+
+/**
+* Discard the oldest message of a queue, without building it if it is compact.
+*/
+  void Transport::dropOldest(TypeQueue &queue)
+  {
+    if (!queue.frames.empty())
+    {
+      advanceRecord(queue);
+      return;
+    }
+    delete takeOldest(queue);
+  }
+
+/**
+* Compact queues: frames are copied into the type's byte ring as length-prefixed
+* records and the Message goes straight back to the pool, so a backlog costs
+* its frame bytes plus a small header rather than a whole Message each.
+* The oldest records make way when the ring is full.
+*/
+  void Transport::storeCompact(TypeQueue &queue, Message *msg)
+  {
+    size_t capacity = queue.frames.size();
+    size_t size = (sizeof(FrameRecord) + msg->total_len + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+
+    while (true)
+    {
+      if (!queue.count)
+      {
+        queue.head = queue.frames_tail = 0;
+      }
+      size_t tail = queue.frames_tail;
+      if (!queue.count || tail > queue.head)
+      {
+        // Free space runs from the tail to the end, then from the start up to the head
+        if (capacity - tail >= size) { break; }
+        if (queue.count && queue.head >= size)
+        {
+          if (tail < capacity)
+          {
+            // Only the size: records are 8-byte aligned, so as little as 8 bytes may be left
+            uint32_t end = 0;
+            memcpy(&queue.frames[tail], &end, sizeof(end));
+          }
+          queue.frames_tail = 0;
+          break;
+        }
+      }
+      else if (queue.head - tail >= size)
+      {
+        // Already wrapped: the only free space is between the tail and the head
+        break;
+      }
+
+      if (!queue.count)
+      {
+        // Larger than the whole ring; setQueueBytes() rules this out
+        ++counters[QUEUE_FULL];
+        delete msg;
+        return;
+      }
       ++counters[QUEUE_FULL];
-      delete rx_queue.front();
-      rx_queue.pop_front();
+      advanceRecord(queue);
     }
+
+    FrameRecord *record = new (&queue.frames[queue.frames_tail]) FrameRecord();
+    record->size = static_cast<uint32_t>(size);
+    record->frame_len = static_cast<uint32_t>(msg->total_len);
+    record->seq = rx_seq++;
+    record->rx_time = msg->rx_time;
+    memcpy(record + 1, msg->data, msg->total_len);
+    queue.frames_tail += size;
+    ++queue.count;
+    ++rx_queued;
+    delete msg;
   }
 
+  Transport::FrameRecord *Transport::headRecord(TypeQueue &queue)
+  {
+    return reinterpret_cast<FrameRecord *>(&queue.frames[queue.head]);
+  }
+
+  void Transport::advanceRecord(TypeQueue &queue)
+  {
+    queue.head += headRecord(queue)->size;
+    --queue.count;
+    --rx_queued;
+    if (!queue.count)
+    {
+      queue.head = queue.frames_tail = 0;
+    }
+    else if (queue.head == queue.frames.size())
+    {
+      queue.head = 0;
+    }
+    else
+    {
+      // The end marker is a bare size, not a whole FrameRecord
+      uint32_t next_size;
+      memcpy(&next_size, &queue.frames[queue.head], sizeof(next_size));
+      if (next_size == 0) { queue.head = 0; }
+    }
+  }
+
+/**
+* Set how many messages of a type are kept until popped.
+* The default of 1 keeps only the most recent sample; deeper queues keep
+* history, oldest first, dropping the oldest when full. May be called before
+* the Transport is configured, and survives reconfiguration.
+* @param type   The data message type
+* @param depth  Number of messages to keep, clamped to [1, MAX_QUEUE_LEN]
+*/
+  void Transport::setQueueDepth(enum MessageTypes type, size_t depth)
+  {
+    if (depth < 1) { depth = 1; }
+    if (depth > MAX_QUEUE_LEN) { depth = MAX_QUEUE_LEN; }
+
+    TypeQueue *queue = findQueue(type, true);
+    if (!queue)
+    {
+      throw new TransportException("No free message queue slot", TransportException::ERROR_BASE);
+    }
+
+    while (queue->count > depth)
+    {
+      dropOldest(*queue);
+    }
+    queue->depth = depth;
+    if (!queue->frames.empty())
+    {
+      return;
+    }
+
+    // Repack whatever is left, oldest first
+    std::vector<QueueEntry> entries(depth);
+    size_t count = queue->count;
+    for (size_t i = 0; i < count; ++i)
+    {
+      entries[i] = queue->entries[(queue->head + i) % queue->entries.size()];
+    }
+    queue->entries.swap(entries);
+    queue->head = 0;
+  }
+
+/**
+* Switch a type's queue to compact storage: received frames are kept as raw
+* bytes in a ring of the given size, and only become Messages when popped.
+* The queue still holds at most its depth in messages; whichever of the two
+* limits is reached first drops the oldest. Meant for deep queues of small
+* frames, where a whole Message per queued frame is mostly empty buffer.
+* Anything already queued of the type is discarded. Survives reconfiguration.
+* @param type   The data message type
+* @param bytes  Size of the ring, rounded up to hold at least one frame of any
+*               length and capped at MAX_QUEUE_BYTES. Zero returns the queue to
+*               holding Messages.
+*/
+  void Transport::setQueueBytes(enum MessageTypes type, size_t bytes)
+  {
+    TypeQueue *queue = findQueue(type, true);
+    if (!queue)
+    {
+      throw new TransportException("No free message queue slot", TransportException::ERROR_BASE);
+    }
+
+    while (queue->count)
+    {
+      dropOldest(*queue);
+    }
+    queue->head = queue->frames_tail = 0;
+
+    if (!bytes)
+    {
+      std::vector<uint8_t>().swap(queue->frames);
+      queue->entries.resize(queue->depth);
+      return;
+    }
+
+    const size_t MIN_BYTES = (sizeof(FrameRecord) + Message::MAX_MSG_LENGTH + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+    if (bytes < MIN_BYTES) { bytes = MIN_BYTES; }
+    if (bytes > MAX_QUEUE_BYTES) { bytes = MAX_QUEUE_BYTES; }
+    bytes = (bytes + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+    std::vector<uint8_t>(bytes).swap(queue->frames);
+    std::vector<QueueEntry>().swap(queue->entries);
+  }
 
 /**
 * Public function which makes sure buffered messages are still being read into
 * the internal buffer. A compromise between forcing a thread-based implementation
-* and blocking on results. This could be placed into a separate thread, but will
-* need to be wrapped for thread safety
+* and blocking on results. When the RX thread is enabled, this only moves frames
+* it has already parsed out of the ring and never touches the serial port.
 */
   void Transport::poll()
   {
@@ -381,12 +976,12 @@ namespace clearpath
 
     Message *msg = NULL;
 
-    while ((msg = rxMessage()))
+    while ((msg = nextFrame()))
     {
-      /* We're not waiting for acks, so drop them */
+      /* We're not waiting for acks, so drop them, unless they settle an async send */
       if (!msg->isData())
       {
-        ++counters[IGNORED_ACK];
+        if (!handleAsyncAck(msg)) { ++counters[IGNORED_ACK]; }
         delete msg;
         continue;
       }
@@ -394,6 +989,8 @@ namespace clearpath
       // Message is good, queue it.
       enqueueMessage(msg);
     }
+
+    serviceAsyncSends();
   }
 
 /**
@@ -405,12 +1002,24 @@ namespace clearpath
 */
   void Transport::send(Message *m)
   {
-    CHECK_THROW_CONFIGURED();
+    uint16_t ack_code = 0;
+    throwResult(trySend(m, &ack_code), ack_code);
+  }
+
+/**
+* Non-throwing send(): same retries, but the outcome is returned.
+* @param m         The message to send
+* @param ack_code  If not null, set to the ack's result code on TRANSFER_BAD_ACK
+*/
+  enum transferResult Transport::trySend(Message *m, uint16_t *ack_code)
+  {
+    if (!configured) { return TRANSFER_NOT_CONFIGURED; }
 
     char skip_send = 0;
     Message *ack = NULL;
     int transmit_times = 0;
     short result_code;
+    std::chrono::steady_clock::time_point written;
 
     poll();
 
@@ -422,31 +1031,45 @@ namespace clearpath
         break;
       }
       // Write output
-      if (!skip_send) { WriteData(serial, (char *) (m->data), m->total_len); }
+      if (!skip_send)
+      {
+        writeFrames(m->data, m->total_len, 1);
+        written = std::chrono::steady_clock::now();
+        if (transmit_times > 0) { ++counters[RETRANSMITS]; }
+      }
 
-      // Wait up to 100 ms for ack
-      for (int i = 0; i < RETRY_DELAY_MS; ++i)
+      // Wait up to the ack timeout, waking as soon as input arrives
+      std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + rtt_estimator.timeout();
+      while (!(ack = getAck()) && waitForInput(deadline))
       {
-        usleep(1000);
-        if ((ack = getAck())) { break; }
       }
 
       // No message - resend
       if (ack == NULL)
       {
+        rtt_estimator.addTimeout();
         skip_send = 0;
         //cout << "No message received yet" << endl;
         transmit_times++;
         continue;
       }
 
+      ack_latency.record(std::chrono::steady_clock::now() - written);
+      clock_sync.addRoundTrip(ack->rx_time - written, m->total_len, ack->total_len);
+      if (transmit_times == 0)
+      {
+        rtt_estimator.addSample(ack->rx_time - written);
+      }
+
       // Check result code
       // If the result code is bad, the message was still transmitted
       // successfully
       result_code = btou(ack->getPayloadPointer(), 2);
       if (result_code > 0)
       {
-        throw new BadAckException(result_code);
+        delete ack;
+        if (ack_code) { *ack_code = result_code; }
+        return TRANSFER_BAD_ACK;
       }
       else
       {
@@ -458,11 +1081,339 @@ namespace clearpath
     }
     if (ack == NULL)
     {
-      throw new TransportException("Unacknowledged send", TransportException::UNACKNOWLEDGED_SEND);
+      return TRANSFER_UNACKNOWLEDGED;
     }
     delete ack;
 
     m->is_sent = true;
+    return TRANSFER_OK;
+  }
+
+/**
+* Send several messages with a single write and wait for all of their acks.
+* Acks are matched to messages by type and may arrive in any order; messages
+* still unacknowledged after the ack timeout are resent together, up to the
+* configured number of retries, as with send().
+* @param msgs      The messages to send
+* @param count     Number of messages, at most MAX_BATCH_LEN
+* @param deadline  Give up waiting for acks at this point, even with retries left
+* @throw   Transport::Exception if any message is never acknowledged,
+*          BadAckException if one is acknowledged with an error.
+*/
+  void Transport::sendBatch(Message **msgs, size_t count, std::chrono::steady_clock::time_point deadline)
+  {
+    uint16_t ack_code = 0;
+    throwResult(trySendBatch(msgs, count, deadline, &ack_code), ack_code);
+  }
+
+/**
+* Non-throwing sendBatch().
+* @param ack_code  If not null, set to the first error result code on TRANSFER_BAD_ACK
+*/
+  enum transferResult Transport::trySendBatch(Message **msgs, size_t count,
+                                              std::chrono::steady_clock::time_point deadline,
+                                              uint16_t *ack_code)
+  {
+    if (!configured) { return TRANSFER_NOT_CONFIGURED; }
+
+    if (count > MAX_BATCH_LEN)
+    {
+      return TRANSFER_TOO_LONG;
+    }
+
+    bool acked[MAX_BATCH_LEN] = {false};
+    uint8_t out[MAX_BATCH_LEN * Message::MAX_MSG_LENGTH];
+    size_t remaining = count;
+
+    poll();
+
+    for (int transmit_times = 0;
+         remaining && transmit_times <= this->retries && std::chrono::steady_clock::now() < deadline;
+         ++transmit_times)
+    {
+      // Coalesce everything still outstanding into one write
+      size_t out_len = 0;
+      for (size_t i = 0; i < count; ++i)
+      {
+        if (acked[i]) { continue; }
+        memcpy(out + out_len, msgs[i]->data, msgs[i]->total_len);
+        out_len += msgs[i]->total_len;
+      }
+      writeFrames(out, out_len, remaining);
+      std::chrono::steady_clock::time_point written = std::chrono::steady_clock::now();
+      if (transmit_times > 0) { counters[RETRANSMITS] += remaining; }
+
+      std::chrono::steady_clock::time_point retry_deadline = std::min(
+          deadline, std::chrono::steady_clock::now() + rtt_estimator.timeout());
+      while (remaining)
+      {
+        Message *ack = getAck();
+        if (!ack)
+        {
+          if (!waitForInput(retry_deadline))
+          {
+            rtt_estimator.addTimeout();
+            break;
+          }
+          continue;
+        }
+
+        size_t inx = 0;
+        while (inx < count && (acked[inx] || msgs[inx]->getType() != ack->getType()))
+        {
+          ++inx;
+        }
+        if (inx == count)
+        {
+          ++counters[IGNORED_ACK];
+          delete ack;
+          continue;
+        }
+
+        ack_latency.record(std::chrono::steady_clock::now() - written);
+        if (transmit_times == 0)
+        {
+          rtt_estimator.addSample(ack->rx_time - written);
+        }
+        short result_code = btou(ack->getPayloadPointer(), 2);
+        delete ack;
+        if (result_code == BadAckException::BAD_CHECKSUM)
+        {
+          // Garbled on the way out; goes again with the next write
+          continue;
+        }
+        if (result_code > 0)
+        {
+          if (ack_code) { *ack_code = result_code; }
+          return TRANSFER_BAD_ACK;
+        }
+        acked[inx] = true;
+        msgs[inx]->is_sent = true;
+        --remaining;
+      }
+    }
+
+    if (remaining)
+    {
+      return TRANSFER_UNACKNOWLEDGED;
+    }
+    return TRANSFER_OK;
+  }
+
+/**
+* Send a message without waiting for it to be acknowledged.
+* The message gets a unique timestamp so its ack can be told apart, and is
+* copied into the pending table; the caller keeps ownership of m. Acks are
+* collected and timed-out messages retransmitted (up to the configured retries)
+* whenever the Transport is polled, which every receive call does.
+* @param m          The message to send. Its timestamp is overwritten.
+* @param supersede  Stop retransmitting any unacked messages of the same type,
+*                   so a fresher setpoint replaces them rather than queueing up.
+* @return A ticket for getSendStatus(). Never zero.
+*/
+  unsigned long Transport::sendAsync(Message *m, bool supersede)
+  {
+    unsigned long ticket = 0;
+    throwResult(trySendAsync(m, supersede, &ticket), 0);
+    return ticket;
+  }
+
+/**
+* Non-throwing sendAsync().
+* @param ticket  Set to the ticket for getSendStatus() on TRANSFER_OK
+*/
+  enum transferResult Transport::trySendAsync(Message *m, bool supersede, unsigned long *ticket)
+  {
+    if (!configured) { return TRANSFER_NOT_CONFIGURED; }
+
+    // Settle whatever has been acked already before claiming a slot
+    poll();
+
+    if (supersede)
+    {
+      for (size_t i = 0; i < MAX_PENDING_SENDS; ++i)
+      {
+        if (pending[i].status == SEND_PENDING && pending[i].type == m->getType())
+        {
+          pending[i].status = SEND_SUPERSEDED;
+          --num_pending;
+        }
+      }
+    }
+
+    *ticket = next_ticket++;
+    PendingSend &p = pending[*ticket % MAX_PENDING_SENDS];
+    if (p.status == SEND_PENDING)
+    {
+      // Table has wrapped around onto a message the MCU never answered
+      ++counters[ASYNC_UNACKED];
+      --num_pending;
+    }
+
+    // Timestamp zero is left to synchronous sends, so their acks never match here
+    if (++next_async_stamp == 0) { ++next_async_stamp; }
+    m->setTimestamp(next_async_stamp);
+    m->makeValid();
+
+    p.ticket = *ticket;
+    p.status = SEND_PENDING;
+    p.type = m->getType();
+    p.timestamp = next_async_stamp;
+    p.result_code = 0;
+    p.transmit_times = 0;
+    p.total_len = m->total_len;
+    memcpy(p.data, m->data, m->total_len);
+    ++num_pending;
+
+    writePending(p);
+    m->is_sent = true;
+    return TRANSFER_OK;
+  }
+
+/**
+* Look up the progress of a message sent with sendAsync().
+* Only the most recent MAX_PENDING_SENDS tickets are remembered.
+* @param ticket       As returned by sendAsync()
+* @param result_code  If not null, receives the ack result code of a rejected message
+*/
+  enum Transport::sendStatus Transport::getSendStatus(unsigned long ticket, uint16_t *result_code)
+  {
+    PendingSend &p = pending[ticket % MAX_PENDING_SENDS];
+    if (ticket == 0 || p.ticket != ticket)
+    {
+      return SEND_UNKNOWN;
+    }
+    if (result_code) { *result_code = p.result_code; }
+    return p.status;
+  }
+
+  void Transport::writePending(PendingSend &p)
+  {
+    writeFrames(p.data, p.total_len, 1);
+    ++p.transmit_times;
+    p.written = std::chrono::steady_clock::now();
+    p.deadline = p.written + rtt_estimator.timeout();
+  }
+
+/**
+* All writes to the port go through here, so the traffic counters stay complete.
+*/
+  void Transport::writeFrames(const uint8_t *data, size_t len, size_t frames)
+  {
+    WriteData(serial, reinterpret_cast<const char *>(data), static_cast<int>(len));
+    counters[TX_BYTES] += len;
+    counters[TX_FRAMES] += frames;
+    if (FrameCapture *recorder = capture.load(std::memory_order_acquire))
+    {
+      recorder->record(CAPTURE_TX, data, len);
+    }
+  }
+
+/**
+* Record all traffic on the port to a capture file, see FrameCapture.
+* Independent of configure() and close(), so a capture spans reconnects.
+* Not thread safe against itself or stopCapture().
+* @return false if the file could not be created.
+*/
+  bool Transport::startCapture(const char *path)
+  {
+    FrameCapture *recorder = capture.load(std::memory_order_acquire);
+    if (!recorder)
+    {
+      recorder = new FrameCapture();
+      capture.store(recorder, std::memory_order_release);
+    }
+    return recorder->open(path);
+  }
+
+  void Transport::stopCapture()
+  {
+    if (FrameCapture *recorder = capture.load(std::memory_order_acquire))
+    {
+      recorder->close();
+    }
+  }
+
+/**
+* Settle the pending async send an ack belongs to, if any.
+* A bad checksum is retried like send() does; other error codes reject the message.
+* @return true if the ack was for an async send (even a superseded one), false otherwise.
+*/
+  bool Transport::handleAsyncAck(Message *ack)
+  {
+    uint32_t timestamp = ack->getTimestamp();
+    if (timestamp == 0)
+    {
+      return false;
+    }
+
+    uint16_t type = ack->getType();
+    for (size_t i = 0; i < MAX_PENDING_SENDS; ++i)
+    {
+      PendingSend &p = pending[i];
+      if (p.status == SEND_UNKNOWN || p.timestamp != timestamp || p.type != type)
+      {
+        continue;
+      }
+      if (p.status != SEND_PENDING)
+      {
+        // Late ack for something already settled
+        return true;
+      }
+
+      ack_latency.record(std::chrono::steady_clock::now() - p.written);
+      clock_sync.addRoundTrip(ack->rx_time - p.written, p.total_len, ack->total_len);
+      if (p.transmit_times == 1)
+      {
+        rtt_estimator.addSample(ack->rx_time - p.written);
+      }
+
+      uint16_t result_code = (ack->getPayloadLength() >= 2) ? btou(ack->getPayloadPointer(), 2) : 0;
+      if (result_code == BadAckException::BAD_CHECKSUM && p.transmit_times <= retries)
+      {
+        writePending(p);
+        ++counters[RETRANSMITS];
+      }
+      else
+      {
+        p.status = result_code ? SEND_REJECTED : SEND_ACKED;
+        p.result_code = result_code;
+        --num_pending;
+      }
+      return true;
+    }
+    return false;
+  }
+
+/**
+* Retransmit async sends whose ack is overdue, and give up on those out of retries.
+*/
+  void Transport::serviceAsyncSends()
+  {
+    if (!num_pending)
+    {
+      return;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < MAX_PENDING_SENDS; ++i)
+    {
+      PendingSend &p = pending[i];
+      if (p.status != SEND_PENDING || p.deadline > now)
+      {
+        continue;
+      }
+      rtt_estimator.addTimeout();
+      if (p.transmit_times > retries)
+      {
+        p.status = SEND_TIMED_OUT;
+        --num_pending;
+        ++counters[ASYNC_UNACKED];
+        continue;
+      }
+      writePending(p);
+      ++counters[RETRANSMITS];
+    }
   }
 
 /**
@@ -479,11 +1430,10 @@ namespace clearpath
 
     poll();  // empty the current serial RX queue.
 
-    if (rx_queue.empty()) { return NULL; }
+    TypeQueue *queue = oldestQueue();
+    if (!queue) { return NULL; }
 
-    Message *next = rx_queue.front();
-    rx_queue.pop_front();
-    return next;
+    return takeOldest(*queue);
   }
 
 /**
@@ -502,84 +1452,101 @@ namespace clearpath
 
     poll(); // empty the current RX queue
 
-    Message *next;
-    list<Message *>::iterator iter;
-    for (iter = rx_queue.begin(); iter != rx_queue.end(); ++iter)
+    TypeQueue *queue = findQueue(type, false);
+    if (!queue || !queue->count) { return NULL; }
+
+    return takeOldest(*queue);
+  }
+
+/**
+* Removes the newest message of a specific type from the queue and returns it,
+* discarding any older ones of that type. Constant time in the number of queued
+* messages of other types.
+* All data waiting in the input buffer will be read and queued.
+* @return  The most recent message of the type, to be freed by the caller.
+*          Null if none has been received since the last pop.
+*/
+  Message *Transport::popLatest(enum MessageTypes type)
+  {
+    CHECK_THROW_CONFIGURED();
+
+    poll();
+
+    TypeQueue *queue = findQueue(type, false);
+    if (!queue || !queue->count) { return NULL; }
+
+    while (queue->count > 1)
     {
-      if ((*iter)->getType() == type)
-      {
-        next = *iter;
-        rx_queue.erase(iter);
-        return next;
-      }
+      dropOldest(*queue);
     }
-    return NULL;
+    return takeOldest(*queue);
   }
 
 /**
 * Fetch a message, blocking if there are no messages currently available.
-* @param timeout   Maximum time to block, in seconds.
-*                  Actual resolution is system dependent
+* @param timeout   Maximum time to block, in seconds, measured on the
+*                  monotonic clock.
 *                  A timeout of 0.0 indicates no timeout.
 * @return  A message.  Null if the timeout elapses. */
   Message *Transport::waitNext(double timeout)
   {
     CHECK_THROW_CONFIGURED();
 
-    double elapsed = 0.0;
+    std::chrono::steady_clock::time_point deadline = waitDeadline(timeout);
     while (true)
     {
       /* Return a message if it's turned up */
       poll();
-      if (!rx_queue.empty()) { return popNext(); }
+      if (rx_queued) { return popNext(); }
 
-      /* Check timeout */
-      if ((timeout != 0.0) && (elapsed > timeout))
+      // Block until more input arrives; if we have a timeout set, and it has elapsed, exit.
+      if (!waitForInput(deadline))
       {
-        // If we have a timeout set, and it has elapsed, exit.
         return NULL;
       }
-
-      // Wait a ms before retry
-      usleep(1000);
-      elapsed += 0.001;
     }
   }
 
 /**
 * Fetch a particular type of message, blocking if one isn't available.
 * @param type      The type of message to fetch
-* @param timeout   Maximum time to block, in seconds.
-*                  Actual resolution is system dependent
+* @param timeout   Maximum time to block, in seconds, measured on the
+*                  monotonic clock.
 *                  A timeout of 0.0 indicates no timeout.
 * @return A message of the requested type.  Nul if the timeout elapses.
 */
   Message *Transport::waitNext(enum MessageTypes type, double timeout)
   {
-    CHECK_THROW_CONFIGURED();
+    Message *msg = NULL;
+    throwResult(tryWaitNext(type, timeout, &msg), 0);
+    return msg;
+  }
 
-    double elapsed = 0.0;
-    Message *msg;
+/**
+* Non-throwing waitNext(type).
+* @param msg  Set to the message on TRANSFER_OK, null otherwise
+* @return TRANSFER_TIMED_OUT if the timeout elapses first.
+*/
+  enum transferResult Transport::tryWaitNext(enum MessageTypes type, double timeout, Message **msg)
+  {
+    *msg = NULL;
+    if (!configured) { return TRANSFER_NOT_CONFIGURED; }
+
+    std::chrono::steady_clock::time_point deadline = waitDeadline(timeout);
 
     while (true)
     {
       /* Check if the message has turned up
-       * Since we're blocking, not doing anything useful anyway, it doesn't
-       * really matter that we're iterating the entire message queue every spin. */
+       * Each type has its own queue, so this is a constant-time lookup. */
       poll();
-      msg = popNext(type);
-      if (msg) { return msg; }
+      *msg = popNext(type);
+      if (*msg) { return TRANSFER_OK; }
 
-      /* Check timeout */
-      if ((timeout != 0.0) && (elapsed > timeout))
+      // Block until more input arrives; if a timeout is set and has elapsed, fail out.
+      if (!waitForInput(deadline))
       {
-        // If a timeout is set and has elapsed, fail out.
-        return NULL;
+        return TRANSFER_TIMED_OUT;
       }
-
-      // Wait a ms  before retry
-      usleep(1000);
-      elapsed += 0.001;
     }
   }
 
@@ -598,20 +1565,18 @@ namespace clearpath
 
     /* Either delete or move all elements in the queue, depending
      * on whether a destination list is provided */
-    list<Message *>::iterator iter;
-    for (iter = rx_queue.begin(); iter != rx_queue.end(); ++iter)
+    while (TypeQueue *oldest = oldestQueue())
     {
+      Message *msg = takeOldest(*oldest);
       if (queue)
       {
-        queue->push_back(*iter);
+        queue->push_back(msg);
       }
       else
       {
-        delete *iter;
+        delete msg;
       }
     }
-
-    rx_queue.clear();
   }
 
 /**
@@ -629,28 +1594,18 @@ namespace clearpath
 
     poll();
 
-    list<Message *>::iterator iter = rx_queue.begin();
-    while (iter != rx_queue.end())
+    TypeQueue *type_queue = findQueue(type, false);
+    while (type_queue && type_queue->count)
     {
-      if ((*iter)->getType() == type)
+      /* If there's a destination list, move it.  Otherwise, destroy it */
+      Message *msg = takeOldest(*type_queue);
+      if (queue)
       {
-        /* Element is of flush type.  If there's a destination
-         * list, move it.  Otherwise, destroy it */
-        if (queue)
-        {
-          queue->push_back(*iter);
-        }
-        else
-        {
-          delete *iter;
-        }
-        // This advances to the next element in the queue:
-        iter = rx_queue.erase(iter);
+        queue->push_back(msg);
       }
       else
       {
-        // Not interested in this element.  Next!
-        iter++;
+        delete msg;
       }
     }
   }
@@ -674,11 +1629,19 @@ namespace clearpath
     for (int i = 0; i < NUM_COUNTERS; ++i)
     {
       cout.width(longest_name);
-      cout << left << counter_names[i] << ": " << counters[i] << endl;
+      cout << left << counter_names[i] << ": " << counters[i].load() << endl;
     }
 
     cout.width(longest_name);
-    cout << left << "Queue length" << ": " << rx_queue.size() << endl;
+    cout << left << "Queue length" << ": " << rx_queued << endl;
+
+    // Any heap allocations here mean a pool ran dry or a Message outgrew its block
+    cout.width(longest_name);
+    cout << left << "Pooled messages" << ": " << messagePool().poolAllocations()
+         << " (heap " << messagePool().heapAllocations() << ")" << endl;
+    cout.width(longest_name);
+    cout << left << "Pooled control blocks" << ": " << nodePool().poolAllocations()
+         << " (heap " << nodePool().heapAllocations() << ")" << endl;
   }
 
 /**
@@ -11,7 +11,8 @@
 *             ROBOTICS�
 *
 *  File: crc.cpp
-*  Desc: 16 bit CRC function and lookup table. Uses a table-based implementation.
+*  Desc: 16 bit CRC function and lookup table. Uses a table-based implementation,
+*        processing eight bytes per step (slicing-by-8).
 *        When INIT_VAL=0xFFFF, this is identical to that used on the
 *        various uCs which implement Horizon
 *  Auth: R. Gariepy
@@ -72,12 +73,71 @@ const uint16_t table[256] =
         16050, 3793, 7920};
 
 
+/* Slicing-by-8 tables: slice[k][v] is the CRC contribution of byte v followed
+ * by k zero bytes, so eight input bytes fold into the register with eight
+ * independent lookups instead of a chain of eight dependent ones.
+ * slice[0] is the classic table above; built at compile time from it. */
+namespace
+{
+  struct SliceTables
+  {
+    uint16_t slice[8][256];
+
+    constexpr SliceTables() : slice()
+    {
+      for (int v = 0; v < 256; ++v)
+      {
+        uint16_t crc = static_cast<uint16_t>(v << 8);
+        for (int bit = 0; bit < 8; ++bit)
+        {
+          crc = static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1));
+        }
+        slice[0][v] = crc;
+      }
+      for (int k = 1; k < 8; ++k)
+      {
+        for (int v = 0; v < 256; ++v)
+        {
+          uint16_t prev = slice[k - 1][v];
+          slice[k][v] = static_cast<uint16_t>((prev << 8) ^ slice[0][prev >> 8]);
+        }
+      }
+    }
+  };
+
+  constexpr SliceTables tables;
+
+  static_assert(tables.slice[0][1] == 4129 && tables.slice[0][255] == 7920,
+                "Generated CRC table must match the reference table");
+}
+
 /***----------Table-driven crc function----------***/
 /*Inputs: -size of the character array, the CRC of which is being computed   */
 /*        - the initial value of the register to be used in the calculation  */
 /*        - a pointer to the first element of said character array */
 /*Outputs: the crc as an unsigned short int    */
-uint16_t crc16(int size, int init_val, uint8_t *data)
+uint16_t crc16(int size, int init_val, const uint8_t *data)
+{
+  uint16_t crc = static_cast<uint16_t>(init_val);
+  const uint16_t (*t)[256] = tables.slice;
+
+  while (size >= 8)
+  {
+    crc = t[7][data[0] ^ (crc >> 8)] ^ t[6][data[1] ^ (crc & 0xFF)] ^
+          t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^
+          t[1][data[6]] ^ t[0][data[7]];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0)
+  {
+    crc = (crc << 8) ^ t[0][((crc >> 8) ^ *data++) & 0xFF];
+  }
+  return crc;
+}
+
+/* Original one-byte-per-step loop, kept as the reference for validation */
+uint16_t crc16_bytewise(int size, int init_val, const uint8_t *data)
 {
   unsigned short int crc = static_cast<unsigned short int>(init_val);
   while (size--)
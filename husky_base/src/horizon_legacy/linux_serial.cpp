@@ -54,6 +54,9 @@
 #include <fcntl.h>   /* File control definitions */
 #include <errno.h>   /* Error number definitions */
 #include <termios.h> /* POSIX terminal control definitions */
+#include <poll.h>    /* poll() */
+#include <sys/ioctl.h>     /* ioctl() */
+#include <linux/serial.h>  /* struct serial_struct, ASYNC_LOW_LATENCY */
 #include <stdlib.h>  /* Malloc */
 #include <assert.h>
 
@@ -82,12 +85,98 @@ int OpenSerial(void **handle, const char *port_name)
   return fd;
 }
 
+void DefaultSerialProfile(SerialProfile *profile)
+{
+  profile->baud = 115200;
+  profile->low_latency = 0;
+  profile->vmin = 0;     // non-blocking
+  profile->vtime = 1;    // always return after 0.1 seconds
+  profile->latency_timer_ms = -1;
+}
+
+static speed_t BaudConstant(int baud)
+{
+  switch (baud)
+  {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 500000: return B500000;
+    case 576000: return B576000;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    default: return B0;
+  }
+}
+
+static int BaudValue(speed_t speed)
+{
+  const int rates[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 500000, 576000, 921600, 1000000};
+  for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i)
+  {
+    if (BaudConstant(rates[i]) == speed)
+    {
+      return rates[i];
+    }
+  }
+  return 0;
+}
+
+/*
+ * USB-serial adapters with a latency timer (FTDI) expose it in sysfs, e.g.
+ * /sys/class/tty/ttyUSB0/device/latency_timer
+ */
+static int ReadLatencyTimer(int fd)
+{
+  const char *tty = ttyname(fd);
+  if (!tty)
+  {
+    return -1;
+  }
+  const char *name = strrchr(tty, '/');
+  name = name ? name + 1 : tty;
+
+  char path[128];
+  snprintf(path, sizeof(path), "/sys/class/tty/%s/device/latency_timer", name);
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    return -1;
+  }
+  int ms = -1;
+  if (fscanf(file, "%d", &ms) != 1)
+  {
+    ms = -1;
+  }
+  fclose(file);
+  return ms;
+}
+
 int SetupSerial(void *handle)
 {
+  SerialProfile profile;
+  DefaultSerialProfile(&profile);
+  return SetupSerialProfile(handle, &profile, NULL);
+}
+
+int SetupSerialProfile(void *handle, const SerialProfile *requested, SerialProfile *effective)
+{
+  int fd = *(int *) handle;
   struct termios options;
 
+  speed_t speed = BaudConstant(requested->baud);
+  if (speed == B0)
+  {
+    fprintf(stderr, "Unsupported baud rate %d\n", requested->baud);
+    return -1;
+  }
+
   // Get the current options for the port...
-  tcgetattr(*(int *) handle, &options);
+  tcgetattr(fd, &options);
 
   // 8 bits, 1 stop, no parity
   options.c_cflag = 0;
@@ -96,9 +185,8 @@ int SetupSerial(void *handle)
   // Enable the receiver and set local mode...
   options.c_cflag |= (CLOCAL | CREAD);
 
-  // Set the baud rates to 115200...
-  cfsetispeed(&options, B115200);
-  cfsetospeed(&options, B115200);
+  cfsetispeed(&options, speed);
+  cfsetospeed(&options, speed);
 
   // No input processing
   options.c_iflag = 0;
@@ -110,11 +198,38 @@ int SetupSerial(void *handle)
   options.c_lflag = 0;
 
   // read timeout
-  options.c_cc[VMIN] = 0;    // non-blocking
-  options.c_cc[VTIME] = 1;    // always return after 0.1 seconds
+  options.c_cc[VMIN] = requested->vmin;
+  options.c_cc[VTIME] = requested->vtime;
 
   // Set the new options for the port...
-  tcsetattr(*(int *) handle, TCSAFLUSH, &options);
+  if (tcsetattr(fd, TCSAFLUSH, &options) < 0)
+  {
+    fprintf(stderr, "Unable to configure serial port\n");
+    return -1;
+  }
+
+  // Don't hold received bytes back for the USB latency timer; not every driver supports it
+  struct serial_struct serial;
+  int have_serial = (ioctl(fd, TIOCGSERIAL, &serial) == 0);
+  if (requested->low_latency && have_serial)
+  {
+    serial.flags |= ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &serial) < 0)
+    {
+      fprintf(stderr, "Unable to set low latency mode on serial port\n");
+    }
+    have_serial = (ioctl(fd, TIOCGSERIAL, &serial) == 0);
+  }
+
+  if (effective)
+  {
+    tcgetattr(fd, &options);
+    effective->baud = BaudValue(cfgetospeed(&options));
+    effective->low_latency = have_serial && (serial.flags & ASYNC_LOW_LATENCY) != 0;
+    effective->vmin = options.c_cc[VMIN];
+    effective->vtime = options.c_cc[VTIME];
+    effective->latency_timer_ms = ReadLatencyTimer(fd);
+  }
 
   return 0;
 }
@@ -140,6 +255,11 @@ int WriteData(void *handle, const char *buffer, int length)
   return n;
 }
 
+/**
+ * Read up to length bytes of whatever is currently available.
+ * The port is opened with O_NDELAY, so this never blocks; callers should pass
+ * a large buffer to drain the port with a single system call.
+ */
 int ReadData(void *handle, char *buffer, int length)
 {
   int bytesRead = read(*(int *) handle, buffer, length);
@@ -160,6 +280,30 @@ int ReadData(void *handle, char *buffer, int length)
   return bytesRead;
 }
 
+/**
+ * Block until the port has data to read, an error occurs or timeout_ms elapses.
+ * A negative timeout waits indefinitely.
+ * Returns 1 if data is available, 0 on timeout and -1 on error.
+ */
+int WaitForData(void *handle, int timeout_ms)
+{
+  struct pollfd pfd;
+  pfd.fd = *(int *) handle;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  int ret = poll(&pfd, 1, timeout_ms);
+  if (ret < 0)
+  {
+    return (errno == EINTR) ? 0 : -1;
+  }
+  if (ret > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) && !(pfd.revents & POLLIN))
+  {
+    return -1;
+  }
+  return ret > 0 ? 1 : 0;
+}
+
 int CloseSerial(void *handle)
 {
   if (NULL == handle)
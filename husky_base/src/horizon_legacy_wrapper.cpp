@@ -29,70 +29,526 @@
 *
 */
 
+#include <algorithm>
+#include <stdexcept>
+
+#include "husky_base/horizon_legacy_wrapper.h"
 #include "husky_base/horizon_legacy/clearpath.h"
+#include "husky_base/horizon_legacy/Logger.h"
 
 
 namespace
 {
-  std::string port_;
+  // Unanswered requests in a row before the link is declared lost
+  const int MAX_CONSECUTIVE_TIMEOUTS = 3;
+  // Resends of an unacknowledged message, unless set with Link::setRetries()
+  const int DEFAULT_RETRIES = 3;
+
+  const std::chrono::milliseconds MIN_BACKOFF(50);
+  const std::chrono::milliseconds MAX_BACKOFF(2000);
+  const std::chrono::milliseconds CONNECT_WAIT(2000);
+  // The MCU has to answer this before the link counts as up
+  const double PROBE_TIMEOUT = 0.2;
+
+  // Runs before any subscription restore hook, type IDs are all positive
+  const int LIMITS_HOOK = -1;
+
+  enum clearpath::transferResult sendLimits(clearpath::Transport &transport, double max_speed, double max_accel,
+                                            uint16_t *ack_code)
+  {
+    enum clearpath::transferResult result = clearpath::SetMaxAccel(max_accel, max_accel).trySend(transport, ack_code);
+    if (result == clearpath::TRANSFER_OK)
+    {
+      result = clearpath::SetMaxSpeed(max_speed, max_speed).trySend(transport, ack_code);
+    }
+    return result;
+  }
+
+  // Whether a fire-and-forget request may still get its data back
+  bool stillExpected(clearpath::Transport &transport, unsigned long ticket)
+  {
+    enum clearpath::Transport::sendStatus status = transport.getSendStatus(ticket);
+    return status == clearpath::Transport::SEND_PENDING || status == clearpath::Transport::SEND_ACKED;
+  }
 }
 
 namespace horizon_legacy
 {
 
-  void reconnect()
+  Link::Link() :
+      owned_transport_(new clearpath::Transport()),
+      transport_(owned_transport_.get()),
+      state_(LINK_DOWN),
+      stopping_(false),
+      retries_(DEFAULT_RETRIES),
+      consecutive_timeouts_(0),
+      speed_ticket_(0)
+  {
+  }
+
+  Link::Link(clearpath::Transport &transport) :
+      transport_(&transport),
+      state_(LINK_DOWN),
+      stopping_(false),
+      retries_(DEFAULT_RETRIES),
+      consecutive_timeouts_(0),
+      speed_ticket_(0)
+  {
+  }
+
+  Link::~Link()
   {
-    if (port_.empty())
     {
-      throw std::logic_error("Can't reconnect when port is not configured");
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+      cv_.notify_all();
+    }
+    if (thread_.joinable())
+    {
+      thread_.join();
     }
-    std::cout << "Connecting to Husky on port " << port_ << "...";
-    clearpath::Transport::instance().configure(port_.c_str(), 3);
-    std::cout << "Connected";
   }
 
-  void connect(std::string port)
+  Link &Link::instance()
   {
-    port_ = port;
-    reconnect();
+    // Constructed after, so destroyed before, the Transport it is still using until the thread is joined
+    static Link link(clearpath::Transport::instance());
+    return link;
   }
 
-  void configureLimits(double max_speed, double max_accel)
+  bool Link::connect(const std::string &port, bool rx_thread)
   {
+    return connect(port, rx_thread, CONNECT_WAIT);
+  }
 
-    bool success = false;
-    while (!success)
+  bool Link::connect(const std::string &port, bool rx_thread, std::chrono::milliseconds timeout)
+  {
+    if (port.empty())
     {
-      try
+      throw std::logic_error("Can't connect when port is not configured");
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      port_ = port;
+      if (state() != LINK_CONNECTING)
       {
-        clearpath::SetMaxAccel(max_accel, max_accel).send();
-        clearpath::SetMaxSpeed(max_speed, max_speed).send();
-        success = true;
+        // Nobody else is using the Transport right now, and the state can't change under the lock
+        transport_->enableRxThread(rx_thread);
+        state_.store(LINK_DOWN, std::memory_order_release);
       }
-      catch (clearpath::Exception *ex)
+      if (!thread_.joinable())
       {
-        std::cout << "Error configuring velocity and accel limits: " << ex->message;
-        reconnect();
+        stopping_ = false;
+        thread_ = std::thread(&Link::run, this);
+      }
+      cv_.notify_all();
+    }
+    return waitUp(timeout);
+  }
+
+  bool Link::waitUp(std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [this]() { return up(); });
+  }
+
+  void Link::reconnect()
+  {
+    lost();
+  }
+
+  void Link::lost()
+  {
+    // Called from the control thread, so no lock for the check: the reconnect thread polls as a fallback
+    int expected = LINK_UP;
+    if (state_.compare_exchange_strong(expected, LINK_DOWN, std::memory_order_acq_rel))
+    {
+      std::string port;
+      {
+        // connect() may be changing the port from another thread
+        std::lock_guard<std::mutex> lock(mutex_);
+        port = port_;
+      }
+      CPR_ALOG(clearpath::Logger::ERROR_LEV, "Lost connection to Husky on %s", port);
+      cv_.notify_all();
+    }
+  }
+
+  bool Link::checkPort()
+  {
+    // Only the control thread acts on this, so the Transport is never reconfigured under it
+    if (up() && transport_->portFailed())
+    {
+      lost();
+      return true;
+    }
+    return false;
+  }
+
+  void Link::reportTimeout()
+  {
+    if (++consecutive_timeouts_ >= MAX_CONSECUTIVE_TIMEOUTS)
+    {
+      consecutive_timeouts_ = 0;
+      reconnect();
+    }
+  }
+
+  void Link::reportResponse()
+  {
+    consecutive_timeouts_ = 0;
+  }
+
+  void Link::setRestoreHook(int key, std::function<bool()> hook)
+  {
+    std::lock_guard<std::mutex> lock(hooks_mutex_);
+    hooks_[key] = hook;
+  }
+
+  void Link::clearRestoreHook(int key)
+  {
+    std::lock_guard<std::mutex> lock(hooks_mutex_);
+    hooks_.erase(key);
+  }
+
+  void Link::run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::chrono::milliseconds backoff = MIN_BACKOFF;
+    while (!stopping_)
+    {
+      if (state() != LINK_DOWN)
+      {
+        cv_.wait_for(lock, MAX_BACKOFF);
+        continue;
       }
+
+      state_.store(LINK_CONNECTING, std::memory_order_release);
+      std::string port = port_;
+      lock.unlock();
+      bool connected = tryConnect(port);
+      lock.lock();
+
+      if (connected)
+      {
+        backoff = MIN_BACKOFF;
+        // Tickets from before the reconnect were all timed out by Transport::close()
+        speed_ticket_ = 0;
+        consecutive_timeouts_ = 0;
+        state_.store(LINK_UP, std::memory_order_release);
+        cv_.notify_all();
+        continue;
+      }
+
+      state_.store(LINK_DOWN, std::memory_order_release);
+      cv_.wait_for(lock, backoff, [this]() { return stopping_; });
+      backoff = std::min(backoff * 2, MAX_BACKOFF);
     }
   }
 
-  void controlSpeed(double speed_left, double speed_right, double accel_left, double accel_right)
+  bool Link::tryConnect(const std::string &port)
   {
-    bool success = false;
-    while (!success)
+    try
     {
-      try
+      CPR_ALOG(clearpath::Logger::INFO, "Connecting to Husky on port %s...", port);
+      clearpath::Transport &transport = *transport_;
+      transport.configure(port.c_str(), retries_);
+
+      // An echo has no payload to build, so it is the quickest answer the MCU can give
+      clearpath::Message *probe = 0;
+      enum clearpath::transferResult result =
+        clearpath::Request(clearpath::MessageTraits<clearpath::DataEcho>::request, 0).trySend(transport);
+      if (result == clearpath::TRANSFER_OK)
       {
-        clearpath::SetDifferentialSpeed(speed_left, speed_right, accel_left, accel_right).send();
-        success = true;
+        result = transport.tryWaitNext(clearpath::MessageTraits<clearpath::DataEcho>::type, PROBE_TIMEOUT, &probe);
       }
-      catch (clearpath::Exception *ex)
+      if (result != clearpath::TRANSFER_OK)
       {
-        std::cout << "Error sending speed and accel command: " << ex->message;
+        CPR_ALOG_THROTTLE(clearpath::Logger::WARNING, 5.0, "No response from Husky: %s",
+                          clearpath::transferResultString(result));
+        return false;
+      }
+      delete probe;
+
+      std::map<int, std::function<bool()>> hooks;
+      {
+        std::lock_guard<std::mutex> lock(hooks_mutex_);
+        hooks = hooks_;
+      }
+      for (auto &hook : hooks)
+      {
+        if (!hook.second())
+        {
+          CPR_ALOG(clearpath::Logger::ERROR_LEV, "Could not restore settings after reconnecting");
+          return false;
+        }
+      }
+
+      const SerialProfile &settings = transport.serialSettings();
+      CPR_ALOG(clearpath::Logger::INFO, "Connected at %d baud, low latency %s, VMIN %d, VTIME %d",
+               settings.baud, settings.low_latency ? "on" : "off", settings.vmin, settings.vtime);
+      if (settings.latency_timer_ms > 1)
+      {
+        // Replies sit in the adapter for up to this long before being sent over USB
+        CPR_ALOG(clearpath::Logger::WARNING, "USB-serial latency timer is %d ms, set it to 1 for faster round trips",
+                 settings.latency_timer_ms);
+      }
+      else if (settings.latency_timer_ms >= 0)
+      {
+        CPR_ALOG(clearpath::Logger::INFO, "USB-serial latency timer is %d ms", settings.latency_timer_ms);
+      }
+      return true;
+    }
+    catch (clearpath::Exception *ex)
+    {
+      // Only Transport::configure() still throws, when the port can't be opened
+      CPR_ALOG_THROTTLE(clearpath::Logger::WARNING, 5.0, "Error connecting to Husky: %s", ex->message);
+      delete ex;
+      return false;
+    }
+  }
+
+  bool Link::checkResult(enum clearpath::transferResult result, uint16_t ack_code, const char *what)
+  {
+    if (result != clearpath::TRANSFER_OK && checkPort())
+    {
+      return false;
+    }
+    switch (result)
+    {
+      case clearpath::TRANSFER_OK:
+        reportResponse();
+        return true;
+
+      case clearpath::TRANSFER_TIMED_OUT:
+        reportTimeout();
+        return false;
+
+      case clearpath::TRANSFER_BAD_ACK:
+        // The MCU is there, it just didn't like the message
+        reportResponse();
+        CPR_ALOG_THROTTLE(clearpath::Logger::WARNING, 1.0, "%s%s 0x%x", what, clearpath::transferResultString(result),
+                          ack_code);
+        return false;
+
+      case clearpath::TRANSFER_TOO_LONG:
+        CPR_ALOG_THROTTLE(clearpath::Logger::ERROR_LEV, 1.0, "%s%s", what, clearpath::transferResultString(result));
+        return false;
+
+      default:
+        CPR_ALOG_THROTTLE(clearpath::Logger::ERROR_LEV, 1.0, "%s%s", what, clearpath::transferResultString(result));
         reconnect();
+        return false;
+    }
+  }
+
+  void Link::rememberLimits(double max_speed, double max_accel)
+  {
+    clearpath::Transport *transport = transport_;
+    setRestoreHook(LIMITS_HOOK, [transport, max_speed, max_accel]()
+      {
+        return sendLimits(*transport, max_speed, max_accel, 0) == clearpath::TRANSFER_OK;
+      });
+  }
+
+  void Link::configureLimits(double max_speed, double max_accel)
+  {
+    rememberLimits(max_speed, max_accel);
+    if (!up())
+    {
+      return;
+    }
+
+    // On failure the restore hook sets them again once the link is back
+    uint16_t ack_code = 0;
+    checkResult(sendLimits(*transport_, max_speed, max_accel, &ack_code), ack_code,
+                "Error configuring velocity and accel limits: ");
+  }
+
+  Handshake Link::handshake(const std::string &port, bool rx_thread, double max_speed, double max_accel,
+                            bool identify, double timeout)
+  {
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+    const clock::time_point deadline =
+      start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timeout));
+    const clock::duration slice = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(PROBE_TIMEOUT));
+
+    Handshake result;
+    result.ok = false;
+    result.step = "connect";
+    bool connected = connect(port, rx_thread, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - start));
+    // After connecting, so an MCU which answers now gets its limits only once, from the batch below
+    rememberLimits(max_speed, max_accel);
+    if (!connected)
+    {
+      result.elapsed = clock::now() - start;
+      return result;
+    }
+
+    // Can't throw from here on, the link is up so the Transport is configured
+    clearpath::Transport &transport = *transport_;
+    unsigned long firmware_ticket = 0;
+    unsigned long platform_ticket = 0;
+    if (identify)
+    {
+      // Sent ahead of the batch and never waited on, so an MCU which rejects them still starts up
+      transport.flush(clearpath::MessageTraits<clearpath::DataFirmwareInfo>::type);
+      transport.flush(clearpath::MessageTraits<clearpath::DataPlatformInfo>::type);
+      clearpath::Request firmware(clearpath::MessageTraits<clearpath::DataFirmwareInfo>::request, 0);
+      clearpath::Request platform(clearpath::MessageTraits<clearpath::DataPlatformInfo>::request, 0);
+      transport.trySendAsync(&firmware, false, &firmware_ticket);
+      transport.trySendAsync(&platform, false, &platform_ticket);
+    }
+
+    result.step = "limits";
+    transport.flush(clearpath::MessageTraits<clearpath::DataEncoders>::type);
+    clearpath::SetMaxAccel accel(max_accel, max_accel);
+    clearpath::SetMaxSpeed speed(max_speed, max_speed);
+    clearpath::Request encoders(clearpath::MessageTraits<clearpath::DataEncoders>::request, 0);
+    clearpath::Message *batch[] = {&accel, &speed, &encoders};
+    uint16_t ack_code = 0;
+    if (!checkResult(transport.trySendBatch(batch, sizeof(batch) / sizeof(batch[0]), deadline, &ack_code), ack_code,
+                     "Error configuring velocity and accel limits: "))
+    {
+      result.elapsed = clock::now() - start;
+      return result;
+    }
+
+    result.step = "encoder data";
+    // Woken at least every slice, so unacked identify requests get retransmitted
+    while (up())
+    {
+      if (!result.encoders)
+      {
+        result.encoders = Channel<clearpath::DataEncoders>::popLatest(*this);
+      }
+      if (!result.firmware && firmware_ticket)
+      {
+        result.firmware = Channel<clearpath::DataFirmwareInfo>::popLatest(*this);
+      }
+      if (!result.platform && platform_ticket)
+      {
+        result.platform = Channel<clearpath::DataPlatformInfo>::popLatest(*this);
+      }
+
+      bool waiting = !result.encoders ||
+        (!result.firmware && stillExpected(transport, firmware_ticket)) ||
+        (!result.platform && stillExpected(transport, platform_ticket));
+      if (!waiting)
+      {
+        break;
+      }
+      if (!transport.waitForInput(std::min(deadline, clock::now() + slice)) && clock::now() >= deadline)
+      {
+        break;
       }
     }
+
+    result.ok = static_cast<bool>(result.encoders);
+    if (result.ok)
+    {
+      reportResponse();
+      result.step = "";
+    }
+    else if (up())
+    {
+      reportTimeout();
+    }
+    result.elapsed = clock::now() - start;
+    return result;
+  }
+
+  bool Link::controlSpeed(double speed_left, double speed_right, double accel_left, double accel_right, bool async)
+  {
+    if (!up())
+    {
+      return false;
+    }
+
+    clearpath::SetDifferentialSpeed cmd(speed_left, speed_right, accel_left, accel_right);
+    uint16_t ack_code = 0;
+    enum clearpath::transferResult result;
+    if (async)
+    {
+      if (transport_->getSendStatus(speed_ticket_) == clearpath::Transport::SEND_TIMED_OUT)
+      {
+        speed_ticket_ = 0;
+        CPR_ALOG(clearpath::Logger::ERROR_LEV, "Speed command was never acknowledged");
+        reconnect();
+        return false;
+      }
+      result = transport_->trySendAsync(&cmd, true, &speed_ticket_);
+    }
+    else
+    {
+      result = cmd.trySend(*transport_, &ack_code);
+    }
+    return checkResult(result, ack_code, "Error sending speed and accel command: ");
+  }
+
+  bool connect(std::string port, bool rx_thread)
+  {
+    return Link::instance().connect(port, rx_thread);
+  }
+
+  void reconnect()
+  {
+    Link::instance().reconnect();
+  }
+
+  LinkState linkState()
+  {
+    return Link::instance().state();
+  }
+
+  bool linkUp()
+  {
+    return Link::instance().up();
+  }
+
+  void reportTimeout()
+  {
+    Link::instance().reportTimeout();
+  }
+
+  void reportResponse()
+  {
+    Link::instance().reportResponse();
+  }
+
+  void setRestoreHook(int key, std::function<bool()> hook)
+  {
+    Link::instance().setRestoreHook(key, hook);
+  }
+
+  void clearRestoreHook(int key)
+  {
+    Link::instance().clearRestoreHook(key);
+  }
+
+  clearpath::LatencyHistogram &requestLatency()
+  {
+    return Link::instance().requestLatency();
+  }
+
+  namespace detail
+  {
+    bool checkResult(enum clearpath::transferResult result, uint16_t ack_code, const char *what)
+    {
+      return Link::instance().checkResult(result, ack_code, what);
+    }
+  } // namespace detail
+
+  void configureLimits(double max_speed, double max_accel)
+  {
+    Link::instance().configureLimits(max_speed, max_accel);
+  }
+
+  bool controlSpeed(double speed_left, double speed_right, double accel_left, double accel_right, bool async)
+  {
+    return Link::instance().controlSpeed(speed_left, speed_right, accel_left, accel_right, async);
   }
 
 }
@@ -31,6 +31,11 @@
 
 #include "husky_base/husky_diagnostics.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
 namespace
 {
   const int UNDERVOLT_ERROR = 18;
@@ -52,6 +57,9 @@ namespace
   const unsigned int SAFETY_CURRENT = 0x40;
   const unsigned int SAFETY_WARN = (SAFETY_TIMEOUT | SAFETY_CCI | SAFETY_PSU);
   const unsigned int SAFETY_ERROR = (SAFETY_LOCKOUT | SAFETY_ESTOP | SAFETY_CURRENT);
+  // Bytes on the wire for one SetDifferentialSpeed (four 16 bit fields) and for its ack
+  const double SPEED_COMMAND_LEN = clearpath::Message::MIN_MSG_LENGTH + 8;
+  const double SPEED_ACK_LEN = clearpath::Message::MIN_MSG_LENGTH + 2;
 }  // namespace
 
 
@@ -59,10 +67,11 @@ namespace husky_base
 {
 
   template<>
-  HuskyHardwareDiagnosticTask<clearpath::DataSystemStatus>::HuskyHardwareDiagnosticTask(husky_msgs::HuskyStatus &msg)
+  HuskyHardwareDiagnosticTask<clearpath::DataSystemStatus>::HuskyHardwareDiagnosticTask(
+    const StatusCache &cache)
     :
     DiagnosticTask("system_status"),
-    msg_(msg)
+    cache_(cache)
   { }
 
   template<>
@@ -100,55 +109,56 @@ namespace husky_base
     stat.add("Left Motor Temp (C)", msg_.left_motor_temp);
     stat.add("Right Motor Temp (C)", msg_.right_motor_temp);
 
-    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "System Status OK");
+    stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "System Status OK");
     if (msg_.battery_voltage > OVERVOLT_ERROR)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::ERROR, "Main battery voltage too high");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Main battery voltage too high");
     }
     else if (msg_.battery_voltage > OVERVOLT_WARN)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Main battery voltage too high");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Main battery voltage too high");
     }
     else if (msg_.battery_voltage < UNDERVOLT_ERROR)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::ERROR, "Main battery voltage too low");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Main battery voltage too low");
     }
     else if (msg_.battery_voltage < UNDERVOLT_WARN)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Main battery voltage too low");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Main battery voltage too low");
     }
     else
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::OK, "Voltage OK");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Voltage OK");
     }
 
     if (std::max(msg_.left_driver_temp, msg_.right_driver_temp) > DRIVER_OVERTEMP_ERROR)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::ERROR, "Motor drivers too hot");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Motor drivers too hot");
     }
     else if (std::max(msg_.left_driver_temp, msg_.right_driver_temp) > DRIVER_OVERTEMP_WARN)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Motor drivers too hot");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Motor drivers too hot");
     }
     else if (std::max(msg_.left_motor_temp, msg_.right_motor_temp) > MOTOR_OVERTEMP_ERROR)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::ERROR, "Motors too hot");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Motors too hot");
     }
     else if (std::max(msg_.left_motor_temp, msg_.right_motor_temp) > MOTOR_OVERTEMP_WARN)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Motors too hot");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Motors too hot");
     }
     else
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::OK, "Temperature OK");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Temperature OK");
     }
   }
 
   template<>
-  HuskyHardwareDiagnosticTask<clearpath::DataPowerSystem>::HuskyHardwareDiagnosticTask(husky_msgs::HuskyStatus &msg)
+  HuskyHardwareDiagnosticTask<clearpath::DataPowerSystem>::HuskyHardwareDiagnosticTask(
+    const StatusCache &cache)
     :
     DiagnosticTask("power_status"),
-    msg_(msg)
+    cache_(cache)
   { }
 
   template<>
@@ -162,27 +172,27 @@ namespace husky_base
     stat.add("Charge (%)", msg_.charge_estimate);
     stat.add("Battery Capacity (Wh)", msg_.capacity_estimate);
 
-    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Power System OK");
+    stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Power System OK");
     if (msg_.charge_estimate < LOWPOWER_ERROR)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::ERROR, "Low power");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Low power");
     }
     else if (msg_.charge_estimate < LOWPOWER_WARN)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Low power");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Low power");
     }
     else
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::OK, "Charge OK");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Charge OK");
     }
   }
 
   template<>
   HuskyHardwareDiagnosticTask<clearpath::DataSafetySystemStatus>::HuskyHardwareDiagnosticTask(
-    husky_msgs::HuskyStatus &msg)
+    const StatusCache &cache)
     :
     DiagnosticTask("safety_status"),
-    msg_(msg)
+    cache_(cache)
   { }
 
   template<>
@@ -205,53 +215,174 @@ namespace husky_base
     stat.add("No battery", static_cast<bool>(msg_.no_battery));
     stat.add("Current limit", static_cast<bool>(msg_.current_limit));
 
-    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Safety System OK");
+    stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Safety System OK");
     if ((flags & SAFETY_ERROR) > 0)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::ERROR, "Safety System Error");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Safety System Error");
     }
     else if ((flags & SAFETY_WARN) > 0)
     {
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Safety System Warning");
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Safety System Warning");
     }
   }
 
-  HuskySoftwareDiagnosticTask::HuskySoftwareDiagnosticTask(husky_msgs::HuskyStatus &msg, double target_control_freq)
+  HuskySoftwareDiagnosticTask::HuskySoftwareDiagnosticTask(double target_control_freq)
     :
     DiagnosticTask("software_status"),
-    msg_(msg),
+    control_freq_(std::numeric_limits<double>::infinity()),
     target_control_freq_(target_control_freq)
-  {
-    reset();
-  }
+  { }
 
   void HuskySoftwareDiagnosticTask::updateControlFrequency(double frequency)
   {
     // Keep minimum observed frequency for diagnostics purposes
-    control_freq_ = std::min(control_freq_, frequency);
+    double seen = control_freq_.load(std::memory_order_relaxed);
+    while (frequency < seen && !control_freq_.compare_exchange_weak(seen, frequency, std::memory_order_relaxed))
+    {
+    }
   }
 
   void HuskySoftwareDiagnosticTask::run(diagnostic_updater::DiagnosticStatusWrapper &stat)
   {
-    msg_.ros_control_loop_freq = control_freq_;
-    stat.add("ROS Control Loop Frequency", msg_.ros_control_loop_freq);
+    double control_freq = control_freq_.exchange(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+    if (std::isinf(control_freq))
+    {
+      stat.summary(diagnostic_msgs::msg::DiagnosticStatus::STALE, "Control loop not running");
+      return;
+    }
+    stat.add("ROS Control Loop Frequency", control_freq);
 
-    double margin = control_freq_ / target_control_freq_ * 100;
+    double margin = control_freq / target_control_freq_ * 100;
 
-    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Software OK");
+    stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Software OK");
     if (margin < CONTROLFREQ_WARN)
     {
       std::ostringstream message;
       message << "Control loop executing " << 100 - static_cast<int>(margin) << "% slower than desired";
-      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, message.str());
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, message.str());
+    }
+  }
+
+  HuskyLinkDiagnosticTask::HuskyLinkDiagnosticTask(
+    horizon_legacy::Link &link, clearpath::LatencyHistogram &read_latency, clearpath::LatencyHistogram &write_latency,
+    const CommandShaper &shaper, double request_warn)
+    :
+    DiagnosticTask("serial_link"),
+    link_(link),
+    read_latency_(read_latency),
+    write_latency_(write_latency),
+    shaper_(shaper),
+    request_warn_us_(request_warn * 1e6),
+    last_commands_sent_(shaper.sentCount()),
+    last_commands_skipped_(shaper.skippedCount()),
+    last_run_(std::chrono::steady_clock::now())
+  {
+    for (int i = 0; i < clearpath::Transport::NUM_COUNTERS; ++i)
+    {
+      last_counters_[i] = link_.transport().getCounter(
+        static_cast<enum clearpath::Transport::counterTypes>(i));
     }
+  }
 
-    reset();
+  unsigned long HuskyLinkDiagnosticTask::counterDelta(enum clearpath::Transport::counterTypes counter)
+  {
+    unsigned long now = link_.transport().getCounter(counter);
+    // Counters start over when the port is reopened
+    unsigned long delta = now >= last_counters_[counter] ? now - last_counters_[counter] : now;
+    last_counters_[counter] = now;
+    return delta;
   }
 
-  void HuskySoftwareDiagnosticTask::reset()
+  void HuskyLinkDiagnosticTask::run(diagnostic_updater::DiagnosticStatusWrapper &stat)
   {
-    control_freq_ = std::numeric_limits<double>::infinity();
-    target_control_freq_ = 0;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_run_).count();
+    last_run_ = now;
+    if (elapsed <= 0.0)
+    {
+      elapsed = 1.0;
+    }
+
+    clearpath::LatencyHistogram::Snapshot read, write, request, ack, arrival;
+    read_latency_.collect(read);
+    write_latency_.collect(write);
+    link_.requestLatency().collect(request);
+    link_.transport().ackLatency().collect(ack);
+    link_.transport().clockSync().linkLatency().collect(arrival);
+
+    const clearpath::LatencyHistogram::Snapshot *stages[] = {&read, &write, &request, &ack, &arrival};
+    const char *stage_names[] = {
+      "read() (us)", "write() (us)", "Request round trip (us)", "Ack wait (us)", "Data latency (us)"};
+    for (size_t i = 0; i < 5; ++i)
+    {
+      stat.addf(stage_names[i], "p50 %.0f, p99 %.0f, max %llu, n %llu",
+                stages[i]->percentile(0.5), stages[i]->percentile(0.99),
+                static_cast<unsigned long long>(stages[i]->max_us),
+                static_cast<unsigned long long>(stages[i]->count()));
+    }
+
+    clearpath::ClockSync::Estimate clock = link_.transport().clockSync().estimate();
+    if (clock.synced)
+    {
+      stat.addf("MCU clock", "offset %.6f s, drift %.1f ppm, path delay %.0f us, %lu resets",
+                clock.offset, clock.drift * 1e6, clock.path_delay * 1e6, clock.resets);
+    }
+    else
+    {
+      stat.addf("MCU clock", "not synced, %lu samples", clock.samples);
+    }
+
+    clearpath::RttEstimator::Estimate rtt = link_.transport().rttEstimator().estimate();
+    if (rtt.adaptive)
+    {
+      stat.addf("Ack timeout", "%.1f ms, SRTT %.1f ms, RTTVAR %.1f ms, %lu samples, %lu timeouts",
+                rtt.timeout * 1e3, rtt.srtt * 1e3, rtt.rttvar * 1e3, rtt.samples, rtt.timeouts);
+    }
+    else
+    {
+      stat.addf("Ack timeout", "%.1f ms fixed, %lu timeouts", rtt.timeout * 1e3, rtt.timeouts);
+    }
+
+    stat.addf("Received", "%.0f B/s, %.1f frames/s",
+              counterDelta(clearpath::Transport::RX_BYTES) / elapsed,
+              counterDelta(clearpath::Transport::RX_FRAMES) / elapsed);
+    stat.addf("Sent", "%.0f B/s, %.1f frames/s",
+              counterDelta(clearpath::Transport::TX_BYTES) / elapsed,
+              counterDelta(clearpath::Transport::TX_FRAMES) / elapsed);
+
+    // Each held back command saves its frame out and the ack back
+    unsigned long commands_sent = shaper_.sentCount(), commands_skipped = shaper_.skippedCount();
+    unsigned long skipped = commands_skipped - last_commands_skipped_;
+    stat.addf("Speed commands", "%.1f sent/s, %.1f held back/s, %.0f B/s saved",
+              (commands_sent - last_commands_sent_) / elapsed, skipped / elapsed,
+              skipped * (SPEED_COMMAND_LEN + SPEED_ACK_LEN) / elapsed);
+    last_commands_sent_ = commands_sent;
+    last_commands_skipped_ = commands_skipped;
+
+    unsigned long retransmits = counterDelta(clearpath::Transport::RETRANSMITS);
+    unsigned long unacked = counterDelta(clearpath::Transport::ASYNC_UNACKED);
+    unsigned long invalid = counterDelta(clearpath::Transport::INVALID_MSG);
+    unsigned long garbled = counterDelta(clearpath::Transport::GARBLE_BYTES);
+    unsigned long overflows = counterDelta(clearpath::Transport::QUEUE_FULL);
+    counterDelta(clearpath::Transport::IGNORED_ACK);
+    stat.add("Retransmits", retransmits);
+    stat.add("Unacknowledged async sends", unacked);
+    stat.add("Invalid messages", invalid);
+    stat.add("Garbled bytes", garbled);
+    stat.add("Queue overflows", overflows);
+
+    stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Serial link OK");
+    if (!link_.up())
+    {
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Serial link down");
+    }
+    else if (retransmits || unacked || invalid || garbled)
+    {
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Serial link errors");
+    }
+    else if (request.percentile(0.99) > request_warn_us_)
+    {
+      stat.mergeSummary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Slow MCU responses");
+    }
   }
 }  // namespace husky_base
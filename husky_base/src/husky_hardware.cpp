@@ -36,9 +36,11 @@
 #include <cmath>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "husky_base/horizon_legacy/Logger.h"
 #include "rclcpp/rclcpp.hpp"
 
 namespace
@@ -67,6 +69,10 @@ namespace
   const unsigned int SAFETY_CURRENT = 0x40;
   const unsigned int SAFETY_WARN = (SAFETY_TIMEOUT | SAFETY_CCI | SAFETY_PSU);
   const unsigned int SAFETY_ERROR = (SAFETY_LOCKOUT | SAFETY_ESTOP | SAFETY_CURRENT);
+  // How often the status node checks for a newly posted status message
+  const double STATUS_PUBLISH_RATE = 10.0;
+  // Period of the /diagnostics updates
+  const double DIAGNOSTICS_PERIOD = 1.0;
 }  // namespace
 
 
@@ -75,6 +81,80 @@ namespace husky_base
   static const std::string HW_NAME = "HuskyHardware";
   static const std::string LEFT_CMD_JOINT_NAME = "front_left_wheel_joint";
   static const std::string RIGHT_CMD_JOINT_NAME = "front_right_wheel_joint";
+  // State interfaces of the hardware component itself, see export_state_interfaces()
+  static const std::string HW_IF_ENCODER_AGE = "encoder_age";
+  static const std::string HW_IF_SPEED_AGE = "speed_age";
+  static const std::string HW_IF_LINK_LATENCY = "link_latency";
+
+  /**
+  * Read an optional numeric hardware parameter, falling back to a default when it is not set
+  */
+  static double getOptionalParameter(
+    const hardware_interface::HardwareInfo &info, const std::string &name, double default_value)
+  {
+    auto it = info.hardware_parameters.find(name);
+    if (it == info.hardware_parameters.end() || it->second.empty())
+    {
+      return default_value;
+    }
+    return std::stod(it->second);
+  }
+
+  /**
+  * Hand clearpath::Logger output over to the ROS logger, on the Logger's drain thread
+  */
+  static void forwardLog(clearpath::Logger::logLevels level, const char *, int, const char *text)
+  {
+    switch (level)
+    {
+      case clearpath::Logger::ERROR_LEV:
+      case clearpath::Logger::EXCEPTION:
+        RCLCPP_ERROR(rclcpp::get_logger(HW_NAME), "%s", text);
+        break;
+      case clearpath::Logger::WARNING:
+        RCLCPP_WARN(rclcpp::get_logger(HW_NAME), "%s", text);
+        break;
+      case clearpath::Logger::INFO:
+        RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "%s", text);
+        break;
+      default:
+        RCLCPP_DEBUG(rclcpp::get_logger(HW_NAME), "%s", text);
+        break;
+    }
+  }
+
+  /**
+  * Route clearpath::Logger into the ROS logger. The Logger is process-wide and
+  * shared by every HuskyHardware instance, so only the first configure() sets it up.
+  */
+  static void setUpLogger()
+  {
+    static std::once_flag once;
+    std::call_once(once, []()
+      {
+        // Driver logging from the control thread only queues a record, the drain thread formats it
+        clearpath::Logger &logger = clearpath::Logger::instance();
+        logger.setSink(forwardLog);
+        logger.setLevel(
+          rcutils_logging_logger_is_enabled_for(HW_NAME.c_str(), RCUTILS_LOG_SEVERITY_DEBUG) ?
+          clearpath::Logger::DETAIL : clearpath::Logger::INFO);
+        logger.setAsync(true);
+      });
+  }
+
+  /**
+  * Read an optional boolean hardware parameter ("true"/"false" or "1"/"0")
+  */
+  static bool getOptionalFlag(
+    const hardware_interface::HardwareInfo &info, const std::string &name, bool default_value)
+  {
+    auto it = info.hardware_parameters.find(name);
+    if (it == info.hardware_parameters.end() || it->second.empty())
+    {
+      return default_value;
+    }
+    return it->second == "true" || it->second == "True" || it->second == "1";
+  }
 
   /**
   * Get current encoder travel offsets from MCU and bias future encoder readings against them
@@ -82,13 +162,10 @@ namespace husky_base
   void HuskyHardware::resetTravelOffset()
   {
     horizon_legacy::Channel<clearpath::DataEncoders>::Ptr enc =
-        horizon_legacy::Channel<clearpath::DataEncoders>::requestData(polling_timeout_);
+        horizon_legacy::Channel<clearpath::DataEncoders>::requestData(link_, polling_timeout_);
     if (enc)
     {
-      for (auto i = 0u; i < hw_states_position_offset_.size(); i++)
-      {
-        hw_states_position_offset_[i] = linearToAngular(enc->getTravel(isLeft(info_.joints[i].name)));
-      }
+      applyTravelOffset(*enc);
     }
     else
     {
@@ -97,6 +174,14 @@ namespace husky_base
     }
   }
 
+  void HuskyHardware::applyTravelOffset(clearpath::DataEncoders &enc)
+  {
+    for (auto i = 0u; i < hw_states_position_offset_.size(); i++)
+    {
+      hw_states_position_offset_[i] = linearToAngular(enc.getTravel(isLeft(info_.joints[i].name)));
+    }
+  }
+
   /**
   * Husky reports travel in metres, need radians for ros_control RobotHW
   */
@@ -120,7 +205,16 @@ namespace husky_base
 
     limitDifferentialSpeed(diff_speed_left, diff_speed_right);
 
-    horizon_legacy::controlSpeed(diff_speed_left, diff_speed_right, max_accel_, max_accel_);
+    auto now = CommandShaper::Clock::now();
+    if (!command_shaper_.shouldSend(diff_speed_left, diff_speed_right, now))
+    {
+      return;
+    }
+    // A command that didn't get through goes again on the next tick
+    if (link_.controlSpeed(diff_speed_left, diff_speed_right, max_accel_, max_accel_, async_commands_))
+    {
+      command_shaper_.sent(diff_speed_left, diff_speed_right, now);
+    }
   }
 
   void HuskyHardware::limitDifferentialSpeed(double &diff_speed_left, double &diff_speed_right)
@@ -138,82 +232,250 @@ namespace husky_base
   /**
   * Pull latest speed and travel measurements from MCU, and store in joint structure for ros_control
   */
-  void HuskyHardware::updateJointsFromHardware()
+  void HuskyHardware::updateJointsFromHardware(uint32_t groups)
   {
+    bool read_encoders = RateScheduler::includes(groups, RateScheduler::ENCODERS);
+    bool read_speeds = RateScheduler::includes(groups, RateScheduler::SPEEDS) &&
+      velocity_source_ == VELOCITY_DIFFERENTIAL_SPEED;
 
-    horizon_legacy::Channel<clearpath::DataEncoders>::Ptr enc =
-      horizon_legacy::Channel<clearpath::DataEncoders>::requestData(polling_timeout_);
-    if (enc)
+    if (streaming_frequency_ > 0)
     {
-      RCLCPP_DEBUG(
-        rclcpp::get_logger(HW_NAME),
-        "Received linear distance information (L: %f, R: %f)",
-        enc->getTravel(LEFT), enc->getTravel(RIGHT));
+      // Subscribed: only consume what has already been received, never block the control loop
+      horizon_legacy::Channel<clearpath::DataEncoders>::Ptr enc;
+      horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::Ptr speed;
+      if (read_encoders)
+      {
+        enc = horizon_legacy::Channel<clearpath::DataEncoders>::popLatest(link_);
+      }
+      if (read_speeds)
+      {
+        speed = horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::popLatest(link_);
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      if (enc || speed)
+      {
+        last_stream_sample_ = now;
+        stream_stalled_ = false;
+      }
+      else if (!stream_stalled_ &&
+        now - last_stream_sample_ > std::chrono::duration<double>(polling_timeout_))
+      {
+        stream_stalled_ = true;
+        CPR_ALOG(clearpath::Logger::ERROR_LEV, "No streamed encoder or speed data within polling timeout");
+      }
+
+      if (enc)
+      {
+        updateJointPositions(enc);
+      }
+      if (speed)
+      {
+        updateJointVelocities(speed);
+      }
+      return;
+    }
 
-      for (auto i = 0u; i < hw_states_position_.size(); i++)
+    if (read_encoders)
+    {
+      horizon_legacy::Channel<clearpath::DataEncoders>::Ptr enc =
+        horizon_legacy::Channel<clearpath::DataEncoders>::requestData(link_, polling_timeout_);
+      if (enc)
+      {
+        updateJointPositions(enc);
+      }
+      else
       {
-        double delta = linearToAngular(enc->getTravel(isLeft(info_.joints[i].name)))
-            - hw_states_position_[i] - hw_states_position_offset_[i];
+        CPR_ALOG_THROTTLE(clearpath::Logger::ERROR_LEV, 1.0, "Could not get encoder data");
+      }
+    }
 
-        // detect suspiciously large readings, possibly from encoder rollover
-        if (std::abs(delta) < 1.0f)
+    if (read_speeds)
+    {
+      horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::Ptr speed =
+        horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::requestData(link_, polling_timeout_);
+      if (speed)
+      {
+        updateJointVelocities(speed);
+      }
+      else
+      {
+        CPR_ALOG_THROTTLE(clearpath::Logger::ERROR_LEV, 1.0, "Could not get speed data");
+      }
+    }
+  }
+
+  void HuskyHardware::updateJointPositions(
+    const horizon_legacy::Channel<clearpath::DataEncoders>::Ptr &enc)
+  {
+    clearpath::EncoderSample sample;
+    enc->decode(sample);
+    encoder_stamp_ = stampSample(*enc);
+    double stamp = std::chrono::duration<double>(encoder_stamp_.time_since_epoch()).count();
+    bool use_speeds = velocity_source_ == VELOCITY_ENCODER_SPEED && sample.count > RIGHT;
+
+    CPR_ALOG(
+      clearpath::Logger::DETAIL, "Received linear distance information (L: %f, R: %f)",
+      sample.travel[LEFT], sample.travel[RIGHT]);
+
+    for (auto i = 0u; i < hw_states_position_.size(); i++)
+    {
+      double delta = linearToAngular(sample.travel[isLeft(info_.joints[i].name)])
+          - hw_states_position_[i] - hw_states_position_offset_[i];
+
+      // detect suspiciously large readings, possibly from encoder rollover
+      if (std::abs(delta) < 1.0f)
+      {
+        hw_states_position_[i] += delta;
+        if (use_speeds)
         {
-          hw_states_position_[i] += delta;
+          hw_states_velocity_[i] = linearToAngular(sample.speed[isLeft(info_.joints[i].name)]);
         }
-        else
+        else if (velocity_source_ != VELOCITY_DIFFERENTIAL_SPEED)
         {
-          // suspicious! drop this measurement and update the offset for subsequent readings
-          hw_states_position_offset_[i] += delta;
-          RCLCPP_WARN(
-            rclcpp::get_logger(HW_NAME),"Dropping overflow measurement from encoder");
+          hw_states_velocity_[i] = velocity_estimators_[i].update(hw_states_position_[i], stamp);
         }
       }
+      else
+      {
+        // suspicious! drop this measurement and update the offset for subsequent readings
+        hw_states_position_offset_[i] += delta;
+        CPR_ALOG_THROTTLE(clearpath::Logger::WARNING, 1.0, "Dropping overflow measurement from encoder");
+      }
     }
-    else
+  }
+
+  void HuskyHardware::updateJointVelocities(
+    const horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::Ptr &speed)
+  {
+    clearpath::DifferentialSpeedSample sample;
+    speed->decode(sample);
+    speed_stamp_ = stampSample(*speed);
+
+    CPR_ALOG(
+      clearpath::Logger::DETAIL, "Received linear speed information (L: %f, R: %f)",
+      sample.left_speed, sample.right_speed);
+
+    for (auto i = 0u; i < hw_states_velocity_.size(); i++)
     {
-      RCLCPP_ERROR(
-        rclcpp::get_logger(HW_NAME), "Could not get encoder data");
+      if (isLeft(info_.joints[i].name) == LEFT)
+      {
+        hw_states_velocity_[i] = linearToAngular(sample.left_speed);
+      }
+      else
+      { // assume RIGHT
+        hw_states_velocity_[i] = linearToAngular(sample.right_speed);
+      }
     }
+  }
 
-    horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::Ptr speed =
-      horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::requestData(polling_timeout_);
-    if (speed)
+  /**
+  * When the MCU took a sample, from its timestamp and the link's clock estimate; also
+  * records how long the sample took to reach us
+  */
+  std::chrono::steady_clock::time_point HuskyHardware::stampSample(clearpath::Message &msg)
+  {
+    std::chrono::steady_clock::time_point stamp = link_.transport().sampleTime(msg);
+    hw_link_latency_ = std::chrono::duration<double>(msg.getRxTime() - stamp).count();
+    return stamp;
+  }
+
+  /**
+  * Age the encoder and speed samples as of now, so controllers can date them
+  * against their own update time
+  */
+  void HuskyHardware::updateSampleAges()
+  {
+    auto now = std::chrono::steady_clock::now();
+    if (encoder_stamp_.time_since_epoch().count() != 0)
     {
-      RCLCPP_DEBUG(
-        rclcpp::get_logger(HW_NAME),
-        "Received linear speed information (L: %f, R: %f)",
-        speed->getLeftSpeed(), speed->getRightSpeed());
+      hw_encoder_age_ = std::chrono::duration<double>(now - encoder_stamp_).count();
+    }
+    if (speed_stamp_.time_since_epoch().count() != 0)
+    {
+      hw_speed_age_ = std::chrono::duration<double>(now - speed_stamp_).count();
+    }
+  }
 
-      for (auto i = 0u; i < hw_states_velocity_.size(); i++)
+  /**
+  * Take whatever IMU samples have streamed in since the last tick; never waits on the MCU.
+  */
+  void HuskyHardware::readImu()
+  {
+    if (imu_.uses(ImuState::ORIENTATION))
+    {
+      horizon_legacy::Channel<clearpath::DataPlatformOrientation>::Ptr orientation =
+        horizon_legacy::Channel<clearpath::DataPlatformOrientation>::popLatest(link_);
+      if (orientation)
       {
-        if (isLeft(info_.joints[i].name) == LEFT)
-        {
-          hw_states_velocity_[i] = linearToAngular(speed->getLeftSpeed());
-        }
-        else
-        { // assume RIGHT
-          hw_states_velocity_[i] = linearToAngular(speed->getRightSpeed());
-        }
+        imu_.setOrientation(orientation->getRoll(), orientation->getPitch(), orientation->getYaw());
       }
     }
-        else
+    if (imu_.uses(ImuState::ROTATION))
     {
-      RCLCPP_ERROR(
-        rclcpp::get_logger(HW_NAME), "Could not get speed data");
+      horizon_legacy::Channel<clearpath::DataPlatformRotation>::Ptr rotation =
+        horizon_legacy::Channel<clearpath::DataPlatformRotation>::popLatest(link_);
+      if (rotation)
+      {
+        imu_.setRotation(rotation->getRollRate(), rotation->getPitchRate(), rotation->getYawRate());
+      }
+    }
+    if (imu_.uses(ImuState::ACCELERATION))
+    {
+      horizon_legacy::Channel<clearpath::DataPlatformAcceleration>::Ptr accel =
+        horizon_legacy::Channel<clearpath::DataPlatformAcceleration>::popLatest(link_);
+      if (accel)
+      {
+        imu_.setAcceleration(accel->getX(), accel->getY(), accel->getZ());
+      }
+    }
+    if (imu_.uses(ImuState::MAGNETOMETER))
+    {
+      horizon_legacy::Channel<clearpath::DataPlatformMagnetometer>::Ptr mag =
+        horizon_legacy::Channel<clearpath::DataPlatformMagnetometer>::popLatest(link_);
+      if (mag)
+      {
+        imu_.setMagnetometer(mag->getX(), mag->getY(), mag->getZ());
+      }
     }
   }
 
   /**
-  * Pull latest status date from MCU.
+  * Pull latest status date from MCU, for the status groups the scheduler picked this tick.
   */
-  void HuskyHardware::readStatusFromHardware()
+  void HuskyHardware::readStatusFromHardware(uint32_t groups)
   {
+    if (RateScheduler::includes(groups, RateScheduler::SAFETY))
+    {
+      readSafetyStatus();
+    }
+    if (RateScheduler::includes(groups, RateScheduler::POWER))
+    {
+      readPowerStatus();
+    }
+    if (RateScheduler::includes(groups, RateScheduler::SYSTEM))
+    {
+      readSystemStatus();
+    }
+
+    // Published from the status node's own thread, read() must not wait on the middleware
+    status_node_->post_status(status_msg_);
+  }
 
+  void HuskyHardware::readSafetyStatus()
+  {
     auto safety_status =
-      horizon_legacy::Channel<clearpath::DataSafetySystemStatus>::requestData(polling_timeout_);
+      horizon_legacy::Channel<clearpath::DataSafetySystemStatus>::requestData(link_, polling_timeout_);
     if (safety_status)
     {
+      status_cache_.slot<clearpath::DataSafetySystemStatus>().store(safety_status, std::chrono::steady_clock::now());
       uint16_t flags = safety_status->getFlags();
+      if (flags != safety_flags_)
+      {
+        // E-stop, lockout or a command timeout; whatever the MCU does next, tell it what we want
+        command_shaper_.reset();
+        safety_flags_ = flags;
+      }
       status_msg_.timeout = (flags & SAFETY_TIMEOUT) > 0;
       status_msg_.lockout = (flags & SAFETY_LOCKOUT) > 0;
       status_msg_.e_stop = (flags & SAFETY_ESTOP) > 0;
@@ -223,52 +485,76 @@ namespace husky_base
     }
     else
     {
-      RCLCPP_ERROR(
-        rclcpp::get_logger(HW_NAME), "Could not get safety_status");
+      CPR_ALOG_THROTTLE(clearpath::Logger::ERROR_LEV, 1.0, "Could not get safety_status");
     }
+  }
 
+  void HuskyHardware::readPowerStatus()
+  {
     auto power_status =
-      horizon_legacy::Channel<clearpath::DataPowerSystem>::requestData(polling_timeout_);
+      horizon_legacy::Channel<clearpath::DataPowerSystem>::requestData(link_, polling_timeout_);
     if (power_status)
     {
-      status_msg_.charge_estimate = power_status->getChargeEstimate(0);
-      status_msg_.capacity_estimate = power_status->getCapacityEstimate(0);
+      status_cache_.slot<clearpath::DataPowerSystem>().store(power_status, std::chrono::steady_clock::now());
+      clearpath::PowerSystemSample power;
+      power_status->decode(power);
+      status_msg_.charge_estimate = power.charge_estimate[0];
+      status_msg_.capacity_estimate = power.capacity_estimate[0];
     }
     else
     {
-      RCLCPP_ERROR(
-        rclcpp::get_logger(HW_NAME), "Could not get power_status");
+      CPR_ALOG_THROTTLE(clearpath::Logger::ERROR_LEV, 1.0, "Could not get power_status");
     }
+  }
 
+  void HuskyHardware::readSystemStatus()
+  {
     auto system_status =
-      horizon_legacy::Channel<clearpath::DataSystemStatus>::requestData(polling_timeout_);
+      horizon_legacy::Channel<clearpath::DataSystemStatus>::requestData(link_, polling_timeout_);
     if (system_status)
     {
-      status_msg_.uptime = system_status->getUptime();
-
-      status_msg_.battery_voltage = system_status->getVoltage(0);
-      status_msg_.left_driver_voltage = system_status->getVoltage(1);
-      status_msg_.right_driver_voltage = system_status->getVoltage(2);
-
-      status_msg_.mcu_and_user_port_current = system_status->getCurrent(0);
-      status_msg_.left_driver_current = system_status->getCurrent(1);
-      status_msg_.right_driver_current = system_status->getCurrent(2);
-
-      status_msg_.left_driver_temp = system_status->getTemperature(0);
-      status_msg_.right_driver_temp = system_status->getTemperature(1);
-      status_msg_.left_motor_temp = system_status->getTemperature(2);
-      status_msg_.right_motor_temp = system_status->getTemperature(3);
+      status_cache_.slot<clearpath::DataSystemStatus>().store(system_status, std::chrono::steady_clock::now());
+      clearpath::SystemStatusSample system;
+      system_status->decode(system);
+      status_msg_.uptime = system.uptime;
+
+      status_msg_.battery_voltage = system.voltage[0];
+      status_msg_.left_driver_voltage = system.voltage[1];
+      status_msg_.right_driver_voltage = system.voltage[2];
+
+      status_msg_.mcu_and_user_port_current = system.current[0];
+      status_msg_.left_driver_current = system.current[1];
+      status_msg_.right_driver_current = system.current[2];
+
+      status_msg_.left_driver_temp = system.temperature[0];
+      status_msg_.right_driver_temp = system.temperature[1];
+      status_msg_.left_motor_temp = system.temperature[2];
+      status_msg_.right_motor_temp = system.temperature[3];
     }
     else
     {
-      RCLCPP_ERROR(
-        rclcpp::get_logger(HW_NAME), "Could not get system_status");
+      CPR_ALOG_THROTTLE(clearpath::Logger::ERROR_LEV, 1.0, "Could not get system_status");
     }
-
-    status_node_->publish_status(status_msg_);
   }
 
 
+  /**
+  * Log link outages and recoveries once each, return whether the link is usable
+  */
+  bool HuskyHardware::checkLink()
+  {
+    // The outage itself is logged by the Link, which knows the port
+    link_.checkPort();
+    bool up = link_.up();
+    if (up && link_down_reported_)
+    {
+      CPR_ALOG(clearpath::Logger::INFO, "Connection to Husky restored");
+      command_shaper_.reset();
+    }
+    link_down_reported_ = !up;
+    return up;
+  }
+
   /**
   * Determines if the joint is left or right based on the joint name
   */
@@ -298,21 +584,20 @@ hardware_interface::return_type HuskyHardware::configure(
   hw_states_position_offset_.resize(info_.joints.size(), std::numeric_limits<double>::quiet_NaN());
   hw_states_velocity_.resize(info_.joints.size(), std::numeric_limits<double>::quiet_NaN());
   hw_commands_.resize(info_.joints.size(), std::numeric_limits<double>::quiet_NaN());
+  hw_encoder_age_ = hw_speed_age_ = hw_link_latency_ = std::numeric_limits<double>::quiet_NaN();
 
   wheel_diameter_ = std::stod(info_.hardware_parameters["wheel_diameter"]);
   max_accel_ = std::stod(info_.hardware_parameters["max_accel"]);
   max_speed_ = std::stod(info_.hardware_parameters["max_speed"]);
   polling_timeout_ = std::stod(info_.hardware_parameters["polling_timeout"]);
-
-  serial_port_ = info_.hardware_parameters["serial_port"];
-
-  status_node_ = std::make_shared<husky_status::HuskyStatus>();
-
-  RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "Port: %s", serial_port_.c_str());
-  horizon_legacy::connect(serial_port_);
-  horizon_legacy::configureLimits(max_speed_, max_accel_);
-  resetTravelOffset();
-
+  streaming_frequency_ = getOptionalParameter(info_, "streaming_frequency", 0.0);
+  rx_thread_ = getOptionalFlag(info_, "rx_thread", false);
+  async_commands_ = getOptionalFlag(info_, "async_commands", false);
+  imu_rate_ = getOptionalParameter(info_, "imu_rate", 100.0);
+  startup_timeout_ = getOptionalParameter(info_, "startup_timeout", 5.0);
+  startup_identify_ = getOptionalFlag(info_, "startup_identify", false);
+
+  // Validate everything before bringing the link up, so a bad description leaves nothing running
   for (const hardware_interface::ComponentInfo & joint : info_.joints)
   {
     // HuskyHardware has exactly two states and one command interface on each joint
@@ -363,6 +648,246 @@ hardware_interface::return_type HuskyHardware::configure(
     }
   }
 
+  if (info_.sensors.size() > 1)
+  {
+    RCLCPP_FATAL(
+      rclcpp::get_logger(HW_NAME), "%zu sensors found, at most one (the IMU) expected.",
+      info_.sensors.size());
+    return hardware_interface::return_type::ERROR;
+  }
+  for (const hardware_interface::ComponentInfo & sensor : info_.sensors)
+  {
+    for (const hardware_interface::InterfaceInfo & state : sensor.state_interfaces)
+    {
+      if (!imu_.addInterface(state.name))
+      {
+        RCLCPP_FATAL(
+          rclcpp::get_logger(HW_NAME), "Sensor '%s' has unknown state interface '%s'.",
+          sensor.name.c_str(), state.name.c_str());
+        return hardware_interface::return_type::ERROR;
+      }
+    }
+  }
+  if (!imu_.empty() && imu_rate_ <= 0)
+  {
+    RCLCPP_FATAL(
+      rclcpp::get_logger(HW_NAME), "Sensor '%s' needs a positive imu_rate.", info_.sensors[0].name.c_str());
+    return hardware_interface::return_type::ERROR;
+  }
+
+  auto source = info_.hardware_parameters.find("velocity_source");
+  std::string velocity_source =
+    source == info_.hardware_parameters.end() ? std::string() : source->second;
+  if (velocity_source == "encoder_speed")
+  {
+    velocity_source_ = VELOCITY_ENCODER_SPEED;
+  }
+  else if (velocity_source == "encoder_travel")
+  {
+    velocity_source_ = VELOCITY_ENCODER_TRAVEL;
+  }
+  else
+  {
+    if (!velocity_source.empty() && velocity_source != "differential_speed")
+    {
+      RCLCPP_WARN(
+        rclcpp::get_logger(HW_NAME), "Unknown velocity_source '%s', using 'differential_speed'",
+        velocity_source.c_str());
+    }
+    velocity_source_ = VELOCITY_DIFFERENTIAL_SPEED;
+  }
+
+  // Used for encoder_travel, and for encoder_speed if the MCU leaves the speeds out
+  auto filter = info_.hardware_parameters.find("velocity_filter");
+  bool alpha_beta = filter != info_.hardware_parameters.end() && filter->second == "alpha_beta";
+  VelocityEstimator estimator;
+  estimator.configure(
+    alpha_beta ? VelocityEstimator::ALPHA_BETA : VelocityEstimator::FINITE_DIFFERENCE,
+    static_cast<size_t>(getOptionalParameter(info_, "velocity_window", 4)),
+    getOptionalParameter(info_, "velocity_alpha", 0.5),
+    getOptionalParameter(info_, "velocity_beta", 0.1));
+  velocity_estimators_.assign(info_.joints.size(), estimator);
+  control_frequency_ = getOptionalParameter(info_, "control_frequency", 10.0);
+
+  // Unchanged speed commands are only repeated every command_keepalive seconds, 0 sends every tick
+  command_shaper_.configure(
+    getOptionalParameter(info_, "command_tolerance", 0.0),
+    getOptionalParameter(info_, "command_keepalive", 0.0));
+  safety_flags_ = 0;
+
+  // Per group read rates in hz, 0 reads the group on every tick
+  read_scheduler_.setRate(
+    RateScheduler::ENCODERS, getOptionalParameter(info_, "encoders_rate", 0.0), false);
+  read_scheduler_.setRate(
+    RateScheduler::SPEEDS, getOptionalParameter(info_, "speeds_rate", 0.0), false);
+  read_scheduler_.setRate(
+    RateScheduler::SAFETY, getOptionalParameter(info_, "safety_status_rate", 1.0), true);
+  read_scheduler_.setRate(
+    RateScheduler::POWER, getOptionalParameter(info_, "power_status_rate", 1.0), true);
+  read_scheduler_.setRate(
+    RateScheduler::SYSTEM, getOptionalParameter(info_, "system_status_rate", 1.0), true);
+
+  serial_port_ = info_.hardware_parameters["serial_port"];
+
+  // Serial profile, taken up by every (re)connect
+  SerialProfile profile;
+  DefaultSerialProfile(&profile);
+  profile.baud = static_cast<int>(getOptionalParameter(info_, "serial_baud", profile.baud));
+  profile.low_latency = getOptionalFlag(info_, "serial_low_latency", true);
+  profile.vmin = static_cast<int>(getOptionalParameter(info_, "serial_vmin", profile.vmin));
+  profile.vtime = static_cast<int>(getOptionalParameter(info_, "serial_vtime", profile.vtime));
+  link_.transport().setSerialProfile(profile);
+
+  auto wakeup = info_.hardware_parameters.find("rx_wakeup");
+  bool spin = wakeup != info_.hardware_parameters.end() && wakeup->second == "spin";
+  if (wakeup != info_.hardware_parameters.end() && !spin && wakeup->second != "poll" && !wakeup->second.empty())
+  {
+    RCLCPP_WARN(
+      rclcpp::get_logger(HW_NAME), "Unknown rx_wakeup '%s', using 'poll'", wakeup->second.c_str());
+  }
+  link_.transport().setRxThreadOptions(
+    static_cast<int>(getOptionalParameter(info_, "rx_cpu", -1)),
+    spin ? clearpath::Transport::RX_WAKE_SPIN : clearpath::Transport::RX_WAKE_POLL);
+  RCLCPP_INFO(
+    rclcpp::get_logger(HW_NAME), "Serial profile: %d baud, low latency %s, RX thread %s wake-up, CPU %d",
+    profile.baud, profile.low_latency ? "requested" : "off", spin ? "spin" : "poll",
+    static_cast<int>(getOptionalParameter(info_, "rx_cpu", -1)));
+
+  // Ack timeouts, fixed or adapting to the measured round trip; the data waits
+  // of requests follow them, but never exceed polling_timeout
+  bool adaptive_timeouts = getOptionalFlag(info_, "adaptive_timeouts", false);
+  double ack_timeout_min = getOptionalParameter(info_, "ack_timeout_min", 0.01);
+  double ack_timeout_max = getOptionalParameter(info_, "ack_timeout_max", 0.2);
+  int ack_retries = static_cast<int>(getOptionalParameter(info_, "ack_retries", 3));
+  link_.transport().rttEstimator().configure(adaptive_timeouts, ack_timeout_min, ack_timeout_max);
+  link_.setRetries(ack_retries);
+  if (adaptive_timeouts)
+  {
+    RCLCPP_INFO(
+      rclcpp::get_logger(HW_NAME), "Adaptive ack timeouts between %.3f and %.3f s, %d retries",
+      ack_timeout_min, ack_timeout_max, ack_retries);
+  }
+
+  // Raw link traffic for offline replay with husky_capture_replay
+  auto capture = info_.hardware_parameters.find("capture_file");
+  if (capture != info_.hardware_parameters.end() && !capture->second.empty())
+  {
+    if (link_.transport().startCapture(capture->second.c_str()))
+    {
+      RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "Capturing serial traffic to %s", capture->second.c_str());
+    }
+    else
+    {
+      RCLCPP_WARN(
+        rclcpp::get_logger(HW_NAME), "Could not open capture file %s", capture->second.c_str());
+    }
+  }
+
+  setUpLogger();
+
+  status_node_ = std::make_shared<husky_status::HuskyStatus>();
+
+  // Tasks run on the status node's executor thread, off the control loop
+  software_task_ = std::make_unique<HuskySoftwareDiagnosticTask>(control_frequency_);
+  link_task_ = std::make_unique<HuskyLinkDiagnosticTask>(
+    link_, read_latency_, write_latency_, command_shaper_, polling_timeout_ / 2);
+  diagnostic_updater_ = std::make_shared<diagnostic_updater::Updater>(status_node_, DIAGNOSTICS_PERIOD);
+  diagnostic_updater_->setHardwareID("Husky");
+  diagnostic_updater_->add(*software_task_);
+  diagnostic_updater_->add(*link_task_);
+  // The status tasks report from the samples read() caches, they never touch the serial link
+  safety_task_ = std::make_unique<HuskyHardwareDiagnosticTask<clearpath::DataSafetySystemStatus>>(status_cache_);
+  power_task_ = std::make_unique<HuskyHardwareDiagnosticTask<clearpath::DataPowerSystem>>(status_cache_);
+  system_task_ = std::make_unique<HuskyHardwareDiagnosticTask<clearpath::DataSystemStatus>>(status_cache_);
+  diagnostic_updater_->add(*safety_task_);
+  diagnostic_updater_->add(*power_task_);
+  diagnostic_updater_->add(*system_task_);
+
+  status_node_->start_publishing(STATUS_PUBLISH_RATE);
+
+  RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "Port: %s", serial_port_.c_str());
+  link_down_reported_ = false;
+  if (startup_timeout_ > 0)
+  {
+    horizon_legacy::Handshake handshake = link_.handshake(
+      serial_port_, rx_thread_, max_speed_, max_accel_, startup_identify_, startup_timeout_);
+    double elapsed = std::chrono::duration<double>(handshake.elapsed).count();
+    if (!handshake.ok)
+    {
+      RCLCPP_FATAL(
+        rclcpp::get_logger(HW_NAME),
+        "Husky startup on %s failed waiting for %s after %.2f s (startup_timeout %.2f s)",
+        serial_port_.c_str(), handshake.step, elapsed, startup_timeout_);
+      return hardware_interface::return_type::ERROR;
+    }
+    RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "Husky configured in %.3f s", elapsed);
+    applyTravelOffset(*handshake.encoders);
+    if (handshake.firmware)
+    {
+      RCLCPP_INFO(
+        rclcpp::get_logger(HW_NAME), "Firmware %u.%u, protocol %u.%u",
+        handshake.firmware->getMajorFirmwareVersion(), handshake.firmware->getMinorFirmwareVersion(),
+        handshake.firmware->getMajorProtocolVersion(), handshake.firmware->getMinorProtocolVersion());
+    }
+    if (handshake.platform)
+    {
+      RCLCPP_INFO(
+        rclcpp::get_logger(HW_NAME), "Platform %s revision %u, serial %u",
+        handshake.platform->getModel().c_str(), handshake.platform->getRevision(),
+        handshake.platform->getSerial());
+    }
+  }
+  else
+  {
+    if (!link_.connect(serial_port_, rx_thread_))
+    {
+      RCLCPP_ERROR(
+        rclcpp::get_logger(HW_NAME), "Husky not responding on %s, will keep trying in the background",
+        serial_port_.c_str());
+    }
+    link_.configureLimits(max_speed_, max_accel_);
+    resetTravelOffset();
+  }
+
+  if (streaming_frequency_ > 0)
+  {
+    RCLCPP_INFO(
+      rclcpp::get_logger(HW_NAME), "Streaming encoder and speed data at %.1f Hz",
+      streaming_frequency_);
+    // Subscriptions are restored automatically whenever the link is re-established
+    horizon_legacy::Channel<clearpath::DataEncoders>::subscribe(link_, streaming_frequency_);
+    if (velocity_source_ == VELOCITY_DIFFERENTIAL_SPEED)
+    {
+      horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::subscribe(link_, streaming_frequency_);
+    }
+    last_stream_sample_ = std::chrono::steady_clock::now();
+    stream_stalled_ = false;
+  }
+
+  if (!imu_.empty())
+  {
+    RCLCPP_INFO(
+      rclcpp::get_logger(HW_NAME), "Streaming IMU data for sensor '%s' at %.1f Hz",
+      info_.sensors[0].name.c_str(), imu_rate_);
+    // Only the sources the sensor's interfaces need, each one is a frame per sample on the link
+    if (imu_.uses(ImuState::ORIENTATION))
+    {
+      horizon_legacy::Channel<clearpath::DataPlatformOrientation>::subscribe(link_, imu_rate_);
+    }
+    if (imu_.uses(ImuState::ROTATION))
+    {
+      horizon_legacy::Channel<clearpath::DataPlatformRotation>::subscribe(link_, imu_rate_);
+    }
+    if (imu_.uses(ImuState::ACCELERATION))
+    {
+      horizon_legacy::Channel<clearpath::DataPlatformAcceleration>::subscribe(link_, imu_rate_);
+    }
+    if (imu_.uses(ImuState::MAGNETOMETER))
+    {
+      horizon_legacy::Channel<clearpath::DataPlatformMagnetometer>::subscribe(link_, imu_rate_);
+    }
+  }
+
   status_ = hardware_interface::status::CONFIGURED;
   return hardware_interface::return_type::OK;
 }
@@ -378,6 +903,24 @@ std::vector<hardware_interface::StateInterface> HuskyHardware::export_state_inte
       info_.joints[i].name, hardware_interface::HW_IF_VELOCITY, &hw_states_velocity_[i]));
   }
 
+  // Sample timing, for controllers and estimators that want to compensate for the serial link
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    info_.name, HW_IF_ENCODER_AGE, &hw_encoder_age_));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    info_.name, HW_IF_SPEED_AGE, &hw_speed_age_));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    info_.name, HW_IF_LINK_LATENCY, &hw_link_latency_));
+
+  for (const hardware_interface::ComponentInfo & sensor : info_.sensors)
+  {
+    for (const hardware_interface::InterfaceInfo & state : sensor.state_interfaces)
+    {
+      // Already checked by configure(), this only maps the name to its slot
+      state_interfaces.emplace_back(hardware_interface::StateInterface(
+        sensor.name, state.name, imu_.addInterface(state.name)));
+    }
+  }
+
   return state_interfaces;
 }
 
@@ -421,6 +964,14 @@ hardware_interface::return_type HuskyHardware::start()
     }
   }
 
+  for (auto &estimator : velocity_estimators_)
+  {
+    estimator.reset();
+  }
+  command_shaper_.reset();
+
+  read_scheduler_.reset(RateScheduler::Clock::now());
+
   status_ = hardware_interface::status::STARTED;
 
   RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "System Successfully started!");
@@ -432,6 +983,31 @@ hardware_interface::return_type HuskyHardware::stop()
 {
   RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "Stopping ...please wait...");
 
+  if (streaming_frequency_ > 0)
+  {
+    horizon_legacy::Channel<clearpath::DataEncoders>::unsubscribe(link_);
+    if (velocity_source_ == VELOCITY_DIFFERENTIAL_SPEED)
+    {
+      horizon_legacy::Channel<clearpath::DataDifferentialSpeed>::unsubscribe(link_);
+    }
+  }
+  if (imu_.uses(ImuState::ORIENTATION))
+  {
+    horizon_legacy::Channel<clearpath::DataPlatformOrientation>::unsubscribe(link_);
+  }
+  if (imu_.uses(ImuState::ROTATION))
+  {
+    horizon_legacy::Channel<clearpath::DataPlatformRotation>::unsubscribe(link_);
+  }
+  if (imu_.uses(ImuState::ACCELERATION))
+  {
+    horizon_legacy::Channel<clearpath::DataPlatformAcceleration>::unsubscribe(link_);
+  }
+  if (imu_.uses(ImuState::MAGNETOMETER))
+  {
+    horizon_legacy::Channel<clearpath::DataPlatformMagnetometer>::unsubscribe(link_);
+  }
+
   status_ = hardware_interface::status::STOPPED;
 
   RCLCPP_INFO(rclcpp::get_logger(HW_NAME), "System successfully stopped!");
@@ -441,22 +1017,39 @@ hardware_interface::return_type HuskyHardware::stop()
 
 hardware_interface::return_type HuskyHardware::read()
 {
-  RCLCPP_DEBUG(rclcpp::get_logger(HW_NAME), "Reading from hardware");
+  clearpath::LatencyHistogram::Scope timed(read_latency_);
+  CPR_ALOG(clearpath::Logger::DETAIL, "Reading from hardware");
+
+  auto now = std::chrono::steady_clock::now();
+  if (last_read_.time_since_epoch().count() != 0 && now > last_read_)
+  {
+    double frequency = 1.0 / std::chrono::duration<double>(now - last_read_).count();
+    software_task_->updateControlFrequency(frequency);
+    status_msg_.ros_control_loop_freq = frequency;
+  }
+  last_read_ = now;
 
-  updateJointsFromHardware();
+  if (!checkLink())
+  {
+    // Joint states keep their last known values until the link is back
+    return hardware_interface::return_type::ERROR;
+  }
 
-  RCLCPP_DEBUG(rclcpp::get_logger(HW_NAME), "Joints successfully read!");
+  uint32_t groups = read_scheduler_.due(RateScheduler::Clock::now());
 
-  // This will run at 10Hz but status data is only needed at 1Hz.
-  static int i = 0;
-  if (i <= 10)
+  updateJointsFromHardware(groups);
+  updateSampleAges();
+  if (!imu_.empty())
   {
-    i++;
+    readImu();
   }
-  else
+
+  CPR_ALOG(clearpath::Logger::DETAIL, "Joints successfully read!");
+
+  // At most one of the status groups is due on any tick, see RateScheduler
+  if (groups & ((1u << RateScheduler::SAFETY) | (1u << RateScheduler::POWER) | (1u << RateScheduler::SYSTEM)))
   {
-    readStatusFromHardware();
-    i = 0;
+    readStatusFromHardware(groups);
   }
 
   return hardware_interface::return_type::OK;
@@ -464,11 +1057,18 @@ hardware_interface::return_type HuskyHardware::read()
 
 hardware_interface::return_type HuskyHardware::write()
 {
-  RCLCPP_DEBUG(rclcpp::get_logger(HW_NAME), "Writing to hardware");
+  clearpath::LatencyHistogram::Scope timed(write_latency_);
+  CPR_ALOG(clearpath::Logger::DETAIL, "Writing to hardware");
+
+  if (!checkLink())
+  {
+    // Commands are dropped rather than queued, the MCU's own command timeout stops the wheels
+    return hardware_interface::return_type::ERROR;
+  }
 
   writeCommandsToHardware();
 
-  RCLCPP_DEBUG(rclcpp::get_logger(HW_NAME), "Joints successfully written!");
+  CPR_ALOG(clearpath::Logger::DETAIL, "Joints successfully written!");
 
   return hardware_interface::return_type::OK;
 }
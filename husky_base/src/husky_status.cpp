@@ -29,9 +29,10 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 /**
  * @brief Construct a new HuskyStatus object
  * 
+ * @param options Node options, intra-process by default so local subscribers get the message without a copy
  */
-husky_status::HuskyStatus::HuskyStatus()
-: Node("husky_status_node")
+husky_status::HuskyStatus::HuskyStatus(const rclcpp::NodeOptions & options)
+: Node("husky_status_node", options)
 {
   pub_status_= create_publisher<husky_msgs::msg::HuskyStatus>(
     "status",
@@ -40,11 +41,98 @@ husky_status::HuskyStatus::HuskyStatus()
 
 
 /**
- * @brief Publish Husky Status message
+ * @brief Destroy the HuskyStatus object, joining the executor thread
+ * 
+ */
+husky_status::HuskyStatus::~HuskyStatus()
+{
+  stop_publishing();
+}
+
+
+/**
+ * @brief Start draining the mailbox from a dedicated executor thread
+ * 
+ * @param rate Rate in hz at which the mailbox is checked for new status
+ */
+void husky_status::HuskyStatus::start_publishing(double rate)
+{
+  if (executor_thread_.joinable())
+  {
+    return;
+  }
+
+  publish_timer_ = create_wall_timer(
+    std::chrono::duration<double>(1.0 / rate),
+    [this]() { publish_pending(); });
+
+  executor_.add_node(get_node_base_interface());
+  executor_thread_ = std::thread([this]() { executor_.spin(); });
+}
+
+
+/**
+ * @brief Stop the executor thread, anything still in the mailbox is dropped
+ * 
+ */
+void husky_status::HuskyStatus::stop_publishing()
+{
+  if (!executor_thread_.joinable())
+  {
+    return;
+  }
+
+  executor_.cancel();
+  executor_thread_.join();
+  executor_.remove_node(get_node_base_interface());
+  publish_timer_.reset();
+}
+
+
+/**
+ * @brief Post Husky Status message for publishing, never blocks on the middleware
+ * 
+ * @param status_msg Message to publish
+ */
+void husky_status::HuskyStatus::post_status(const husky_msgs::msg::HuskyStatus & status_msg)
+{
+  mailbox_.write(status_msg);
+}
+
+
+/**
+ * @brief Publish Husky Status message from the calling thread
  * 
  * @param status_msg Message to publish
  */
-void husky_status::HuskyStatus::publish_status(husky_msgs::msg::HuskyStatus status_msg)
+void husky_status::HuskyStatus::publish_status(const husky_msgs::msg::HuskyStatus & status_msg)
 {
   pub_status_->publish(status_msg);
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Publish the latest posted status, if any, from the executor thread
+ * 
+ */
+void husky_status::HuskyStatus::publish_pending()
+{
+  const husky_msgs::msg::HuskyStatus * status_msg = mailbox_.take();
+  if (status_msg == nullptr)
+  {
+    return;
+  }
+
+  if (pub_status_->can_loan_messages())
+  {
+    // Zero-copy, the middleware owns the buffer
+    auto loaned_msg = pub_status_->borrow_loaned_message();
+    loaned_msg.get() = *status_msg;
+    pub_status_->publish(std::move(loaned_msg));
+  }
+  else
+  {
+    // A unique_ptr is handed straight to intra-process subscribers
+    pub_status_->publish(std::make_unique<husky_msgs::msg::HuskyStatus>(*status_msg));
+  }
+}
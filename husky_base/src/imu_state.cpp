@@ -0,0 +1,115 @@
+/**
+Software License Agreement (BSD)
+
+\file      imu_state.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "husky_base/imu_state.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  const double STANDARD_GRAVITY = 9.80665;
+}
+
+namespace husky_base
+{
+
+  ImuState::ImuState() :
+      sources_(0)
+  {
+    for (auto &value : values_)
+    {
+      value = std::numeric_limits<double>::quiet_NaN();
+    }
+  }
+
+  double *ImuState::addInterface(const std::string &name)
+  {
+    static const struct
+    {
+      const char *name;
+      Field field;
+      Source source;
+    } INTERFACES[] = {
+      {"orientation.x", ORIENTATION_X, ORIENTATION},
+      {"orientation.y", ORIENTATION_Y, ORIENTATION},
+      {"orientation.z", ORIENTATION_Z, ORIENTATION},
+      {"orientation.w", ORIENTATION_W, ORIENTATION},
+      {"angular_velocity.x", ANGULAR_VELOCITY_X, ROTATION},
+      {"angular_velocity.y", ANGULAR_VELOCITY_Y, ROTATION},
+      {"angular_velocity.z", ANGULAR_VELOCITY_Z, ROTATION},
+      {"linear_acceleration.x", LINEAR_ACCELERATION_X, ACCELERATION},
+      {"linear_acceleration.y", LINEAR_ACCELERATION_Y, ACCELERATION},
+      {"linear_acceleration.z", LINEAR_ACCELERATION_Z, ACCELERATION},
+      {"magnetic_field.x", MAGNETIC_FIELD_X, MAGNETOMETER},
+      {"magnetic_field.y", MAGNETIC_FIELD_Y, MAGNETOMETER},
+      {"magnetic_field.z", MAGNETIC_FIELD_Z, MAGNETOMETER},
+    };
+
+    for (const auto &entry : INTERFACES)
+    {
+      if (name == entry.name)
+      {
+        sources_ |= 1u << entry.source;
+        return &values_[entry.field];
+      }
+    }
+    return nullptr;
+  }
+
+  void ImuState::setOrientation(double roll, double pitch, double yaw)
+  {
+    // Fixed axis roll, pitch, yaw, as tf2::Quaternion::setRPY() does it
+    double cr = std::cos(roll / 2), sr = std::sin(roll / 2);
+    double cp = std::cos(pitch / 2), sp = std::sin(pitch / 2);
+    double cy = std::cos(yaw / 2), sy = std::sin(yaw / 2);
+    values_[ORIENTATION_X] = sr * cp * cy - cr * sp * sy;
+    values_[ORIENTATION_Y] = cr * sp * cy + sr * cp * sy;
+    values_[ORIENTATION_Z] = cr * cp * sy - sr * sp * cy;
+    values_[ORIENTATION_W] = cr * cp * cy + sr * sp * sy;
+  }
+
+  void ImuState::setRotation(double roll_rate, double pitch_rate, double yaw_rate)
+  {
+    values_[ANGULAR_VELOCITY_X] = roll_rate;
+    values_[ANGULAR_VELOCITY_Y] = pitch_rate;
+    values_[ANGULAR_VELOCITY_Z] = yaw_rate;
+  }
+
+  void ImuState::setAcceleration(double x, double y, double z)
+  {
+    values_[LINEAR_ACCELERATION_X] = x * STANDARD_GRAVITY;
+    values_[LINEAR_ACCELERATION_Y] = y * STANDARD_GRAVITY;
+    values_[LINEAR_ACCELERATION_Z] = z * STANDARD_GRAVITY;
+  }
+
+  void ImuState::setMagnetometer(double x, double y, double z)
+  {
+    values_[MAGNETIC_FIELD_X] = x;
+    values_[MAGNETIC_FIELD_Y] = y;
+    values_[MAGNETIC_FIELD_Z] = z;
+  }
+
+}  // namespace husky_base
@@ -0,0 +1,128 @@
+/**
+Software License Agreement (BSD)
+
+\file      rate_scheduler.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "husky_base/rate_scheduler.hpp"
+
+namespace husky_base
+{
+
+  RateScheduler::RateScheduler()
+  {
+    for (auto &entry : groups_)
+    {
+      entry.period = Clock::duration::zero();
+      entry.exclusive = false;
+      entry.next_due = Clock::time_point();
+    }
+  }
+
+  void RateScheduler::setRate(Group group, double rate, bool exclusive)
+  {
+    Entry &entry = groups_[group];
+    entry.exclusive = exclusive;
+    if (rate > 0)
+    {
+      entry.period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    }
+    else
+    {
+      entry.period = Clock::duration::zero();
+    }
+  }
+
+  void RateScheduler::reset(Clock::time_point now)
+  {
+    int num_exclusive = 0;
+    for (const auto &entry : groups_)
+    {
+      if (entry.exclusive && entry.period > Clock::duration::zero())
+      {
+        num_exclusive++;
+      }
+    }
+
+    // Give the k-th exclusive group a phase of k/n of its period, so equal rates interleave
+    int k = 0;
+    for (auto &entry : groups_)
+    {
+      if (entry.exclusive && entry.period > Clock::duration::zero())
+      {
+        entry.next_due = now + entry.period * k / num_exclusive;
+        k++;
+      }
+      else
+      {
+        entry.next_due = now;
+      }
+    }
+  }
+
+  uint32_t RateScheduler::due(Clock::time_point now)
+  {
+    uint32_t mask = 0;
+    int exclusive = -1;
+
+    for (int g = 0; g < NUM_GROUPS; g++)
+    {
+      Entry &entry = groups_[g];
+      if (entry.period == Clock::duration::zero())
+      {
+        mask |= 1u << g;
+      }
+      else if (now >= entry.next_due)
+      {
+        if (!entry.exclusive)
+        {
+          mask |= 1u << g;
+          advance(entry, now);
+        }
+        else if (exclusive < 0 || entry.next_due < groups_[exclusive].next_due)
+        {
+          // Most overdue exclusive group wins, the rest wait for a later tick
+          exclusive = g;
+        }
+      }
+    }
+
+    if (exclusive >= 0)
+    {
+      mask |= 1u << exclusive;
+      advance(groups_[exclusive], now);
+    }
+
+    return mask;
+  }
+
+  void RateScheduler::advance(Entry &entry, Clock::time_point now)
+  {
+    entry.next_due += entry.period;
+    if (entry.next_due <= now)
+    {
+      // Fell more than a period behind, don't try to catch up in a burst
+      entry.next_due = now + entry.period;
+    }
+  }
+
+}  // namespace husky_base
@@ -0,0 +1,109 @@
+/**
+Software License Agreement (BSD)
+
+\file      velocity_estimator.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2023, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+
+#include "husky_base/velocity_estimator.hpp"
+
+namespace
+{
+  // Longer than this between samples, e.g. a link outage, and the history says nothing about now
+  const double MAX_GAP = 0.5;
+}
+
+namespace husky_base
+{
+
+  const size_t VelocityEstimator::MAX_WINDOW;
+
+  VelocityEstimator::VelocityEstimator() :
+      filter_(FINITE_DIFFERENCE), window_(1), alpha_(0.5), beta_(0.1)
+  {
+    reset();
+  }
+
+  void VelocityEstimator::configure(Filter filter, size_t window, double alpha, double beta)
+  {
+    filter_ = filter;
+    window_ = std::min(std::max<size_t>(window, 1), MAX_WINDOW);
+    alpha_ = std::min(std::max(alpha, 0.0), 1.0);
+    beta_ = std::min(std::max(beta, 0.0), 2.0);
+    reset();
+  }
+
+  void VelocityEstimator::reset()
+  {
+    count_ = 0;
+    next_ = 0;
+    position_ = 0.0;
+    velocity_ = 0.0;
+  }
+
+  double VelocityEstimator::update(double position, double stamp)
+  {
+    size_t last = (next_ + MAX_WINDOW) % (MAX_WINDOW + 1);
+    if (count_ > 0)
+    {
+      double dt = stamp - stamps_[last];
+      if (dt <= 0.0)
+      {
+        return velocity_;
+      }
+      if (dt > MAX_GAP)
+      {
+        reset();
+      }
+    }
+
+    if (filter_ == ALPHA_BETA && count_ > 0)
+    {
+      double dt = stamp - stamps_[last];
+      double predicted = position_ + velocity_ * dt;
+      double residual = position - predicted;
+      position_ = predicted + alpha_ * residual;
+      velocity_ += beta_ / dt * residual;
+    }
+    else if (filter_ == ALPHA_BETA)
+    {
+      position_ = position;
+    }
+
+    positions_[next_] = position;
+    stamps_[next_] = stamp;
+    next_ = (next_ + 1) % (MAX_WINDOW + 1);
+    count_ = std::min(count_ + 1, MAX_WINDOW + 1);
+
+    if (filter_ == FINITE_DIFFERENCE && count_ > 1)
+    {
+      // Across as much of the window as has been filled
+      size_t span = std::min(count_ - 1, window_);
+      size_t newest = (next_ + MAX_WINDOW) % (MAX_WINDOW + 1);
+      size_t oldest = (newest + MAX_WINDOW + 1 - span) % (MAX_WINDOW + 1);
+      velocity_ = (positions_[newest] - positions_[oldest]) / (stamps_[newest] - stamps_[oldest]);
+    }
+    return velocity_;
+  }
+
+}  // namespace husky_base
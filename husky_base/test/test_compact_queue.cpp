@@ -0,0 +1,177 @@
+/**
+Software License Agreement (BSD)
+
+\file      test_compact_queue.cpp
+\authors   Clearpath Robotics <code@clearpathrobotics.com>
+\copyright Copyright (c) 2026, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Compact receive queues (Transport::setQueueBytes()) at their smallest size.
+ *
+ * Encoder frames of every length are pushed through a pseudo-terminal into a
+ * ring that only holds one to three of them, so it wraps with anything from 8
+ * bytes to a whole record left over at the end. Run under AddressSanitizer to
+ * catch writes past the ring.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "husky_base/horizon_legacy/clearpath.h"
+
+namespace
+{
+
+  struct PtyLink
+  {
+    int master;
+    int slave;
+    char name[64];
+
+    PtyLink()
+    {
+      if (openpty(&master, &slave, name, NULL, NULL) != 0)
+      {
+        master = slave = -1;
+        return;
+      }
+      struct termios tio;
+      tcgetattr(slave, &tio);
+      cfmakeraw(&tio);
+      tcsetattr(slave, TCSANOW, &tio);
+    }
+
+    ~PtyLink()
+    {
+      if (master >= 0) { close(master); }
+      if (slave >= 0) { close(slave); }
+    }
+
+    /** Write the bytes and wait until all of them are readable on the slave side */
+    void feed(const std::vector<uint8_t> &bytes)
+    {
+      ssize_t written = write(master, bytes.data(), bytes.size());
+      ASSERT_EQ(static_cast<ssize_t>(bytes.size()), written);
+      int avail = 0;
+      while (ioctl(slave, FIONREAD, &avail) == 0 && avail < static_cast<int>(bytes.size()))
+      {
+        usleep(10);
+      }
+    }
+  };
+
+  /** Encoder frame with count wheels, the first travel carrying id */
+  std::vector<uint8_t> encoderFrame(std::mt19937 &rng, uint8_t count, uint32_t id)
+  {
+    std::vector<uint8_t> payload(1 + count * 6);
+    payload[0] = count;
+    for (size_t i = 1; i < payload.size(); ++i)
+    {
+      payload[i] = static_cast<uint8_t>(rng());
+    }
+    memcpy(&payload[1], &id, sizeof(id));
+    clearpath::Message msg(clearpath::DataEncoders::getTypeID(), payload.data(), payload.size());
+    uint8_t frame[clearpath::Message::MAX_MSG_LENGTH];
+    size_t len = msg.toBytes(frame, sizeof(frame));
+    return std::vector<uint8_t>(frame, frame + len);
+  }
+
+  std::vector<uint8_t> frameBytes(clearpath::Message *msg)
+  {
+    uint8_t frame[clearpath::Message::MAX_MSG_LENGTH];
+    size_t len = msg->toBytes(frame, sizeof(frame));
+    return std::vector<uint8_t>(frame, frame + len);
+  }
+
+}  // namespace
+
+TEST(CompactQueue, WrapsMixedLengthsInSmallestRing)
+{
+  PtyLink link;
+  ASSERT_GE(link.master, 0) << "openpty failed";
+
+  const enum clearpath::MessageTypes type = clearpath::DataEncoders::getTypeID();
+  // 39 wheels is the longest encoder frame that fits in a Message
+  const uint8_t MAX_COUNT = 39;
+  clearpath::Transport transport;
+  transport.setQueueDepth(type, 100);
+  // Rounded up to the smallest ring that still holds one frame of any length
+  transport.setQueueBytes(type, 1);
+  transport.configure(link.name, 0);
+
+  std::mt19937 rng(27);
+  std::map<std::vector<uint8_t>, uint32_t> sent;
+  uint32_t next_id = 1;
+  uint32_t last_popped = 0;
+
+  for (int round = 0; round < 2000; ++round)
+  {
+    std::vector<uint8_t> bytes;
+    int frames = 1 + rng() % 4;
+    for (int i = 0; i < frames; ++i)
+    {
+      std::vector<uint8_t> frame = encoderFrame(rng, 1 + rng() % MAX_COUNT, next_id);
+      ASSERT_FALSE(frame.empty());
+      bytes.insert(bytes.end(), frame.begin(), frame.end());
+      sent[frame] = next_id++;
+    }
+    link.feed(bytes);
+    transport.poll();
+
+    // Leave some behind, so the ring wraps with records still queued
+    int pops = (round % 50 == 49) ? 100 : static_cast<int>(rng() % 3);
+    for (int i = 0; i < pops; ++i)
+    {
+      clearpath::Message *msg = transport.popNext(type);
+      if (!msg) { break; }
+      // Byte for byte one of the frames sent, and newer than the last one popped
+      auto it = sent.find(frameBytes(msg));
+      ASSERT_TRUE(it != sent.end()) << "frame corrupted in the ring";
+      ASSERT_GT(it->second, last_popped) << "frames out of order";
+      last_popped = it->second;
+      delete msg;
+    }
+  }
+
+  // The newest frame is never the one dropped
+  transport.poll();
+  clearpath::Message *msg;
+  while ((msg = transport.popNext(type)) != NULL)
+  {
+    auto it = sent.find(frameBytes(msg));
+    ASSERT_TRUE(it != sent.end()) << "frame corrupted in the ring";
+    last_popped = it->second;
+    delete msg;
+  }
+  EXPECT_EQ(next_id - 1, last_popped);
+  EXPECT_GT(transport.getCounter(clearpath::Transport::QUEUE_FULL), 0u);
+  transport.close();
+}